@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * CRC-32 and CRC-32C using the ARMv8 CRC32 and PMULL instructions, if the
+ * CPU has them
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <asm/system.h>
+#include <u-boot/crc.h>
+
+/* Shorter buffers are not worth folding */
+#define PMULL_MIN_LEN	64
+
+uint32_t crc32_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+uint32_t crc32c_armv8_le(uint32_t crc, const uint8_t *p, size_t len);
+uint32_t crc32_pmull_le(uint32_t crc, const uint8_t *p, size_t len);
+uint32_t crc32c_pmull_le(uint32_t crc, const uint8_t *p, size_t len);
+
+/* The caller has checked for the CRC32 instructions */
+static uint32_t __efi_runtime crc32_ce(uint32_t crc, const uint8_t *buf,
+				       size_t len, bool castagnoli)
+{
+	size_t head, blocks;
+
+	if (len >= PMULL_MIN_LEN + 15 &&
+	    ID_AA64ISAR0_AES(read_id_aa64isar0()) >= 2) {
+		/* PMULL loads 64 bytes at a time, so align the data first */
+		head = -(unsigned long)buf & 15;
+		blocks = (len - head) & ~63;
+		if (castagnoli) {
+			crc = crc32c_armv8_le(crc, buf, head);
+			crc = crc32c_pmull_le(crc, buf + head, blocks);
+		} else {
+			crc = crc32_armv8_le(crc, buf, head);
+			crc = crc32_pmull_le(crc, buf + head, blocks);
+		}
+		buf += head + blocks;
+		len -= head + blocks;
+	}
+
+	if (castagnoli)
+		return crc32c_armv8_le(crc, buf, len);
+	return crc32_armv8_le(crc, buf, len);
+}
+
+uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const unsigned char *buf,
+				     uint len)
+{
+	if (!ID_AA64ISAR0_CRC32(read_id_aa64isar0()))
+		return crc32_no_comp_generic(crc, buf, len);
+
+	return crc32_ce(crc, buf, len, false);
+}
+
+#ifdef CONFIG_CRC32C
+uint32_t crc32c_no_comp(uint32_t crc, const void *buf, uint len)
+{
+	if (!ID_AA64ISAR0_CRC32(read_id_aa64isar0()))
+		return crc32c_no_comp_generic(crc, buf, len);
+
+	return crc32_ce(crc, buf, len, true);
+}
+#endif
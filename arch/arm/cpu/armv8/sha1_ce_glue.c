@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-1 using the ARMv8 Crypto Extensions, if the CPU has them
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha1.h>
+
+void sha1_ce_transform(uint32_t state[5], const unsigned char *data,
+		       unsigned int blocks);
+
+void sha1_process(sha1_context *ctx, const unsigned char *data,
+		  unsigned int blocks)
+{
+	uint32_t state[5];
+	int i;
+
+	if (!blocks)
+		return;
+
+	if (!ID_AA64ISAR0_SHA1(read_id_aa64isar0())) {
+		sha1_process_generic(ctx, data, blocks);
+		return;
+	}
+
+	/* the context keeps the state in longs, which are 64-bit here */
+	for (i = 0; i < 5; i++)
+		state[i] = ctx->state[i];
+	sha1_ce_transform(state, data, blocks);
+	for (i = 0; i < 5; i++)
+		ctx->state[i] = state[i];
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * SHA-256 using the ARMv8 Crypto Extensions, if the CPU has them
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha256.h>
+
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 unsigned int blocks);
+
+void sha256_process(sha256_context *ctx, const uint8_t *data,
+		    unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (ID_AA64ISAR0_SHA2(read_id_aa64isar0()))
+		sha256_ce_transform(ctx->state, data, blocks);
+	else
+		sha256_process_generic(ctx, data, blocks);
+}
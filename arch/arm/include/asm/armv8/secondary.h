@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Starting secondary CPUs to run a function in U-Boot
+ */
+
+#ifndef __ASM_ARMV8_SECONDARY_H
+#define __ASM_ARMV8_SECONDARY_H
+
+/* Offsets into struct secondary_boot, for secondary_entry() */
+#define SECONDARY_BOOT_SP	0x00
+#define SECONDARY_BOOT_GD	0x08
+#define SECONDARY_BOOT_VBAR	0x10
+#define SECONDARY_BOOT_MAIR	0x18
+#define SECONDARY_BOOT_TCR	0x20
+#define SECONDARY_BOOT_TTBR	0x28
+#define SECONDARY_BOOT_SCTLR	0x30
+#define SECONDARY_BOOT_FUNC	0x38
+#define SECONDARY_BOOT_ARG	0x40
+
+#ifndef __ASSEMBLY__
+
+#include <linux/types.h>
+
+/**
+ * struct secondary_boot - state for a secondary CPU entering U-Boot
+ *
+ * This is read by the secondary CPU before its MMU is on, so it must be
+ * flushed from the cache after it is filled in.
+ *
+ * @sp:		Initial stack pointer
+ * @gd:		Global data pointer, kept in x18
+ * @vbar:	Exception vector base address
+ * @mair:	Memory attributes, as used by the boot CPU
+ * @tcr:	Translation control, as used by the boot CPU
+ * @ttbr:	Translation table base, as used by the boot CPU
+ * @sctlr:	System control, with the MMU and caches on
+ * @func:	Function to call once the MMU is on. It must not return.
+ * @arg:	Argument to pass to @func
+ */
+struct secondary_boot {
+	u64 sp;
+	u64 gd;
+	u64 vbar;
+	u64 mair;
+	u64 tcr;
+	u64 ttbr;
+	u64 sctlr;
+	u64 func;
+	u64 arg;
+};
+
+/**
+ * secondary_entry() - Entry point for a secondary CPU
+ *
+ * This is started in EL2 or EL1, at the level U-Boot runs at, with the MMU
+ * off and x0 pointing to a struct secondary_boot. It sets up the MMU in the
+ * same way as on the boot CPU, then calls the function.
+ */
+void secondary_entry(void);
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* __ASM_ARMV8_SECONDARY_H */
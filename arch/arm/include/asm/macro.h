@@ -77,6 +77,24 @@ lr	.req	x30
 	b.eq	\el1_label
 .endm
 
+/*
+ * Branch if the MMU is off at the current exception level. All accesses are
+ * then to Device memory, where unaligned ones fault.
+ */
+.macro	branch_if_mmu_off, xreg, label
+	switch_el \xreg, .Lmmu_el3\@, .Lmmu_el2\@, .Lmmu_el1\@
+.Lmmu_el1\@:
+	mrs	\xreg, sctlr_el1
+	b	.Lmmu_sctlr\@
+.Lmmu_el2\@:
+	mrs	\xreg, sctlr_el2
+	b	.Lmmu_sctlr\@
+.Lmmu_el3\@:
+	mrs	\xreg, sctlr_el3
+.Lmmu_sctlr\@:
+	tbz	\xreg, #0, \label	/* SCTLR_ELx.M */
+.endm
+
 /*
  * Branch if current processor is a Cortex-A57 core.
  */
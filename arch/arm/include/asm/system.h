@@ -176,6 +176,21 @@ static inline unsigned long read_mpidr(void)
 	return val;
 }
 
+static inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return val;
+}
+
+/* Fields of ID_AA64ISAR0_EL1, which lists the optional instructions */
+#define ID_AA64ISAR0_AES(isar)		(((isar) >> 4) & 0xf)	/* 2: PMULL */
+#define ID_AA64ISAR0_SHA1(isar)		(((isar) >> 8) & 0xf)
+#define ID_AA64ISAR0_SHA2(isar)		(((isar) >> 12) & 0xf)
+#define ID_AA64ISAR0_CRC32(isar)	(((isar) >> 16) & 0xf)
+
 #define BSP_COREID	0
 
 void __asm_flush_dcache_all(void);
@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -775,6 +776,41 @@ void os_localtime(struct rtc_time *rt)
 	rt->tm_isdst = tm->tm_isdst;
 }
 
+struct os_thread {
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static void *os_thread_entry(void *ctx)
+{
+	struct os_thread thread = *(struct os_thread *)ctx;
+
+	os_free(ctx);
+	thread.func(thread.arg);
+
+	return NULL;
+}
+
+int os_thread_create(void (*func)(void *arg), void *arg)
+{
+	struct os_thread *thread;
+	pthread_t id;
+
+	/* os_malloc() rather than malloc(), which is not thread-safe */
+	thread = os_malloc(sizeof(*thread));
+	if (!thread)
+		return -ENOMEM;
+	thread->func = func;
+	thread->arg = arg;
+	if (pthread_create(&id, NULL, os_thread_entry, thread)) {
+		os_free(thread);
+		return -EAGAIN;
+	}
+	pthread_detach(id);
+
+	return 0;
+}
+
 void os_abort(void)
 {
 	abort();
@@ -75,9 +75,10 @@ typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *pkt,
  * fake_host_hwaddr - MAC address of mocked machine
  * fake_host_ipaddr - IP address of mocked machine
  * disabled - Will not respond
- * recv_packet_buffer - buffers of the packet returned as received
- * recv_packet_length - lengths of the packet returned as received
- * recv_packets - number of packets returned
+ * recv_packet_buffer - ring of buffers of the packets returned as received
+ * recv_packet_length - lengths of the packets returned as received
+ * recv_packet_head - index of the oldest packet in the ring
+ * recv_packets - number of packets waiting in the ring
  * tx_handler - function to generate responses to sent packets
  * priv - a pointer to some structure a test may want to keep track of
  */
@@ -87,6 +88,7 @@ struct eth_sandbox_priv {
 	bool disabled;
 	uchar * recv_packet_buffer[PKTBUFSRX];
 	int recv_packet_length[PKTBUFSRX];
+	int recv_packet_head;
 	int recv_packets;
 	sandbox_eth_tx_hand_f *tx_handler;
 	void *priv;
@@ -224,4 +224,37 @@ uint sandbox_pci_read_bar(u32 barval, int type, uint size);
  */
 void sandbox_set_enable_memio(bool enable);
 
+/**
+ * sandbox_virtio_blk_get_notify_count() - Get the number of queue kicks
+ *
+ * @dev: virtio-sandbox-blk transport device
+ * @return number of times the driver has notified the device
+ */
+int sandbox_virtio_blk_get_notify_count(struct udevice *dev);
+
+/**
+ * sandbox_virtio_net_rx() - Receive a packet on a virtio-sandbox-net device
+ *
+ * The packet is written to as many of the buffers in the receive queue as it
+ * needs, with a header holding @flags.
+ *
+ * @dev: virtio-sandbox-net transport device
+ * @packet: Packet to receive
+ * @len: Length of the packet in bytes
+ * @flags: VIRTIO_NET_HDR_F_... flags for the header
+ * @return 0 if OK, -ENOSPC if there are not enough buffers
+ */
+int sandbox_virtio_net_rx(struct udevice *dev, const void *packet, int len,
+			  u8 flags);
+
+/**
+ * sandbox_cpu_set_stuck() - Make secondary CPUs fail to start
+ *
+ * While stuck, starting a CPU succeeds but nothing runs. When it is
+ * unstuck, the last function it was given starts, as a late CPU would.
+ *
+ * @stuck: true to stop CPUs starting, false to let them go
+ */
+void sandbox_cpu_set_stuck(bool stuck);
+
 #endif
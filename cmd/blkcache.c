@@ -13,15 +13,26 @@ static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+	struct block_cache_dev_stats dev_stats;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache entries: %u\n"
+	       "entries/set: %u\n",
+	       stats.hits, stats.misses, stats.evictions, stats.entries,
+	       stats.max_blocks_per_entry, stats.max_entries, stats.ways);
+
+	for (i = 0; !blkcache_dev_stats(i, &dev_stats); i++)
+		printf("%s %d: hits %u, misses %u, evictions %u, entries %u\n",
+		       blk_get_if_type_name(dev_stats.iftype), dev_stats.devnum,
+		       dev_stats.hits, dev_stats.misses, dev_stats.evictions,
+		       dev_stats.entries);
 	return 0;
 }
 
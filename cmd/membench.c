@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * membench - measure the speed of memcpy(), memmove() and memset()
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <malloc.h>
+#include <div64.h>
+#include <time.h>
+#include <linux/sizes.h>
+
+#define MEMBENCH_MAX_SIZE	SZ_1M
+/* Gap between the buffers, leaving room for the unaligned copies */
+#define MEMBENCH_GAP		64
+/* Time spent on each measurement */
+#define MEMBENCH_US		100000
+/* Calls between looking at the timer */
+#define MEMBENCH_CALLS		16
+
+enum membench_op {
+	MEMBENCH_MEMCPY,
+	MEMBENCH_MEMCPY_UNALIGNED,
+	MEMBENCH_MEMMOVE,
+	MEMBENCH_MEMSET,
+
+	MEMBENCH_OP_COUNT,
+};
+
+static const char *const membench_names[MEMBENCH_OP_COUNT] = {
+	"memcpy", "memcpy+1", "memmove", "memset",
+};
+
+static const ulong membench_sizes[] = {
+	16, 64, 256, SZ_1K, SZ_4K, SZ_64K, SZ_1M,
+};
+
+/* Return the speed of @op on @size bytes in MB/s */
+static ulong membench_run(enum membench_op op, u8 *dst, u8 *src, ulong size)
+{
+	ulong start, elapsed;
+	u64 bytes = 0;
+	int i;
+
+	start = timer_get_us();
+	do {
+		for (i = 0; i < MEMBENCH_CALLS; i++) {
+			switch (op) {
+			case MEMBENCH_MEMCPY:
+				memcpy(dst, src, size);
+				break;
+			case MEMBENCH_MEMCPY_UNALIGNED:
+				memcpy(dst, src + 1, size);
+				break;
+			case MEMBENCH_MEMMOVE:
+				/* overlapping, so copying downwards */
+				memmove(src + 1, src, size);
+				break;
+			default:
+				memset(dst, i, size);
+				break;
+			}
+		}
+		bytes += MEMBENCH_CALLS * size;
+		elapsed = timer_get_us() - start;
+	} while (elapsed < MEMBENCH_US);
+
+	/* a byte per microsecond is a MB/s */
+	return lldiv(bytes, elapsed);
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	u8 *dst, *src;
+	int i, op;
+
+	dst = malloc(2 * MEMBENCH_MAX_SIZE + 2 * MEMBENCH_GAP);
+	if (!dst) {
+		printf("Cannot allocate the buffers\n");
+		return CMD_RET_FAILURE;
+	}
+	src = dst + MEMBENCH_MAX_SIZE + MEMBENCH_GAP;
+	memset(src, 0x55, MEMBENCH_MAX_SIZE + 1);
+
+	printf("%8s", "bytes");
+	for (op = 0; op < MEMBENCH_OP_COUNT; op++)
+		printf("%10s", membench_names[op]);
+	printf("  (MB/s)\n");
+
+	for (i = 0; i < ARRAY_SIZE(membench_sizes); i++) {
+		printf("%8lu", membench_sizes[i]);
+		for (op = 0; op < MEMBENCH_OP_COUNT; op++) {
+			printf("%10lu", membench_run(op, dst, src,
+						     membench_sizes[i]));
+			if (ctrlc())
+				break;
+		}
+		printf("\n");
+		if (op < MEMBENCH_OP_COUNT)
+			break;
+	}
+	free(dst);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	membench,	1,	0,	do_membench,
+	"measure the speed of memcpy(), memmove() and memset()",
+	"\n"
+	"    - copy and fill areas of 16 bytes up to 1MiB for 0.1s each,\n"
+	"      printing the speed for each size"
+);
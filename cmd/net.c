@@ -9,6 +9,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dm.h>
 #include <env.h>
 #include <net.h>
 
@@ -458,3 +459,39 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_ETHSTATS)
+static int do_ethstats(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct eth_rx_stats stats;
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_ETH, &uc);
+	if (ret)
+		return CMD_RET_FAILURE;
+
+	printf("%d receive buffers\n", PKTBUFSRX);
+	uclass_foreach_dev(dev, uc) {
+		if (!device_active(dev))
+			continue;
+		eth_get_rx_stats(dev, &stats);
+		printf("%s: packets %lu, polls %lu, max/poll %lu\n",
+		       dev->name, stats.packets, stats.polls,
+		       stats.max_batch);
+		printf("%*s  ring full %lu, dropped %lu\n",
+		       (int)strlen(dev->name), "", stats.ring_full,
+		       stats.dropped);
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	ethstats,	1,	1,	do_ethstats,
+	"show and reset Ethernet receive statistics",
+	""
+);
+#endif  /* CONFIG_CMD_ETHSTATS */
@@ -216,8 +216,13 @@ static void usb_display_if_desc(struct usb_interface_descriptor *ifdesc,
 	}
 }
 
-static void usb_display_ep_desc(struct usb_endpoint_descriptor *epdesc)
+static void usb_display_ep_desc(struct usb_device *dev,
+				struct usb_endpoint_descriptor *epdesc)
 {
+#ifdef CONFIG_USB_STATS
+	struct usb_ep_stats *stats;
+#endif
+
 	printf("     - Endpoint %d %s ", epdesc->bEndpointAddress & 0xf,
 		(epdesc->bEndpointAddress & 0x80) ? "In" : "Out");
 	switch ((epdesc->bmAttributes & 0x03)) {
@@ -238,6 +243,14 @@ static void usb_display_ep_desc(struct usb_endpoint_descriptor *epdesc)
 	if ((epdesc->bmAttributes & 0x03) == 0x3)
 		printf(" Interval %dms", epdesc->bInterval);
 	printf("\n");
+#ifdef CONFIG_USB_STATS
+	stats = &dev->ep_stats[!(epdesc->bEndpointAddress & 0x80)]
+			      [epdesc->bEndpointAddress & 0xf];
+	if (stats->transfers)
+		printf("       Transfers %lu, Errors %lu, Bytes %llu, Descs %lu\n",
+		       stats->transfers, stats->errors,
+		       (unsigned long long)stats->bytes, stats->descs);
+#endif
 }
 
 /* main routine to diasplay the configs, interfaces and endpoints */
@@ -255,7 +268,7 @@ static void usb_display_config(struct usb_device *dev)
 		usb_display_if_desc(&ifdesc->desc, dev);
 		for (ii = 0; ii < ifdesc->no_of_ep; ii++) {
 			epdesc = &ifdesc->ep_desc[ii];
-			usb_display_ep_desc(epdesc);
+			usb_display_ep_desc(dev, epdesc);
 		}
 	}
 	printf("\n");
@@ -19,6 +19,7 @@
 #include <time.h>
 #include <u-boot/sha256.h>
 #include <bootcount.h>
+#include <dm/root.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -274,6 +275,8 @@ static int abortboot_single_key(int bootdelay)
 					menukey = key;
 				break;
 			}
+			/* Let devices finish starting up while we wait */
+			dm_probe_poll();
 			udelay(10000);
 		} while (!abort && get_timer(ts) < 1000);
 
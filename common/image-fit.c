@@ -18,6 +18,7 @@
 #include <common.h>
 #include <errno.h>
 #include <mapmem.h>
+#include <watchdog.h>
 #include <asm/io.h>
 #include <malloc.h>
 DECLARE_GLOBAL_DATA_PTR;
@@ -30,6 +31,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <u-boot/md5.h>
 #include <u-boot/sha1.h>
 #include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
 
 /*****************************************************************************/
 /* New uImage format routines */
@@ -1150,6 +1152,14 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 		sha256_csum_wd((unsigned char *)data, data_len,
 			       (unsigned char *)value, CHUNKSZ_SHA256);
 		*value_len = SHA256_SUM_LEN;
+	} else if (IMAGE_ENABLE_SHA384 && strcmp(algo, "sha384") == 0) {
+		sha384_csum_wd((unsigned char *)data, data_len,
+			       (unsigned char *)value, CHUNKSZ_SHA384);
+		*value_len = SHA384_SUM_LEN;
+	} else if (IMAGE_ENABLE_SHA512 && strcmp(algo, "sha512") == 0) {
+		sha512_csum_wd((unsigned char *)data, data_len,
+			       (unsigned char *)value, CHUNKSZ_SHA512);
+		*value_len = SHA512_SUM_LEN;
 	} else if (IMAGE_ENABLE_MD5 && strcmp(algo, "md5") == 0) {
 		md5_wd((unsigned char *)data, data_len, value, CHUNKSZ_MD5);
 		*value_len = 16;
@@ -1160,14 +1170,41 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+static int fit_image_check_hash_value(const void *fit, int noffset,
+				      const uint8_t *value, int value_len,
+				      char **err_msgp)
+{
+	uint8_t *fit_value;
+	int fit_value_len;
+
+	if (fit_image_hash_get_value(fit, noffset, &fit_value,
+				     &fit_value_len)) {
+		*err_msgp = "Can't get hash value property";
+		return -1;
+	}
+
+	if (value_len != fit_value_len) {
+		*err_msgp = "Bad hash value len";
+		return -1;
+	} else if (memcmp(value, fit_value, value_len) != 0) {
+		*err_msgp = "Bad hash value";
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Check a hash node. If @hash is not NULL it holds the final value computed
+ * progressively, otherwise the hash of @data is calculated here.
+ */
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
-				size_t size, char **err_msgp)
+				size_t size, struct fit_verify_hash *hash,
+				char **err_msgp)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	int value_len;
 	char *algo;
-	uint8_t *fit_value;
-	int fit_value_len;
 	int ignore;
 
 	*err_msgp = NULL;
@@ -1186,31 +1223,201 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		}
 	}
 
-	if (fit_image_hash_get_value(fit, noffset, &fit_value,
-				     &fit_value_len)) {
-		*err_msgp = "Can't get hash value property";
-		return -1;
-	}
+	if (hash && hash->value_len)
+		return fit_image_check_hash_value(fit, noffset, hash->value,
+						  hash->value_len, err_msgp);
 
 	if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
 	}
 
-	if (value_len != fit_value_len) {
-		*err_msgp = "Bad hash value len";
-		return -1;
-	} else if (memcmp(value, fit_value, value_len) != 0) {
-		*err_msgp = "Bad hash value";
-		return -1;
+	return fit_image_check_hash_value(fit, noffset, value, value_len,
+					  err_msgp);
+}
+
+static int fit_verify_algo(const char *algo)
+{
+	if (IMAGE_ENABLE_CRC32 && !strcmp(algo, "crc32"))
+		return FIT_VERIFY_ALGO_CRC32;
+	else if (IMAGE_ENABLE_SHA1 && !strcmp(algo, "sha1"))
+		return FIT_VERIFY_ALGO_SHA1;
+	else if (IMAGE_ENABLE_SHA256 && !strcmp(algo, "sha256"))
+		return FIT_VERIFY_ALGO_SHA256;
+	else if (IMAGE_ENABLE_SHA384 && !strcmp(algo, "sha384"))
+		return FIT_VERIFY_ALGO_SHA384;
+	else if (IMAGE_ENABLE_SHA512 && !strcmp(algo, "sha512"))
+		return FIT_VERIFY_ALGO_SHA512;
+
+	return FIT_VERIFY_ALGO_NONE;
+}
+
+void fit_image_verify_start(struct fit_verify_ctx *ctx, const void *fit,
+			    int image_noffset)
+{
+	struct fit_verify_hash *hash;
+	int noffset;
+	char *algo;
+
+	memset(ctx, '\0', sizeof(*ctx));
+	ctx->fit = fit;
+	ctx->image_noffset = image_noffset;
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		/* anything else is computed by fit_image_verify_finish() */
+		if (ctx->count == FIT_VERIFY_MAX_HASHES)
+			break;
+		if (fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+
+		hash = &ctx->hash[ctx->count];
+		hash->noffset = noffset;
+		hash->algo = fit_verify_algo(algo);
+		switch (hash->algo) {
+		case FIT_VERIFY_ALGO_CRC32:
+			hash->ctx.crc32 = 0;
+			break;
+#if IMAGE_ENABLE_SHA1
+		case FIT_VERIFY_ALGO_SHA1:
+			sha1_starts(&hash->ctx.sha1);
+			break;
+#endif
+#if IMAGE_ENABLE_SHA256
+		case FIT_VERIFY_ALGO_SHA256:
+			sha256_starts(&hash->ctx.sha256);
+			break;
+#endif
+#if IMAGE_ENABLE_SHA384
+		case FIT_VERIFY_ALGO_SHA384:
+			sha384_starts(&hash->ctx.sha512);
+			break;
+#endif
+#if IMAGE_ENABLE_SHA512
+		case FIT_VERIFY_ALGO_SHA512:
+			sha512_starts(&hash->ctx.sha512);
+			break;
+#endif
+		default:
+			continue;
+		}
+		ctx->count++;
 	}
+}
 
-	return 0;
+void fit_image_verify_update(struct fit_verify_ctx *ctx, const void *buf,
+			     size_t len)
+{
+	struct fit_verify_hash *hash;
+	size_t chunk;
+	int i;
+
+	/*
+	 * Feed every hash a chunk at a time, so that the data is still in
+	 * the cache when the next algorithm reads it
+	 */
+	while (len) {
+		chunk = len < CHUNKSZ ? len : CHUNKSZ;
+		for (i = 0, hash = ctx->hash; i < ctx->count; i++, hash++) {
+			switch (hash->algo) {
+			case FIT_VERIFY_ALGO_CRC32:
+				hash->ctx.crc32 = crc32(hash->ctx.crc32, buf,
+							chunk);
+				break;
+#if IMAGE_ENABLE_SHA1
+			case FIT_VERIFY_ALGO_SHA1:
+				sha1_update(&hash->ctx.sha1, buf, chunk);
+				break;
+#endif
+#if IMAGE_ENABLE_SHA256
+			case FIT_VERIFY_ALGO_SHA256:
+				sha256_update(&hash->ctx.sha256, buf, chunk);
+				break;
+#endif
+#if IMAGE_ENABLE_SHA384 || IMAGE_ENABLE_SHA512
+			case FIT_VERIFY_ALGO_SHA384:
+			case FIT_VERIFY_ALGO_SHA512:
+				sha512_update(&hash->ctx.sha512, buf, chunk);
+				break;
+#endif
+			default:
+				break;
+			}
+		}
+#ifndef USE_HOSTCC
+		WATCHDOG_RESET();
+#endif
+		ctx->done += chunk;
+		buf += chunk;
+		len -= chunk;
+	}
 }
 
-int fit_image_verify_with_data(const void *fit, int image_noffset,
-			       const void *data, size_t size)
+/* Complete the progressive hashes, keeping only their final values */
+static void fit_image_verify_digest(struct fit_verify_ctx *ctx)
 {
+	struct fit_verify_hash *hash;
+	int i;
+
+	for (i = 0, hash = ctx->hash; i < ctx->count; i++, hash++) {
+		if (hash->value_len)
+			continue;
+		switch (hash->algo) {
+		case FIT_VERIFY_ALGO_CRC32:
+			*(uint32_t *)hash->value = cpu_to_uimage(hash->ctx.crc32);
+			hash->value_len = 4;
+			break;
+#if IMAGE_ENABLE_SHA1
+		case FIT_VERIFY_ALGO_SHA1:
+			sha1_finish(&hash->ctx.sha1, hash->value);
+			hash->value_len = 20;
+			break;
+#endif
+#if IMAGE_ENABLE_SHA256
+		case FIT_VERIFY_ALGO_SHA256:
+			sha256_finish(&hash->ctx.sha256, hash->value);
+			hash->value_len = SHA256_SUM_LEN;
+			break;
+#endif
+#if IMAGE_ENABLE_SHA384
+		case FIT_VERIFY_ALGO_SHA384:
+			sha384_finish(&hash->ctx.sha512, hash->value);
+			hash->value_len = SHA384_SUM_LEN;
+			break;
+#endif
+#if IMAGE_ENABLE_SHA512
+		case FIT_VERIFY_ALGO_SHA512:
+			sha512_finish(&hash->ctx.sha512, hash->value);
+			hash->value_len = SHA512_SUM_LEN;
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+}
+
+static struct fit_verify_hash *fit_verify_find(struct fit_verify_ctx *ctx,
+					       int noffset)
+{
+	int i;
+
+	for (i = 0; i < ctx->count; i++)
+		if (ctx->hash[i].noffset == noffset)
+			return &ctx->hash[i];
+
+	return NULL;
+}
+
+int fit_image_verify_finish(struct fit_verify_ctx *ctx, const void *data,
+			    size_t size)
+{
+	const void *fit = ctx->fit;
+	int image_noffset = ctx->image_noffset;
 	int		noffset = 0;
 	char		*err_msg = "";
 	int verify_all = 1;
@@ -1224,6 +1431,12 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		goto error;
 	}
 
+	if (ctx->count && ctx->done != size) {
+		err_msg = "Image data not completely hashed";
+		goto error;
+	}
+	fit_image_verify_digest(ctx);
+
 	/* Process all hash subnodes of the component image node */
 	fdt_for_each_subnode(noffset, fit, image_noffset) {
 		const char *name = fit_get_name(fit, noffset, NULL);
@@ -1236,6 +1449,7 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 		if (!strncmp(name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			if (fit_image_check_hash(fit, noffset, data, size,
+						 fit_verify_find(ctx, noffset),
 						 &err_msg))
 				goto error;
 			puts("+ ");
@@ -1272,6 +1486,22 @@ error:
 	return 0;
 }
 
+int fit_image_verify_with_data(const void *fit, int image_noffset,
+			       const void *data, size_t size)
+{
+#ifdef CONFIG_SPL_BUILD
+	/* over 1 KiB, so keep it off the SPL stack */
+	static struct fit_verify_ctx ctx;
+#else
+	struct fit_verify_ctx ctx;
+#endif
+
+	fit_image_verify_start(&ctx, fit, image_noffset);
+	fit_image_verify_update(&ctx, data, size);
+
+	return fit_image_verify_finish(&ctx, data, size);
+}
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
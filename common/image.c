@@ -19,9 +19,11 @@
 
 #include <rtc.h>
 
+#include <decomp_parallel.h>
 #include <gzip.h>
 #include <image.h>
 #include <lz4.h>
+#include <zstd.h>
 #include <mapmem.h>
 
 #if IMAGE_ENABLE_FIT || IMAGE_ENABLE_OF_LIBFDT
@@ -191,6 +193,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
 	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
+	{	IH_COMP_ZSTD,	"zstd",		"zstd compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -473,11 +476,31 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZ4: {
 		size_t size = unc_len;
 
-		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		ret = -ENOSYS;
+		if (CONFIG_IS_ENABLED(DECOMP_PARALLEL))
+			ret = decomp_parallel(comp, image_buf, image_len,
+					      load_buf, &size);
+		if (ret == -ENOSYS)
+			ret = ulz4fn(image_buf, image_len, load_buf, &size);
 		image_len = size;
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t size = unc_len;
+
+		ret = -ENOSYS;
+		if (CONFIG_IS_ENABLED(DECOMP_PARALLEL))
+			ret = decomp_parallel(comp, image_buf, image_len,
+					      load_buf, &size);
+		if (ret == -ENOSYS)
+			ret = zstd_decompress(image_buf, image_len, load_buf,
+					      &size);
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return -ENOSYS;
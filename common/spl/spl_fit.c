@@ -5,12 +5,16 @@
  */
 
 #include <common.h>
+#include <decomp_stream.h>
 #include <errno.h>
 #include <fpga.h>
 #include <gzip.h>
 #include <image.h>
 #include <linux/libfdt.h>
+#include <malloc.h>
+#include <memalign.h>
 #include <spl.h>
+#include <zstd.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -27,6 +31,12 @@ __weak ulong board_spl_fit_size_align(ulong size)
 	return size;
 }
 
+static bool spl_fit_decomp_enabled(void)
+{
+	return IS_ENABLED(CONFIG_SPL_OS_BOOT) &&
+	       (IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_ZSTD));
+}
+
 /**
  * spl_fit_get_image_name(): By using the matching configuration subnode,
  * retrieve the name of an image, specified by a property name and an index
@@ -153,6 +163,101 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+/* Amount of image data read at a time when hashing or decompressing it */
+#define SPL_FIT_READ_CHUNK	(256 * 1024)
+
+/* Size of a read unit: a block, or a byte for filesystems */
+static int spl_fit_blksz(struct spl_load_info *info)
+{
+	return info->filename ? 1 : info->bl_len;
+}
+
+/* Number of read units in a chunk */
+static int spl_fit_chunk(struct spl_load_info *info)
+{
+	return max(SPL_FIT_READ_CHUNK / spl_fit_blksz(info), 1);
+}
+
+/*
+ * Whether an image can be decompressed while its external data is read.
+ * The whole of the data is needed to check a signature or to post-process
+ * it, so then it is read first and decompressed afterwards.
+ */
+static bool spl_fit_stream_decomp(int image_comp)
+{
+	return CONFIG_IS_ENABLED(DECOMP_STREAM) &&
+	       !IS_ENABLED(CONFIG_SPL_FIT_SIGNATURE) &&
+	       !IS_ENABLED(CONFIG_SPL_FIT_IMAGE_POST_PROCESS) &&
+	       (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_ZSTD);
+}
+
+/**
+ * spl_fit_read_data(): read the external data of an image
+ *
+ * With signature checking enabled the data is read a chunk at a time and
+ * each chunk is hashed while it is still in the cache, so that verifying
+ * the image does not need another pass over it. With a decompression stream
+ * each chunk is decompressed as it is read, so @dst need only hold a chunk.
+ *
+ * @info:	points to information about the device to load data from
+ * @sector:	the first sector (or byte offset for filesystems) to read
+ * @nr_sectors:	number of sectors (or bytes) to read
+ * @dst:	buffer to read into
+ * @vctx:	verification state of the image
+ * @ds:		stream to decompress the image data to, or NULL to just
+ *		read it to @dst
+ * @overhead:	offset of the image data within the first sector
+ * @length:	size of the image data
+ *
+ * Return:	0 on success, -EIO on a read or decompression error
+ */
+static int spl_fit_read_data(struct spl_load_info *info, ulong sector,
+			     int nr_sectors, void *dst,
+			     struct fit_verify_ctx *vctx,
+			     struct decomp_stream *ds, ulong overhead,
+			     size_t length)
+{
+	int blksz = spl_fit_blksz(info);
+	int chunk = spl_fit_chunk(info);
+	ulong pos = 0, start, end;
+	void *buf;
+	int count;
+
+	if (!IS_ENABLED(CONFIG_SPL_FIT_SIGNATURE) && !ds) {
+		if (info->read(info, sector, nr_sectors, dst) != nr_sectors)
+			return -EIO;
+
+		return 0;
+	}
+
+	while (nr_sectors) {
+		count = min(nr_sectors, chunk);
+		buf = ds ? dst : dst + pos;
+		if (info->read(info, sector, count, buf) != count)
+			return -EIO;
+
+		/* use the part of this chunk holding image data */
+		start = max(pos, overhead);
+		end = min(pos + (ulong)count * blksz, overhead + length);
+		if (start < end) {
+#ifdef CONFIG_SPL_FIT_SIGNATURE
+			fit_image_verify_update(vctx, buf + start - pos,
+						end - start);
+#endif
+			if (CONFIG_IS_ENABLED(DECOMP_STREAM) && ds &&
+			    decomp_stream_write(ds, buf + start - pos,
+						end - start))
+				return -EIO;
+		}
+
+		pos += (ulong)count * blksz;
+		sector += count;
+		nr_sectors -= count;
+	}
+
+	return 0;
+}
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -186,16 +291,22 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+	/* over 1 KiB, so keep it off the SPL stack */
+	static __maybe_unused struct fit_verify_ctx vctx;
+	__maybe_unused struct decomp_stream stream;
+	struct decomp_stream *ds = NULL;
+	void *buf = NULL;
+	int ret;
 
 	if (IS_ENABLED(CONFIG_SPL_FPGA_SUPPORT) ||
-	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP))) {
+	    spl_fit_decomp_enabled()) {
 		if (fit_image_get_type(fit, node, &type))
 			puts("Cannot get image type.\n");
 		else
 			debug("%s ", genimg_get_type_name(type));
 	}
 
-	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
+	if (spl_fit_decomp_enabled()) {
 		if (fit_image_get_comp(fit, node, &image_comp))
 			puts("Cannot get image compression format.\n");
 		else
@@ -217,16 +328,46 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
 
-		load_ptr = (load_addr + align_len) & ~align_len;
 		length = len;
 
 		overhead = get_aligned_image_overhead(info, offset);
 		nr_sectors = get_aligned_image_size(info, length, offset);
 
-		if (info->read(info,
-			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
-			return -EIO;
+		load_ptr = (load_addr + align_len) & ~align_len;
+		/* Keep compressed data clear of where it is uncompressed to */
+		if (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_ZSTD) {
+			/* otherwise the data is decompressed after it is read */
+			if (spl_fit_stream_decomp(image_comp) &&
+			    !decomp_stream_start(&stream, image_comp,
+						 (void *)load_addr,
+						 CONFIG_SYS_BOOTM_LEN))
+				ds = &stream;
+
+			/* a stream only needs room for one chunk */
+			size = (ulong)(ds ? min(nr_sectors, spl_fit_chunk(info)) :
+				       nr_sectors) * spl_fit_blksz(info);
+			buf = malloc_cache_aligned(size);
+			if (!buf) {
+				if (ds)
+					decomp_stream_finish(ds, NULL);
+				return -ENOMEM;
+			}
+			load_ptr = (ulong)buf;
+		}
+
+#ifdef CONFIG_SPL_FIT_SIGNATURE
+		fit_image_verify_start(&vctx, fit, node);
+#endif
+		ret = spl_fit_read_data(info,
+					sector + get_aligned_image_offset(info,
+									  offset),
+					nr_sectors, (void *)load_ptr, &vctx, ds,
+					overhead, length);
+		if (ret) {
+			if (ds)
+				decomp_stream_finish(ds, NULL);
+			goto out;
+		}
 
 		debug("External data: dst=%lx, offset=%x, size=%lx\n",
 		      load_ptr, offset, (unsigned long)length);
@@ -245,9 +386,11 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 #ifdef CONFIG_SPL_FIT_SIGNATURE
 	printf("## Checking hash(es) for Image %s ... ",
 	       fit_get_name(fit, node, NULL));
-	if (!fit_image_verify_with_data(fit, node,
-					 src, length))
-		return -EPERM;
+	if (external_data ? !fit_image_verify_finish(&vctx, src, length) :
+	    !fit_image_verify_with_data(fit, node, src, length)) {
+		ret = -EPERM;
+		goto out;
+	}
 	puts("OK\n");
 #endif
 
@@ -255,14 +398,33 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	board_fit_image_post_process(&src, &length);
 #endif
 
-	if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
+	if (ds) {
+		size_t unc_len;
+
+		if (decomp_stream_finish(ds, &unc_len)) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+			goto out;
+		}
+		length = unc_len;
+	} else if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
 		size = length;
 		if (gunzip((void *)load_addr, CONFIG_SYS_BOOTM_LEN,
 			   src, &size)) {
 			puts("Uncompressing error\n");
-			return -EIO;
+			ret = -EIO;
+			goto out;
 		}
 		length = size;
+	} else if (IS_ENABLED(CONFIG_SPL_ZSTD) && image_comp == IH_COMP_ZSTD) {
+		size_t unc_len = CONFIG_SYS_BOOTM_LEN;
+
+		if (zstd_decompress(src, length, (void *)load_addr, &unc_len)) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+			goto out;
+		}
+		length = unc_len;
 	} else {
 		memcpy((void *)load_addr, src, length);
 	}
@@ -272,8 +434,12 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 		image_info->size = length;
 		image_info->entry_point = fdt_getprop_u32(fit, node, "entry");
 	}
+	ret = 0;
 
-	return 0;
+out:
+	free(buf);
+
+	return ret;
 }
 
 static int spl_fit_append_fdt(struct spl_image_info *spl_image,
@@ -56,7 +56,7 @@
 static const unsigned char us_direction[256/8] = {
 	0x28, 0x81, 0x14, 0x14, 0x20, 0x01, 0x90, 0x77,
 	0x0C, 0x20, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00,
-	0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01,
+	0x00, 0x01, 0x00, 0x40, 0x00, 0x01, 0x00, 0x01,
 	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
 #define US_DIRECTION(x) ((us_direction[x>>3] >> (x & 7)) & 1)
@@ -97,6 +97,11 @@ struct us_data {
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
 	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
+#ifdef CONFIG_USB_UAS
+	unsigned char	ep_cmd;			/* UAS command endpoint */
+	unsigned char	ep_status;		/* UAS status endpoint */
+	unsigned char	uas_sense[18];		/* sense from last status */
+#endif
 };
 
 #if !CONFIG_IS_ENABLED(BLK)
@@ -107,6 +112,9 @@ static struct us_data usb_stor[USB_MAX_STOR_DEV];
 #define USB_STOR_TRANSPORT_FAILED -1
 #define USB_STOR_TRANSPORT_ERROR  -2
 
+/* The one UAS command in flight uses this tag */
+#define UAS_TAG			1
+
 int usb_stor_get_info(struct usb_device *dev, struct us_data *us,
 		      struct blk_desc *dev_desc);
 int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
@@ -171,6 +179,11 @@ static unsigned int usb_get_max_lun(struct us_data *us)
 {
 	int len;
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, result, 1);
+
+	/* UAS has no such request; only LUN 0 is used */
+	if (us->protocol == US_PR_UAS)
+		return 0;
+
 	len = usb_control_msg(us->pusb_dev,
 			      usb_rcvctrlpipe(us->pusb_dev, 0),
 			      US_BBB_GET_MAX_LUN,
@@ -935,6 +948,104 @@ do_retry:
 	return USB_STOR_TRANSPORT_FAILED;
 }
 
+#ifdef CONFIG_USB_UAS
+static int usb_stor_UAS_bulk(struct us_data *us, unsigned int pipe,
+			     void *data, int len, int *actlen)
+{
+	return usb_bulk_msg(us->pusb_dev, pipe, data, len, actlen,
+			    USB_CNTL_TIMEOUT * 5);
+}
+
+/*
+ * The host bulk API is synchronous, so a single command is in flight. Streams
+ * are not used, so the device sends a Read Ready or Write Ready IU on the
+ * status pipe before the data phase.
+ */
+static int usb_stor_UAS_transport(struct scsi_cmd *srb, struct us_data *us)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(struct uas_command_iu, cmd, 1);
+	ALLOC_CACHE_ALIGN_BUFFER(struct uas_sense_iu, sense, 1);
+	unsigned int pipe, status_pipe;
+	int dir_in, actlen, data_actlen;
+	bool have_status = false;
+	bool data_failed = false;
+	int result;
+
+	/* The sense data came with the status of the previous command */
+	if (srb->cmd[0] == SCSI_REQ_SENSE) {
+		memcpy(srb->pdata, us->uas_sense,
+		       min_t(ulong, srb->datalen, sizeof(us->uas_sense)));
+		memset(us->uas_sense, '\0', sizeof(us->uas_sense));
+		return USB_STOR_TRANSPORT_GOOD;
+	}
+	if (srb->cmdlen > sizeof(cmd->cdb))
+		return USB_STOR_TRANSPORT_ERROR;
+
+	dir_in = US_DIRECTION(srb->cmd[0]);
+	memset(cmd, '\0', sizeof(*cmd));
+	cmd->iu_id = UAS_IU_COMMAND;
+	cmd->tag = cpu_to_be16(UAS_TAG);
+	cmd->lun[1] = srb->lun;
+	memcpy(cmd->cdb, srb->cmd, srb->cmdlen);
+	result = usb_stor_UAS_bulk(us, usb_sndbulkpipe(us->pusb_dev,
+				   us->ep_cmd), cmd, UAS_COMMAND_IU_SIZE,
+				   &actlen);
+	if (result < 0) {
+		debug("UAS: command IU failed, status %ld\n",
+		      us->pusb_dev->status);
+		return USB_STOR_TRANSPORT_ERROR;
+	}
+
+	status_pipe = usb_rcvbulkpipe(us->pusb_dev, us->ep_status);
+	if (srb->datalen) {
+		result = usb_stor_UAS_bulk(us, status_pipe, sense,
+					   UAS_SENSE_IU_SIZE, &actlen);
+		if (result < 0)
+			return USB_STOR_TRANSPORT_ERROR;
+		/* Anything else means the command ended without data */
+		have_status = sense->iu_id != (dir_in ? UAS_IU_READ_READY :
+					       UAS_IU_WRITE_READY);
+	}
+	if (srb->datalen && !have_status) {
+		if (dir_in)
+			pipe = usb_rcvbulkpipe(us->pusb_dev, us->ep_in);
+		else
+			pipe = usb_sndbulkpipe(us->pusb_dev, us->ep_out);
+		result = usb_stor_UAS_bulk(us, pipe, srb->pdata,
+					   srb->datalen, &data_actlen);
+		/* The status may still say why, so fetch it anyway */
+		if (result < 0) {
+			debug("UAS: data phase failed, status %ld\n",
+			      us->pusb_dev->status);
+			data_failed = true;
+		}
+	}
+	if (!have_status) {
+		result = usb_stor_UAS_bulk(us, status_pipe, sense,
+					   UAS_SENSE_IU_SIZE, &actlen);
+		if (result < 0)
+			return USB_STOR_TRANSPORT_ERROR;
+	}
+
+	if (sense->iu_id != UAS_IU_SENSE ||
+	    be16_to_cpu(sense->tag) != UAS_TAG) {
+		debug("UAS: unexpected IU %#x, tag %d\n", sense->iu_id,
+		      be16_to_cpu(sense->tag));
+		return USB_STOR_TRANSPORT_ERROR;
+	}
+	if (sense->status) {
+		debug("UAS: status %#x\n", sense->status);
+		memcpy(us->uas_sense, sense->sense,
+		       min_t(uint, be16_to_cpu(sense->len),
+			     sizeof(us->uas_sense)));
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+
+	return data_failed ? USB_STOR_TRANSPORT_ERROR :
+			     USB_STOR_TRANSPORT_GOOD;
+}
+#endif
+
 static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
@@ -954,9 +1065,15 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * SuperSpeed devices spend most of their time on per-command overhead
+	 * with 120 KB transfers, so follow Mac OS X and allow 1 MB for them.
 	 */
 	unsigned short blk = 240;
 
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = 2048;
+
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
 	int ret;
@@ -1062,6 +1179,26 @@ static int usb_read_capacity(struct scsi_cmd *srb, struct us_data *ss)
 	return -1;
 }
 
+/* READ CAPACITY(16), for devices with 2^32 blocks or more */
+static int usb_read_capacity_16(struct scsi_cmd *srb, struct us_data *ss)
+{
+	int retry;
+
+	retry = 3;
+	do {
+		memset(&srb->cmd[0], 0, 16);
+		srb->cmd[0] = SCSI_RD_CAPAC16;
+		srb->cmd[1] = 0x10;	/* service action */
+		srb->cmd[13] = 32;	/* allocation length */
+		srb->datalen = 32;
+		srb->cmdlen = 16;
+		if (ss->transport(srb, ss) == USB_STOR_TRANSPORT_GOOD)
+			return 0;
+	} while (retry--);
+
+	return -1;
+}
+
 static int usb_read_10(struct scsi_cmd *srb, struct us_data *ss,
 		       unsigned long start, unsigned short blocks)
 {
@@ -1096,6 +1233,25 @@ static int usb_write_10(struct scsi_cmd *srb, struct us_data *ss,
 	return ss->transport(srb, ss);
 }
 
+/* READ(16) and WRITE(16) reach blocks beyond the 32-bit LBA of READ(10) */
+static int usb_rw_16(struct scsi_cmd *srb, struct us_data *ss,
+		     unsigned char opcode, lbaint_t start,
+		     unsigned short blocks)
+{
+	u64 lba = start;
+	int i;
+
+	memset(&srb->cmd[0], 0, 16);
+	srb->cmd[0] = opcode;
+	for (i = 0; i < 8; i++)
+		srb->cmd[2 + i] = (lba >> (56 - i * 8)) & 0xff;
+	srb->cmd[12] = ((unsigned char) (blocks >> 8)) & 0xff;
+	srb->cmd[13] = (unsigned char) blocks & 0xff;
+	srb->cmdlen = 16;
+	debug("rw16: opcode %x start %llx blocks %x\n", opcode, lba, blocks);
+	return ss->transport(srb, ss);
+}
+
 
 #ifdef CONFIG_USB_BIN_FIXUP
 /*
@@ -1133,7 +1289,7 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	unsigned short smallblks;
 	struct usb_device *udev;
 	struct us_data *ss;
-	int retry;
+	int retry, ret;
 	struct scsi_cmd *srb = &usb_ccb;
 #if CONFIG_IS_ENABLED(BLK)
 	struct blk_desc *block_dev;
@@ -1178,7 +1334,11 @@ retry_it:
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_read_10(srb, ss, start, smallblks)) {
+		if (upper_32_bits(start))
+			ret = usb_rw_16(srb, ss, SCSI_READ16, start, smallblks);
+		else
+			ret = usb_read_10(srb, ss, start, smallblks);
+		if (ret) {
 			debug("Read ERROR\n");
 			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
@@ -1214,7 +1374,7 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	unsigned short smallblks;
 	struct usb_device *udev;
 	struct us_data *ss;
-	int retry;
+	int retry, ret;
 	struct scsi_cmd *srb = &usb_ccb;
 #if CONFIG_IS_ENABLED(BLK)
 	struct blk_desc *block_dev;
@@ -1263,7 +1423,11 @@ retry_it:
 			usb_show_progress();
 		srb->datalen = block_dev->blksz * smallblks;
 		srb->pdata = (unsigned char *)buf_addr;
-		if (usb_write_10(srb, ss, start, smallblks)) {
+		if (upper_32_bits(start))
+			ret = usb_rw_16(srb, ss, SCSI_WRITE16, start, smallblks);
+		else
+			ret = usb_write_10(srb, ss, start, smallblks);
+		if (ret) {
 			debug("Write ERROR\n");
 			ss->flags &= ~USB_READY;
 			usb_request_sense(srb, ss);
@@ -1287,6 +1451,108 @@ retry_it:
 
 }
 
+#ifdef CONFIG_USB_UAS
+/*
+ * Look for a UAS alternate setting of the interface and select it. The
+ * configuration descriptor is read again since usb_parse_config() drops the
+ * Pipe Usage descriptors which say which endpoint is which.
+ */
+static int usb_stor_UAS_probe(struct usb_device *dev,
+			      struct usb_interface *iface, struct us_data *ss)
+{
+	/* Indexed by pipe ID - 1: command, status, data in, data out */
+	struct usb_endpoint_descriptor *eps[UAS_PIPE_ID_DATA_OUT];
+	struct usb_endpoint_descriptor *ep_desc = NULL;
+	struct usb_interface_descriptor *if_head = NULL;
+	struct uas_pipe_usage_desc *usage;
+	struct usb_descriptor_header *head;
+	bool in_if = false, in_uas = false;
+	int len, index, epno = 0, alt = -1;
+	unsigned char *buf;
+	int ret, i;
+
+	len = usb_get_configuration_len(dev, dev->configno);
+	if (len < 0)
+		return len;
+	buf = malloc_cache_aligned(len);
+	if (!buf)
+		return -ENOMEM;
+	ret = usb_get_configuration_no(dev, dev->configno, buf, len);
+	if (ret < len) {
+		ret = -EIO;
+		goto out;
+	}
+
+	memset(eps, '\0', sizeof(eps));
+	for (index = 0; index + 1 < len && alt < 0; index += head->bLength) {
+		head = (struct usb_descriptor_header *)&buf[index];
+		if (!head->bLength || index + head->bLength > len)
+			break;
+
+		switch (head->bDescriptorType) {
+		case USB_DT_INTERFACE:
+			if_head = (struct usb_interface_descriptor *)head;
+			in_if = if_head->bInterfaceNumber ==
+				iface->desc.bInterfaceNumber;
+			in_uas = in_if &&
+				 if_head->bInterfaceProtocol == US_PR_UAS;
+			memset(eps, '\0', sizeof(eps));
+			ep_desc = NULL;
+			break;
+		case USB_DT_ENDPOINT:
+			if (!in_if)
+				break;
+			/* Alternate settings' endpoints follow each other */
+			ep_desc = epno < iface->no_of_ep ?
+				  &iface->ep_desc[epno] : NULL;
+			epno++;
+			break;
+		case USB_DT_PIPE_USAGE:
+			usage = (struct uas_pipe_usage_desc *)head;
+			if (!in_uas || !ep_desc ||
+			    usage->bPipeID < UAS_PIPE_ID_CMD ||
+			    usage->bPipeID > UAS_PIPE_ID_DATA_OUT)
+				break;
+			eps[usage->bPipeID - 1] = ep_desc;
+			for (i = 0; i < ARRAY_SIZE(eps) && eps[i]; i++)
+				;
+			if (i == ARRAY_SIZE(eps))
+				alt = if_head->bAlternateSetting;
+			break;
+		}
+	}
+	if (alt < 0) {
+		ret = -ENOENT;
+		goto out;
+	}
+	/* SuperSpeed UAS needs streams, which are not supported */
+	if (dev->speed >= USB_SPEED_SUPER) {
+		ret = -ENOSYS;
+		goto out;
+	}
+
+	ret = usb_set_interface(dev, iface->desc.bInterfaceNumber, alt);
+	if (ret)
+		goto out;
+
+	ss->ep_cmd = eps[UAS_PIPE_ID_CMD - 1]->bEndpointAddress &
+		     USB_ENDPOINT_NUMBER_MASK;
+	ss->ep_status = eps[UAS_PIPE_ID_STATUS - 1]->bEndpointAddress &
+			USB_ENDPOINT_NUMBER_MASK;
+	ss->ep_in = eps[UAS_PIPE_ID_DATA_IN - 1]->bEndpointAddress &
+		    USB_ENDPOINT_NUMBER_MASK;
+	ss->ep_out = eps[UAS_PIPE_ID_DATA_OUT - 1]->bEndpointAddress &
+		     USB_ENDPOINT_NUMBER_MASK;
+	ss->protocol = US_PR_UAS;
+	ss->transport = usb_stor_UAS_transport;
+	ret = 0;
+out:
+	free(buf);
+
+	return ret;
+}
+#endif
+
 /* Probe to see if a new device is actually a Storage device */
 int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 		      struct us_data *ss)
@@ -1321,6 +1587,16 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	ss->subclass = iface->desc.bInterfaceSubClass;
 	ss->protocol = iface->desc.bInterfaceProtocol;
 
+#ifdef CONFIG_USB_UAS
+	/* Prefer UAS, which may be offered as an alternate setting */
+	if (ss->subclass == US_SC_SCSI && !usb_stor_UAS_probe(dev, iface, ss)) {
+		debug("Transport: USB Attached SCSI\n");
+		usb_stor_set_max_xfer_blk(dev, ss);
+		dev->privptr = (void *)ss;
+		return 1;
+	}
+#endif
+
 	/* set the handler pointers based on the protocol */
 	debug("Transport: ");
 	switch (ss->protocol) {
@@ -1415,8 +1691,10 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 {
 	unsigned char perq, modi;
 	ALLOC_CACHE_ALIGN_BUFFER(u32, cap, 2);
+	ALLOC_CACHE_ALIGN_BUFFER(u64, cap16, 4);
 	ALLOC_CACHE_ALIGN_BUFFER(u8, usb_stor_buf, 36);
-	u32 capacity, blksz;
+	u64 capacity;
+	u32 blksz;
 	struct scsi_cmd *pccb = &usb_ccb;
 
 	pccb->pdata = usb_stor_buf;
@@ -1483,11 +1761,21 @@ int usb_stor_get_info(struct usb_device *dev, struct us_data *ss,
 	cap[1] = cpu_to_be32(cap[1]);
 #endif
 
-	capacity = be32_to_cpu(cap[0]) + 1;
+	capacity = (u64)be32_to_cpu(cap[0]) + 1;
 	blksz = be32_to_cpu(cap[1]);
 
-	debug("Capacity = 0x%08x, blocksz = 0x%08x\n", capacity, blksz);
-	dev_desc->lba = capacity;
+	/* READ CAPACITY(10) reports 0xffffffff if the device is too large */
+	if (be32_to_cpu(cap[0]) == 0xffffffff) {
+		pccb->pdata = (unsigned char *)cap16;
+		memset(pccb->pdata, 0, 32);
+		if (usb_read_capacity_16(pccb, ss) == 0) {
+			capacity = be64_to_cpu(cap16[0]) + 1;
+			blksz = be32_to_cpu(((u32 *)cap16)[2]);
+		}
+	}
+
+	debug("Capacity = 0x%llx, blocksz = 0x%08x\n", capacity, blksz);
+	dev_desc->lba = min_t(u64, capacity, (lbaint_t)~0ULL);
 	dev_desc->blksz = blksz;
 	dev_desc->log2blksz = LOG2(dev_desc->blksz);
 	dev_desc->type = perq;
@@ -10,106 +10,232 @@
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
+/*
+ * The cache is a set-associative hash table. Each entry holds an extent
+ * of at most max_blocks_per_entry blocks. An extent is filed under the set
+ * selected by hashing the device and the window (of 1 << cache_shift
+ * blocks) containing its first block. Since an extent is never longer than
+ * a window, a block can only be cached by an extent starting in its own
+ * window or in the one before, so a lookup probes at most two sets.
+ */
 struct block_cache_node {
-	struct list_head lh;
 	int iftype;
 	int devnum;
 	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t blkcnt;	/* 0 if this entry is unused */
 	unsigned long blksz;
+	unsigned long size;	/* allocated size of cache */
+	unsigned int age;
 	char *cache;
 };
 
-static LIST_HEAD(block_cache);
+/* Number of devices which get their own statistics */
+#define BLOCK_CACHE_DEVS	8
+
+struct block_cache_dev {
+	bool used;
+	struct block_cache_dev_stats stats;
+};
+
+static struct block_cache_node *cache_nodes;
+static unsigned int cache_sets;
+static unsigned int cache_shift;
+static unsigned int cache_clock;
+static struct block_cache_dev *cache_devs;
+static struct block_cache_dev *cache_last_dev;
+
+#define BLOCK_CACHE_ENTRIES	(CONFIG_BLOCK_CACHE_SIZE * 1024 / \
+				 (CONFIG_BLOCK_CACHE_BLOCKS * 512))
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_BLOCKS,
+	.max_entries = BLOCK_CACHE_ENTRIES,
+	.ways = CONFIG_BLOCK_CACHE_WAYS,
 };
 
+/*
+ * Find the statistics for a device, taking a free slot the first time it is
+ * seen. Returns NULL if the cache is not set up or all slots are in use.
+ */
+static struct block_cache_dev *cache_dev(int iftype, int devnum)
+{
+	struct block_cache_dev *bdev = cache_last_dev;
+	int i;
+
+	if (bdev && bdev->stats.iftype == iftype &&
+	    bdev->stats.devnum == devnum)
+		return bdev;
+	if (!cache_devs)
+		return NULL;
+
+	for (i = 0, bdev = cache_devs; i < BLOCK_CACHE_DEVS; i++, bdev++) {
+		if (!bdev->used) {
+			bdev->used = true;
+			bdev->stats.iftype = iftype;
+			bdev->stats.devnum = devnum;
+			break;
+		}
+		if (bdev->stats.iftype == iftype &&
+		    bdev->stats.devnum == devnum)
+			break;
+	}
+	if (i == BLOCK_CACHE_DEVS)
+		return NULL;
+	cache_last_dev = bdev;
+
+	return bdev;
+}
+
+static int cache_setup(void)
+{
+	unsigned int ways = _stats.ways;
+
+	if (cache_nodes)
+		return 0;
+	if (!_stats.max_entries || !_stats.max_blocks_per_entry)
+		return -ENOSPC;
+
+	if (!ways || ways > _stats.max_entries)
+		ways = _stats.max_entries;
+	cache_sets = DIV_ROUND_UP(_stats.max_entries, ways);
+	cache_shift = order_base_2(_stats.max_blocks_per_entry);
+	cache_nodes = calloc(cache_sets * ways, sizeof(*cache_nodes));
+	if (!cache_nodes)
+		return -ENOMEM;
+	cache_devs = calloc(BLOCK_CACHE_DEVS, sizeof(*cache_devs));
+	if (!cache_devs) {
+		free(cache_nodes);
+		cache_nodes = NULL;
+		return -ENOMEM;
+	}
+	_stats.ways = ways;
+
+	return 0;
+}
+
+static struct block_cache_node *cache_set(int iftype, int devnum,
+					  lbaint_t window)
+{
+	u64 key = (u64)window ^ ((u64)iftype << 56) ^ ((u64)devnum << 40);
+	u32 hash = (key * 0x9e3779b97f4a7c15ULL) >> 32;
+
+	return &cache_nodes[(hash % cache_sets) * _stats.ways];
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
 					   lbaint_t start, lbaint_t blkcnt,
 					   unsigned long blksz)
 {
 	struct block_cache_node *node;
+	lbaint_t window = start >> cache_shift;
+	int i, way;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
+	for (i = 0; i < 2 && i <= window; i++) {
+		node = cache_set(iftype, devnum, window - i);
+		for (way = 0; way < _stats.ways; way++, node++)
+			if (node->blkcnt &&
+			    (node->iftype == iftype) &&
+			    (node->devnum == devnum) &&
+			    (node->blksz == blksz) &&
+			    (node->start <= start) &&
+			    (node->start + node->blkcnt >= start + blkcnt)) {
+				node->age = ++cache_clock;
+				return node;
 			}
-			return node;
-		}
-	return 0;
+	}
+
+	return NULL;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
+	struct block_cache_node *node = NULL;
+	struct block_cache_dev *bdev;
+
+	if (!cache_setup())
+		node = cache_find(iftype, devnum, start, blkcnt, blksz);
+	bdev = cache_dev(iftype, devnum);
 	if (node) {
 		const char *src = node->cache + (start - node->start) * blksz;
 		memcpy(buffer, src, blksz * blkcnt);
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		if (bdev)
+			++bdev->stats.hits;
 		return 1;
 	}
 
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (bdev)
+		++bdev->stats.misses;
 	return 0;
 }
 
+static void cache_drop(struct block_cache_node *node)
+{
+	struct block_cache_dev *bdev;
+
+	debug("drop: start " LBAF ", count " LBAFU "\n",
+	      node->start, node->blkcnt);
+	bdev = cache_dev(node->iftype, node->devnum);
+	if (bdev)
+		--bdev->stats.entries;
+	node->blkcnt = 0;
+	_stats.entries--;
+}
+
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *victim;
+	struct block_cache_dev *bdev;
+	unsigned long bytes;
+	int way;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
 		return;
 
-	if (_stats.max_entries == 0)
+	if (cache_setup())
 		return;
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
+	/* pick a free way, or else the least recently used one */
+	node = cache_set(iftype, devnum, start >> cache_shift);
+	victim = node;
+	for (way = 0; way < _stats.ways; way++, node++) {
+		if (!node->blkcnt) {
+			victim = node;
+			break;
 		}
-	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
+		if (cache_clock - node->age > cache_clock - victim->age)
+			victim = node;
+	}
+	node = victim;
+
+	if (node->blkcnt) {
+		bdev = cache_dev(node->iftype, node->devnum);
+		if (bdev)
+			++bdev->stats.evictions;
+		++_stats.evictions;
+		cache_drop(node);
 	}
 
-	if (!node->cache) {
+	bytes = blksz * blkcnt;
+	if (node->size < bytes) {
+		free(node->cache);
+		node->size = 0;
 		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
+		if (!node->cache)
 			return;
-		}
+		node->size = bytes;
 	}
 
 	debug("fill: start " LBAF ", count " LBAFU "\n",
@@ -120,41 +246,59 @@ void blkcache_fill(int iftype, int devnum,
 	node->start = start;
 	node->blkcnt = blkcnt;
 	node->blksz = blksz;
+	node->age = ++cache_clock;
 	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
 	_stats.entries++;
+	bdev = cache_dev(iftype, devnum);
+	if (bdev)
+		++bdev->stats.entries;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
 	struct block_cache_node *node;
+	struct block_cache_dev *bdev;
+	int i;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+	if (!cache_nodes)
+		return;
+
+	bdev = cache_dev(iftype, devnum);
+	if (bdev && !bdev->stats.entries)
+		return;
+
+	for (i = 0, node = cache_nodes; i < cache_sets * _stats.ways;
+	     i++, node++) {
+		if (node->blkcnt &&
+		    (node->iftype == iftype) &&
+		    (node->devnum == devnum))
+			cache_drop(node);
+	}
+}
+
+static void cache_free(void)
+{
+	int i;
+
+	if (cache_nodes) {
+		for (i = 0; i < cache_sets * _stats.ways; i++)
+			free(cache_nodes[i].cache);
+		free(cache_nodes);
+		cache_nodes = NULL;
 	}
+	free(cache_devs);
+	cache_devs = NULL;
+	cache_last_dev = NULL;
+	_stats.entries = 0;
 }
 
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
-	struct block_cache_node *node;
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
-		_stats.entries = 0;
+		cache_free();
+		_stats.ways = CONFIG_BLOCK_CACHE_WAYS;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
@@ -162,6 +306,7 @@ void blkcache_configure(unsigned blocks, unsigned entries)
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
@@ -169,4 +314,22 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	if (!cache_devs || index < 0 || index >= BLOCK_CACHE_DEVS)
+		return -ENOENT;
+	bdev = &cache_devs[index];
+	if (!bdev->used)
+		return -ENOENT;
+	memcpy(stats, &bdev->stats, sizeof(*stats));
+	bdev->stats.hits = 0;
+	bdev->stats.misses = 0;
+	bdev->stats.evictions = 0;
+
+	return 0;
 }
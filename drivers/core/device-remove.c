@@ -164,6 +164,15 @@ int device_remove(struct udevice *dev, uint flags)
 	if (!(dev->flags & DM_FLAG_ACTIVATED))
 		return 0;
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	/* Let the probe finish, so the device is in a known state */
+	if (dev->flags & DM_FLAG_PROBE_PENDING) {
+		ret = device_probe(dev);
+		if (ret)
+			return 0;
+	}
+#endif
+
 	drv = dev->driver;
 	assert(drv);
 
@@ -200,7 +209,7 @@ int device_remove(struct udevice *dev, uint flags)
 	if (flags_remove(flags, drv->flags)) {
 		device_free(dev);
 
-		dev->seq = -1;
+		uclass_set_seq(dev, -1);
 		dev->flags &= ~DM_FLAG_ACTIVATED;
 	}
 
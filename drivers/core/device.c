@@ -28,6 +28,7 @@
 #include <linux/err.h>
 #include <linux/list.h>
 #include <power-domain.h>
+#include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -311,7 +312,98 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
-int device_probe(struct udevice *dev)
+/* Undo the work of device_probe_common() after a failure */
+static void device_probe_fail(struct udevice *dev)
+{
+	dev->flags &= ~DM_FLAG_ACTIVATED;
+
+	uclass_set_seq(dev, -1);
+	device_free(dev);
+}
+
+/* Complete a probe once the driver has finished with the device */
+static int device_probe_post(struct udevice *dev)
+{
+	int ret;
+
+	ret = uclass_post_probe_device(dev);
+	if (ret) {
+		if (device_remove(dev, DM_REMOVE_NORMAL)) {
+			dm_warn("%s: Device '%s' failed to remove on error path\n",
+				__func__, dev->name);
+		}
+		device_probe_fail(dev);
+
+		return ret;
+	}
+
+	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
+		pinctrl_select_state(dev, "default");
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int device_probe_poll(struct udevice *dev)
+{
+	const struct driver *drv = dev->driver;
+	int ret = 0;
+
+	if (!(dev->flags & DM_FLAG_PROBE_PENDING))
+		return 0;
+
+	if (drv->probe_finish) {
+		ret = drv->probe_finish(dev);
+		if (ret == -EAGAIN)
+			return ret;
+	}
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
+	gd->dm_probe_pending--;
+	if (ret) {
+		device_probe_fail(dev);
+		return ret;
+	}
+
+	return device_probe_post(dev);
+}
+
+static int device_probe_wait(struct udevice *dev)
+{
+	const struct driver *drv = dev->driver;
+	ulong start = get_timer(0);
+	int ret;
+
+	while (1) {
+		ret = device_probe_poll(dev);
+		if (ret != -EAGAIN)
+			return ret;
+		if (get_timer(start) > CONFIG_DM_PROBE_ASYNC_TIMEOUT)
+			break;
+		WATCHDOG_RESET();
+	}
+
+	/* The uclass never saw the device, so only the driver tidies up */
+	dm_warn("%s: Device '%s' did not finish probing\n", __func__,
+		dev->name);
+	dev->flags &= ~DM_FLAG_PROBE_PENDING;
+	gd->dm_probe_pending--;
+	if (drv->remove)
+		drv->remove(dev);
+	device_probe_fail(dev);
+
+	return -ETIMEDOUT;
+}
+#endif
+
+/**
+ * device_probe_common() - Probe a device, optionally not waiting for it
+ *
+ * @dev: Device to probe
+ * @wait: true to wait for a device with DM_FLAG_PROBE_ASYNC to be ready,
+ *	false to return once it is started
+ * @return 0 if OK, -ve on error
+ */
+static int device_probe_common(struct udevice *dev, bool wait)
 {
 	const struct driver *drv;
 	int size = 0;
@@ -321,8 +413,13 @@ int device_probe(struct udevice *dev)
 	if (!dev)
 		return -EINVAL;
 
-	if (dev->flags & DM_FLAG_ACTIVATED)
+	if (dev->flags & DM_FLAG_ACTIVATED) {
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+		if (wait && (dev->flags & DM_FLAG_PROBE_PENDING))
+			return device_probe_wait(dev);
+#endif
 		return 0;
+	}
 
 	drv = dev->driver;
 	assert(drv);
@@ -380,7 +477,7 @@ int device_probe(struct udevice *dev)
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -437,28 +534,34 @@ int device_probe(struct udevice *dev)
 		}
 	}
 
-	ret = uclass_post_probe_device(dev);
-	if (ret)
-		goto fail_uclass;
-
-	if (dev->parent && device_get_uclass_id(dev) == UCLASS_PINCTRL)
-		pinctrl_select_state(dev, "default");
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+	if (drv->flags & DM_FLAG_PROBE_ASYNC) {
+		dev->flags |= DM_FLAG_PROBE_PENDING;
+		gd->dm_probe_pending++;
 
-	return 0;
-fail_uclass:
-	if (device_remove(dev, DM_REMOVE_NORMAL)) {
-		dm_warn("%s: Device '%s' failed to remove on error path\n",
-			__func__, dev->name);
+		return wait ? device_probe_wait(dev) : 0;
 	}
-fail:
-	dev->flags &= ~DM_FLAG_ACTIVATED;
+#endif
 
-	dev->seq = -1;
-	device_free(dev);
+	return device_probe_post(dev);
+fail:
+	device_probe_fail(dev);
 
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	return device_probe_common(dev, true);
+}
+
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+int device_probe_start(struct udevice *dev)
+{
+	return device_probe_common(dev, false);
+}
+#endif
+
 void *dev_get_platdata(const struct udevice *dev)
 {
 	if (!dev) {
@@ -719,7 +822,8 @@ int device_find_first_inactive_child(struct udevice *parent,
 
 	*devp = NULL;
 	list_for_each_entry(dev, &parent->child_head, sibling_node) {
-		if (!device_active(dev) &&
+		/* A device which is still probing is not free to use */
+		if (!(dev->flags & DM_FLAG_ACTIVATED) &&
 		    device_get_uclass_id(dev) == uclass_id) {
 			*devp = dev;
 			return 0;
@@ -17,7 +17,12 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -124,11 +129,138 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+/**
+ * struct lists_compat_slot - a slot in the table of compatible strings
+ *
+ * @drv:	1 + index of the driver in the linker list, 0 if the slot is empty
+ * @match:	Index of the string in the driver's of_match table
+ */
+struct lists_compat_slot {
+	u16 drv;
+	u16 match;
+};
+
+/**
+ * struct lists_compat_index - hash table of the drivers' compatible strings
+ *
+ * Each string is stored once, for the first driver in the linker list which
+ * has it, since that is the one found by searching the list in order. The
+ * table is at most half full and collisions go to the next free slot.
+ *
+ * @mask:	Number of slots - 1, the number being a power of two
+ * @slot:	The slots
+ */
+struct lists_compat_index {
+	uint mask;
+	struct lists_compat_slot slot[];
+};
+
+/* FNV-1a hash of a string */
+static uint lists_compat_hash(const char *str)
+{
+	uint hash = 2166136261U;
+
+	while (*str) {
+		hash ^= (u8)*str++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static const struct udevice_id *lists_compat_id(struct lists_compat_slot *slot)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+
+	return &driver[slot->drv - 1].of_match[slot->match];
+}
+
+/* Find the slot holding @compat, or the empty slot where it would go */
+static struct lists_compat_slot *
+lists_compat_find(struct lists_compat_index *index, const char *compat)
+{
+	struct lists_compat_slot *slot;
+	uint pos;
+
+	for (pos = lists_compat_hash(compat) & index->mask;; pos++) {
+		slot = &index->slot[pos & index->mask];
+		if (!slot->drv ||
+		    !strcmp(lists_compat_id(slot)->compatible, compat))
+			return slot;
+	}
+}
+
+static struct lists_compat_index *lists_compat_build(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	struct lists_compat_index *index;
+	struct lists_compat_slot *slot;
+	const struct udevice_id *id;
+	uint count = 0, size;
+	int i;
+
+	for (i = 0; i < n_ents; i++) {
+		for (id = driver[i].of_match; id && id->compatible; id++)
+			count++;
+	}
+	if (n_ents >= 0xffff || count >= 0x8000)
+		return ERR_PTR(-E2BIG);
+
+	size = roundup_pow_of_two(max(count * 2, 2U));
+	index = calloc(1, sizeof(*index) + size * sizeof(index->slot[0]));
+	if (!index)
+		return ERR_PTR(-ENOMEM);
+	index->mask = size - 1;
+
+	for (i = 0; i < n_ents; i++) {
+		for (id = driver[i].of_match; id && id->compatible; id++) {
+			slot = lists_compat_find(index, id->compatible);
+			if (slot->drv)
+				continue;
+			slot->drv = i + 1;
+			slot->match = id - driver[i].of_match;
+		}
+	}
+	log_debug("%u compatible strings in %u slots\n", count, size);
+
+	return index;
+}
+#endif /* DM_COMPAT_HASH */
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_HASH)
+	struct lists_compat_slot *slot;
+
+	if (!gd->dm_compat_index)
+		gd->dm_compat_index = lists_compat_build();
+	if (!IS_ERR(gd->dm_compat_index)) {
+		slot = lists_compat_find(gd->dm_compat_index, compat);
+		if (!slot->drv)
+			return NULL;
+		*idp = lists_compat_id(slot);
+
+		return &driver[slot->drv - 1];
+	}
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -165,13 +297,8 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		log_debug("   - attempt to match compatible string '%s'\n",
 			  compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = lists_driver_lookup_compat(compat, &id);
+		if (!entry)
 			continue;
 
 		if (pre_reloc_only) {
@@ -20,6 +20,7 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <linux/libfdt.h>
 #include <dm/of_access.h>
 #include <linux/ctype.h>
@@ -43,6 +44,158 @@ static struct device_node *of_stdout;
 /* pointer to options given after the alias (separated by :) or NULL if none */
 static const char *of_stdout_options;
 
+#ifdef CONFIG_OF_LIVE_INDEX
+/* Nodes with at least this many properties get a hash table of them */
+#define OF_PROP_HASH_MIN	8
+
+/**
+ * struct of_prop_hash - hash table of the properties of a node
+ *
+ * This is indexed by the interned name of each property.
+ *
+ * @mask:	Number of slots - 1, the number being a power of two
+ * @slot:	Properties, NULL for an empty slot
+ */
+struct of_prop_hash {
+	uint mask;
+	struct property *slot[];
+};
+
+/*
+ * Interned property names. Every property in the tree has its name set to
+ * the copy in this table, so names can be compared by pointer. The table
+ * is never freed, so that names stay valid in every tree.
+ */
+static const char **of_names;
+static uint of_names_mask;
+static uint of_names_count;
+
+/* true if all property names are interned, so of_names can be used */
+static bool of_names_valid;
+
+/* Nodes by phandle in the tree of_phandles_root */
+static struct device_node **of_phandles;
+static struct device_node *of_phandles_root;
+static phandle of_phandles_max;
+
+static uint of_name_hash(const char *name)
+{
+	uint hash = 2166136261U;
+
+	while (*name) {
+		hash ^= (u8)*name++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* Find a name in the table, or the empty slot where it would go */
+static const char **of_name_slot(const char *name)
+{
+	const char **slot;
+	uint pos;
+
+	for (pos = of_name_hash(name);; pos++) {
+		slot = &of_names[pos & of_names_mask];
+		if (!*slot || !strcmp(*slot, name))
+			return slot;
+	}
+}
+
+/* Get the interned copy of a name, or NULL if no property has it */
+static const char *of_name_find(const char *name)
+{
+	return *of_name_slot(name);
+}
+
+/* Get the interned copy of a name, adding it if needed */
+static const char *of_name_intern(const char *name)
+{
+	const char **slot, **old;
+	uint i, old_size, size;
+
+	if (!of_names || (of_names_count + 1) * 2 > of_names_mask + 1) {
+		old_size = of_names ? of_names_mask + 1 : 0;
+		size = old_size ? old_size * 2 : 256;
+		old = of_names;
+		of_names = calloc(size, sizeof(*of_names));
+		if (!of_names) {
+			of_names = old;
+			return NULL;
+		}
+		of_names_mask = size - 1;
+		for (i = 0; i < old_size; i++) {
+			if (old[i])
+				*of_name_slot(old[i]) = old[i];
+		}
+		free(old);
+	}
+	slot = of_name_slot(name);
+	if (!*slot) {
+		*slot = strdup(name);
+		if (!*slot)
+			return NULL;
+		of_names_count++;
+	}
+
+	return *slot;
+}
+
+static uint of_prop_hash_pos(const char *name)
+{
+	ulong val = (ulong)name;
+
+	return (uint)(val ^ (val >> 7) ^ (val >> 17));
+}
+
+/* Find a property in a node's table, or the empty slot where it would go */
+static struct property **of_prop_hash_slot(struct of_prop_hash *hash,
+					   const char *name)
+{
+	struct property **slot;
+	uint pos;
+
+	for (pos = of_prop_hash_pos(name);; pos++) {
+		slot = &hash->slot[pos & hash->mask];
+		if (!*slot || (*slot)->name == name)
+			return slot;
+	}
+}
+
+/* Set up the hash table of a node's properties, if it has many */
+static int of_prop_hash_build(struct device_node *np)
+{
+	struct of_prop_hash *hash;
+	struct property *pp, **slot;
+	uint count = 0, size;
+
+	free(np->prop_hash);
+	np->prop_hash = NULL;
+	for (pp = np->properties; pp; pp = pp->next)
+		count++;
+	if (count < OF_PROP_HASH_MIN)
+		return 0;
+
+	for (size = 16; size < count * 2; size *= 2)
+		;
+	hash = calloc(1, sizeof(*hash) + size * sizeof(hash->slot[0]));
+	if (!hash)
+		return -ENOMEM;
+	hash->mask = size - 1;
+
+	/* The first property with each name is the one found by the list */
+	for (pp = np->properties; pp; pp = pp->next) {
+		slot = of_prop_hash_slot(hash, pp->name);
+		if (!*slot)
+			*slot = pp;
+	}
+	np->prop_hash = hash;
+
+	return 0;
+}
+#endif /* CONFIG_OF_LIVE_INDEX */
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -127,6 +280,22 @@ struct property *of_find_property(const struct device_node *np,
 	if (!np)
 		return NULL;
 
+#ifdef CONFIG_OF_LIVE_INDEX
+	if (of_names_valid) {
+		name = of_name_find(name);
+		if (!name)
+			pp = NULL;
+		else if (np->prop_hash)
+			pp = *of_prop_hash_slot(np->prop_hash, name);
+		else
+			for (pp = np->properties; pp && pp->name != name;
+			     pp = pp->next)
+				;
+		if (pp && lenp)
+			*lenp = pp->length;
+		goto done;
+	}
+#endif
 	for (pp = np->properties; pp; pp = pp->next) {
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
@@ -134,6 +303,9 @@ struct property *of_find_property(const struct device_node *np,
 			break;
 		}
 	}
+#ifdef CONFIG_OF_LIVE_INDEX
+done:
+#endif
 	if (!pp && lenp)
 		*lenp = -FDT_ERR_NOTFOUND;
 
@@ -410,6 +582,14 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+#ifdef CONFIG_OF_LIVE_INDEX
+	if (of_phandles && of_phandles_root == gd->of_root) {
+		np = handle <= of_phandles_max ? of_phandles[handle] : NULL;
+		(void)of_node_get(np);
+
+		return np;
+	}
+#endif
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
@@ -834,3 +1014,131 @@ struct device_node *of_get_stdout(void)
 {
 	return of_stdout;
 }
+
+int of_write_prop(struct device_node *np, const char *propname, int len,
+		  const void *value)
+{
+	struct property *pp;
+	struct property *pp_last = NULL;
+	struct property *new;
+
+	pp = of_find_property(np, propname, NULL);
+	if (pp) {
+		/* Property exists -> change value */
+		pp->value = (void *)value;
+		pp->length = len;
+		return 0;
+	}
+	for (pp = np->properties; pp; pp = pp->next)
+		pp_last = pp;
+
+	if (!pp_last)
+		return -ENOENT;
+
+	/* Property does not exist -> append new property */
+	new = malloc(sizeof(struct property));
+	if (!new)
+		return -ENOMEM;
+
+#ifdef CONFIG_OF_LIVE_INDEX
+	if (of_names_valid) {
+		new->name = (char *)of_name_intern(propname);
+		if (!new->name) {
+			free(new);
+			return -ENOMEM;
+		}
+	} else
+#endif
+	{
+		new->name = strdup(propname);
+		if (!new->name) {
+			free(new);
+			return -ENOMEM;
+		}
+	}
+
+	new->value = (void *)value;
+	new->length = len;
+	new->next = NULL;
+
+	pp_last->next = new;
+
+#ifdef CONFIG_OF_LIVE_INDEX
+	/* Without a table the node is searched by list, which still works */
+	if (of_prop_hash_build(np))
+		debug("%s: cannot index %s\n", __func__, np->full_name);
+#endif
+
+	return 0;
+}
+
+int of_remove_prop(struct device_node *np, const char *propname)
+{
+	struct property **ppp;
+
+	for (ppp = &np->properties; *ppp; ppp = &(*ppp)->next) {
+		if (!strcmp((*ppp)->name, propname))
+			break;
+	}
+	if (!*ppp)
+		return -ENOENT;
+	*ppp = (*ppp)->next;
+
+#ifdef CONFIG_OF_LIVE_INDEX
+	/* The table may still point to the property, so drop it */
+	if (of_prop_hash_build(np))
+		debug("%s: cannot index %s\n", __func__, np->full_name);
+#endif
+
+	return 0;
+}
+
+int of_index_scan(struct device_node *root)
+{
+#ifdef CONFIG_OF_LIVE_INDEX
+	struct device_node *np;
+	struct property *pp;
+	phandle max = 0;
+	uint count = 0;
+	int ret = 0;
+
+	/* Stop using the names while some may not be interned */
+	of_names_valid = false;
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		for (pp = np->properties; pp; pp = pp->next) {
+			const char *name = of_name_intern(pp->name);
+
+			if (!name)
+				return -ENOMEM;
+			pp->name = (char *)name;
+		}
+		if (of_prop_hash_build(np))
+			ret = -ENOMEM;
+		if (np->phandle > max)
+			max = np->phandle;
+		count++;
+	}
+	of_names_valid = true;
+
+	/* Phandles are usually numbered from 1, but avoid a huge array */
+	free(of_phandles);
+	of_phandles = NULL;
+	if (max > count * 4)
+		return ret;
+	of_phandles = calloc(max + 1, sizeof(*of_phandles));
+	if (!of_phandles)
+		return -ENOMEM;
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle && !of_phandles[np->phandle])
+			of_phandles[np->phandle] = np;
+	}
+	of_phandles_root = root;
+	of_phandles_max = max;
+	debug("%s: %u names, %u nodes, phandles up to %u\n", __func__,
+	      of_names_count, count, max);
+
+	return ret;
+#else
+	return 0;
+#endif
+}
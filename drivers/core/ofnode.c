@@ -826,9 +826,6 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 		      const void *value)
 {
 	const struct device_node *np = ofnode_to_np(node);
-	struct property *pp;
-	struct property *pp_last = NULL;
-	struct property *new;
 
 	if (!of_live_active())
 		return -ENOSYS;
@@ -836,37 +833,7 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 	if (!np)
 		return -EINVAL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, propname) == 0) {
-			/* Property exists -> change value */
-			pp->value = (void *)value;
-			pp->length = len;
-			return 0;
-		}
-		pp_last = pp;
-	}
-
-	if (!pp_last)
-		return -ENOENT;
-
-	/* Property does not exist -> append new property */
-	new = malloc(sizeof(struct property));
-	if (!new)
-		return -ENOMEM;
-
-	new->name = strdup(propname);
-	if (!new->name) {
-		free(new);
-		return -ENOMEM;
-	}
-
-	new->value = (void *)value;
-	new->length = len;
-	new->next = NULL;
-
-	pp_last->next = new;
-
-	return 0;
+	return of_write_prop((struct device_node *)np, propname, len, value);
 }
 
 int ofnode_write_string(ofnode node, const char *propname, const char *value)
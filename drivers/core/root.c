@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <malloc.h>
@@ -21,6 +22,7 @@
 #include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/util.h>
+#include <linux/err.h>
 #include <linux/list.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -138,6 +140,9 @@ int dm_init(bool of_live)
 		return -EINVAL;
 	}
 	INIT_LIST_HEAD(&DM_UCLASS_ROOT_NON_CONST);
+	/* Any index is from before relocation, so build it again */
+	gd->dm_compat_index = NULL;
+	gd->dm_probe_pending = 0;
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
 	fix_drivers();
@@ -168,6 +173,9 @@ int dm_uninit(void)
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 	gd->dm_root = NULL;
+	if (!IS_ERR(gd->dm_compat_index))
+		free(gd->dm_compat_index);
+	gd->dm_compat_index = NULL;
 
 	return 0;
 }
@@ -376,7 +384,9 @@ int dm_init_and_scan(bool pre_reloc_only)
 	}
 
 	if (CONFIG_IS_ENABLED(OF_CONTROL) && !CONFIG_IS_ENABLED(OF_PLATDATA)) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DM_FDT, "dm_fdt");
 		ret = dm_extended_scan_fdt(gd->fdt_blob, pre_reloc_only);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_FDT);
 		if (ret) {
 			debug("dm_extended_scan_dt() failed: %d\n", ret);
 			return ret;
@@ -387,9 +397,67 @@ int dm_init_and_scan(bool pre_reloc_only)
 	if (ret)
 		return ret;
 
+	if (!pre_reloc_only) {
+		ret = dm_probe_async_start();
+		if (ret)
+			return ret;
+	}
+
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+static void dm_probe_async_start_children(struct udevice *parent)
+{
+	struct udevice *dev;
+	int ret;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if ((dev->driver->flags & DM_FLAG_PROBE_ASYNC) &&
+		    !device_active(dev)) {
+			ret = device_probe_start(dev);
+			if (ret)
+				dm_warn("%s: Device '%s' failed to probe: %d\n",
+					__func__, dev->name, ret);
+		}
+		dm_probe_async_start_children(dev);
+	}
+}
+
+int dm_probe_async_start(void)
+{
+	if (!gd->dm_root)
+		return -EINVAL;
+	dm_probe_async_start_children(gd->dm_root);
+
+	return 0;
+}
+
+static void dm_probe_poll_children(struct udevice *parent)
+{
+	struct udevice *dev;
+	int ret;
+
+	list_for_each_entry(dev, &parent->child_head, sibling_node) {
+		if (!gd->dm_probe_pending)
+			return;
+		if (dev->flags & DM_FLAG_PROBE_PENDING) {
+			ret = device_probe_poll(dev);
+			if (ret && ret != -EAGAIN)
+				dm_warn("%s: Device '%s' failed to probe: %d\n",
+					__func__, dev->name, ret);
+		}
+		dm_probe_poll_children(dev);
+	}
+}
+
+void dm_probe_poll(void)
+{
+	if (gd->dm_root && gd->dm_probe_pending)
+		dm_probe_poll_children(gd->dm_root);
+}
+#endif
+
 /* This is the root driver - all drivers are children of this */
 U_BOOT_DRIVER(root_driver) = {
 	.name	= "root_driver",
@@ -132,6 +132,7 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+	free(uc->index);
 	free(uc);
 
 	return 0;
@@ -297,6 +298,253 @@ int uclass_find_next_free_req_seq(enum uclass_id id)
 }
 #endif
 
+enum uclass_index_type {
+	UCLASS_INDEX_SEQ,
+	UCLASS_INDEX_NODE,
+	UCLASS_INDEX_PHANDLE,
+
+	UCLASS_INDEX_COUNT,
+};
+
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/**
+ * struct uclass_index_ent - an entry in one of the tables of a uclass index
+ *
+ * @key:	Sequence number, node or phandle of the device
+ * @dev:	The device, or NULL if the entry is free
+ */
+struct uclass_index_ent {
+	long key;
+	struct udevice *dev;
+};
+
+/**
+ * struct uclass_index - hash tables to find the devices in a uclass
+ *
+ * There is a table for each type of key, using open addressing with linear
+ * probing. For each key, only the first device in the uclass list is stored
+ * since that is the one found by walking the list. Sequence numbers are
+ * unique, but two devices may have the same node.
+ *
+ * Request sequence numbers are not indexed, since drivers change them while
+ * binding and probing.
+ *
+ * @mask:	Number of entries in each table - 1, the number being a power
+ *		of two
+ * @count:	Number of devices in the uclass
+ * @dups:	true for each table which has left out a device because another
+ *		had the same key, so one may need to be added on unbind
+ * @tab:	The tables, one for each enum uclass_index_type
+ */
+struct uclass_index {
+	uint mask;
+	uint count;
+	bool dups[UCLASS_INDEX_COUNT];
+	struct uclass_index_ent *tab[UCLASS_INDEX_COUNT];
+};
+
+static uint uclass_index_hash(long key)
+{
+	u32 hash = (u32)key ^ (u32)((u64)key >> 32);
+
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3b;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+/* Get the key of a device, returning false if it has none */
+static bool uclass_index_key(struct udevice *dev, int type, long *keyp)
+{
+	switch (type) {
+	case UCLASS_INDEX_SEQ:
+		*keyp = dev->seq;
+		return dev->seq != -1;
+	case UCLASS_INDEX_NODE:
+		*keyp = dev_ofnode(dev).of_offset;
+		return ofnode_valid(dev_ofnode(dev));
+#if CONFIG_IS_ENABLED(OF_CONTROL)
+	case UCLASS_INDEX_PHANDLE:
+		*keyp = dev_read_phandle(dev);
+		return *keyp > 0;
+#endif
+	default:
+		return false;
+	}
+}
+
+/* Find the entry for a key, or the free entry where it would go */
+static struct uclass_index_ent *uclass_index_lookup(struct uclass_index *index,
+						    int type, long key)
+{
+	struct uclass_index_ent *ent;
+	uint pos;
+
+	for (pos = uclass_index_hash(key);; pos++) {
+		ent = &index->tab[type][pos & index->mask];
+		if (!ent->dev || ent->key == key)
+			return ent;
+	}
+}
+
+static void uclass_index_add(struct uclass_index *index, struct udevice *dev,
+			     int type)
+{
+	struct uclass_index_ent *ent;
+	long key;
+
+	if (!uclass_index_key(dev, type, &key))
+		return;
+	ent = uclass_index_lookup(index, type, key);
+	if (ent->dev) {
+		index->dups[type] = true;
+		return;
+	}
+	ent->key = key;
+	ent->dev = dev;
+}
+
+static void uclass_index_del(struct uclass *uc, struct udevice *dev, int type)
+{
+	struct uclass_index *index = uc->index;
+	struct uclass_index_ent *tab = index->tab[type];
+	struct uclass_index_ent *ent;
+	struct udevice *other;
+	uint hole, pos, home;
+	long key;
+
+	if (!uclass_index_key(dev, type, &key))
+		return;
+	ent = uclass_index_lookup(index, type, key);
+	if (ent->dev != dev)
+		return;
+
+	/* Close the gap by moving back entries which probed past it */
+	hole = ent - tab;
+	for (pos = (hole + 1) & index->mask; tab[pos].dev;
+	     pos = (pos + 1) & index->mask) {
+		home = uclass_index_hash(tab[pos].key) & index->mask;
+		if (((pos - home) & index->mask) >=
+		    ((pos - hole) & index->mask)) {
+			tab[hole] = tab[pos];
+			hole = pos;
+		}
+	}
+	tab[hole].dev = NULL;
+
+	/* Another device may have the same key */
+	if (!index->dups[type])
+		return;
+	uclass_foreach_dev(other, uc) {
+		long other_key;
+
+		if (other != dev &&
+		    uclass_index_key(other, type, &other_key) &&
+		    other_key == key) {
+			uclass_index_add(index, other, type);
+			break;
+		}
+	}
+}
+
+/* Build the index for a uclass, with room to grow */
+static int uclass_index_build(struct uclass *uc)
+{
+	struct uclass_index *index;
+	struct udevice *dev;
+	uint count = 0, size;
+	int type;
+
+	uclass_foreach_dev(dev, uc)
+		count++;
+	for (size = 16; size < count * 2; size *= 2)
+		;
+	index = calloc(1, sizeof(*index) +
+		       UCLASS_INDEX_COUNT * size * sizeof(index->tab[0][0]));
+	if (!index)
+		return -ENOMEM;
+	index->mask = size - 1;
+	index->count = count;
+	for (type = 0; type < UCLASS_INDEX_COUNT; type++)
+		index->tab[type] = (struct uclass_index_ent *)(index + 1) +
+				   type * size;
+
+	uclass_foreach_dev(dev, uc) {
+		for (type = 0; type < UCLASS_INDEX_COUNT; type++)
+			uclass_index_add(index, dev, type);
+	}
+	free(uc->index);
+	uc->index = index;
+
+	return 0;
+}
+
+/* Add a device just put on the end of the uclass list */
+static void uclass_index_bind(struct uclass *uc, struct udevice *dev)
+{
+	struct uclass_index *index = uc->index;
+	int type;
+
+	if (!index)
+		return;
+	if (++index->count * 4 > (index->mask + 1) * 3) {
+		if (uclass_index_build(uc)) {
+			/* Build it again when next needed */
+			free(uc->index);
+			uc->index = NULL;
+		}
+		return;
+	}
+	for (type = 0; type < UCLASS_INDEX_COUNT; type++)
+		uclass_index_add(index, dev, type);
+}
+
+/* Remove a device just taken off the uclass list */
+static void uclass_index_unbind(struct uclass *uc, struct udevice *dev)
+{
+	int type;
+
+	if (!uc->index)
+		return;
+	uc->index->count--;
+	for (type = 0; type < UCLASS_INDEX_COUNT; type++)
+		uclass_index_del(uc, dev, type);
+}
+
+/*
+ * Find a device using the index, building it if needed. This returns
+ * -ENOSYS if there is no index, so the list must be walked instead.
+ */
+static int uclass_index_find(struct uclass *uc, int type, long key,
+			     struct udevice **devp)
+{
+	struct uclass_index_ent *ent;
+
+	if (!uc->index && uclass_index_build(uc))
+		return -ENOSYS;
+	ent = uclass_index_lookup(uc->index, type, key);
+	*devp = ent->dev;
+
+	return ent->dev ? 0 : -ENODEV;
+}
+#else
+static inline void uclass_index_bind(struct uclass *uc, struct udevice *dev)
+{
+}
+
+static inline void uclass_index_unbind(struct uclass *uc,
+				       struct udevice *dev)
+{
+}
+
+static inline int uclass_index_find(struct uclass *uc, int type, long key,
+				    struct udevice **devp)
+{
+	return -ENOSYS;
+}
+#endif /* DM_UCLASS_INDEX */
+
 int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 			      bool find_req_seq, struct udevice **devp)
 {
@@ -312,6 +560,14 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+	if (!find_req_seq) {
+		ret = uclass_index_find(uc, UCLASS_INDEX_SEQ, seq_or_req_seq,
+					devp);
+		if (ret != -ENOSYS) {
+			log_debug("   - %s\n", ret ? "not found" : "found");
+			return ret;
+		}
+	}
 	uclass_foreach_dev(dev, uc) {
 		log_debug("   - %d %d '%s'\n",
 			  dev->req_seq, dev->seq, dev->name);
@@ -366,6 +622,10 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	ret = uclass_index_find(uc, UCLASS_INDEX_NODE, node.of_offset, devp);
+	if (ret != -ENOSYS)
+		goto done;
+	ret = 0;
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -399,6 +659,10 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
 	if (ret)
 		return ret;
 
+	ret = uclass_index_find(uc, UCLASS_INDEX_PHANDLE, find_phandle, devp);
+	if (ret != -ENOSYS)
+		return ret;
+
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -526,6 +790,13 @@ int uclass_get_device_by_phandle_id(enum uclass_id id, uint phandle_id,
 	if (ret)
 		return ret;
 
+	if (phandle_id) {
+		ret = uclass_index_find(uc, UCLASS_INDEX_PHANDLE, phandle_id,
+					&dev);
+		if (ret != -ENOSYS)
+			return uclass_get_device_tail(dev, ret, devp);
+		ret = 0;
+	}
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -636,6 +907,7 @@ int uclass_bind_device(struct udevice *dev)
 
 	uc = dev->uclass;
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_index_bind(uc, dev);
 
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -651,6 +923,7 @@ int uclass_bind_device(struct udevice *dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+	uclass_index_unbind(uc, dev);
 
 	return ret;
 }
@@ -669,10 +942,44 @@ int uclass_unbind_device(struct udevice *dev)
 	}
 
 	list_del(&dev->uclass_node);
+	uclass_index_unbind(uc, dev);
 	return 0;
 }
 #endif
 
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass *uc = dev->uclass;
+
+	if (uc->index) {
+		uclass_index_del(uc, dev, UCLASS_INDEX_SEQ);
+		dev->seq = seq;
+		uclass_index_add(uc->index, dev, UCLASS_INDEX_SEQ);
+		return;
+	}
+#endif
+	dev->seq = seq;
+}
+
+void dev_set_ofnode(struct udevice *dev, ofnode node)
+{
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass *uc = dev->uclass;
+
+	/* the phandle comes from the node, so is reindexed too */
+	if (uc && uc->index && !list_empty(&dev->uclass_node)) {
+		uclass_index_del(uc, dev, UCLASS_INDEX_NODE);
+		uclass_index_del(uc, dev, UCLASS_INDEX_PHANDLE);
+		dev->node = node;
+		uclass_index_add(uc->index, dev, UCLASS_INDEX_NODE);
+		uclass_index_add(uc->index, dev, UCLASS_INDEX_PHANDLE);
+		return;
+	}
+#endif
+	dev->node = node;
+}
+
 int uclass_resolve_seq(struct udevice *dev)
 {
 	struct udevice *dup;
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * ARMv8 CPUs, which can be started with PSCI to run functions in U-Boot
+ */
+
+#include <common.h>
+#include <cpu.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <errno.h>
+#include <malloc.h>
+#include <asm/cache.h>
+#include <asm/system.h>
+#include <asm/armv8/secondary.h>
+#include <linux/psci.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define ARMV8_CPU_STACK_SIZE	0x4000
+#define MPIDR_HWID_BITMASK	0xff00ffffffUL
+
+/* Time allowed for a CPU to power off after running a function, in ms */
+#define ARMV8_CPU_OFF_TIMEOUT_MS	100
+
+/**
+ * struct armv8_cpu_priv - private data for an ARMv8 CPU
+ *
+ * @mpidr:	Affinity of the CPU, from its "reg" property
+ * @psci:	true if the CPU is started with PSCI
+ * @boot:	State for the CPU to start with, allocated on first use
+ * @stack:	Stack for functions run on the CPU, allocated on first use
+ * @func:	Function being run on the CPU
+ * @arg:	Argument to pass to @func
+ */
+struct armv8_cpu_priv {
+	u64 mpidr;
+	bool psci;
+	struct secondary_boot *boot;
+	void *stack;
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static int armv8_cpu_get_desc(struct udevice *dev, char *buf, int size)
+{
+	struct armv8_cpu_priv *priv = dev_get_priv(dev);
+
+	snprintf(buf, size, "ARMv8 CPU, MPIDR %#llx", priv->mpidr);
+
+	return 0;
+}
+
+static int armv8_cpu_is_current(struct udevice *dev)
+{
+	struct armv8_cpu_priv *priv = dev_get_priv(dev);
+
+	return (read_mpidr() & MPIDR_HWID_BITMASK) == priv->mpidr;
+}
+
+/* Runs on the secondary CPU, then gives it back to the PSCI firmware */
+static void armv8_cpu_secondary(void *ctx)
+{
+	struct armv8_cpu_priv *priv = ctx;
+
+	priv->func(priv->arg);
+	invoke_psci_fn(PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+}
+
+/* Set up the MMU on the secondary CPU in the same way as on this one */
+static int armv8_cpu_setup_boot(struct armv8_cpu_priv *priv)
+{
+	struct secondary_boot *boot = priv->boot;
+
+	switch (current_el()) {
+	case 2:
+		asm volatile("mrs %0, vbar_el2" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el2" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el2" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (boot->ttbr));
+		break;
+	case 1:
+		asm volatile("mrs %0, vbar_el1" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el1" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el1" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (boot->ttbr));
+		break;
+	default:
+		return -ENOSYS;
+	}
+	boot->sctlr = get_sctlr();
+	boot->sp = (ulong)priv->stack + ARMV8_CPU_STACK_SIZE;
+	boot->gd = (ulong)gd;
+	boot->func = (ulong)armv8_cpu_secondary;
+	boot->arg = (ulong)priv;
+
+	/* The CPU reads this before its MMU and caches are on */
+	flush_dcache_range((ulong)boot,
+			   (ulong)boot + roundup(sizeof(*boot), ARCH_DMA_MINALIGN));
+
+	return 0;
+}
+
+static int armv8_cpu_start(struct udevice *dev, void (*func)(void *arg),
+			   void *arg)
+{
+	struct armv8_cpu_priv *priv = dev_get_priv(dev);
+	ulong start;
+	long ret;
+
+	/* Without the MMU, the function's unaligned accesses would fault */
+	if (!priv->psci || !(get_sctlr() & CR_M))
+		return -ENOSYS;
+	if (armv8_cpu_is_current(dev))
+		return -EBUSY;
+
+	if (!priv->boot) {
+		priv->boot = memalign(ARCH_DMA_MINALIGN,
+				      roundup(sizeof(*priv->boot),
+					      ARCH_DMA_MINALIGN));
+		priv->stack = memalign(16, ARMV8_CPU_STACK_SIZE);
+		if (!priv->boot || !priv->stack)
+			return -ENOMEM;
+	}
+
+	/* It may still be powering off after running the last function */
+	start = get_timer(0);
+	while (1) {
+		ret = invoke_psci_fn(PSCI_0_2_FN64_AFFINITY_INFO, priv->mpidr,
+				     0, 0);
+		if (ret == PSCI_0_2_AFFINITY_LEVEL_OFF)
+			break;
+		if (ret < 0)
+			return -ENOSYS;
+		if (get_timer(start) > ARMV8_CPU_OFF_TIMEOUT_MS)
+			return -EBUSY;
+	}
+
+	priv->func = func;
+	priv->arg = arg;
+	ret = armv8_cpu_setup_boot(priv);
+	if (ret)
+		return ret;
+
+	ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, priv->mpidr,
+			     (ulong)secondary_entry, (ulong)priv->boot);
+	switch (ret) {
+	case PSCI_RET_SUCCESS:
+		return 0;
+	case PSCI_RET_ALREADY_ON:
+	case PSCI_RET_ON_PENDING:
+		return -EBUSY;
+	default:
+		debug("%s: CPU_ON returned %ld\n", __func__, ret);
+		return -EIO;
+	}
+}
+
+static const struct cpu_ops armv8_cpu_ops = {
+	.get_desc	= armv8_cpu_get_desc,
+	.is_current	= armv8_cpu_is_current,
+	.start		= armv8_cpu_start,
+};
+
+static int armv8_cpu_probe(struct udevice *dev)
+{
+	struct armv8_cpu_priv *priv = dev_get_priv(dev);
+	struct udevice *psci;
+	const char *method;
+
+	priv->mpidr = dev_read_addr(dev);
+
+	/* Probing the PSCI device sets up how to call the firmware */
+	method = dev_read_string(dev, "enable-method");
+	if (method && !strcmp(method, "psci") &&
+	    !uclass_get_device_by_name(UCLASS_FIRMWARE, "psci", &psci))
+		priv->psci = true;
+
+	return 0;
+}
+
+static int armv8_cpu_remove(struct udevice *dev)
+{
+	struct armv8_cpu_priv *priv = dev_get_priv(dev);
+
+	free(priv->boot);
+	free(priv->stack);
+
+	return 0;
+}
+
+static const struct udevice_id armv8_cpu_ids[] = {
+	{ .compatible = "arm,armv8" },
+	{ .compatible = "arm,cortex-a35" },
+	{ .compatible = "arm,cortex-a53" },
+	{ .compatible = "arm,cortex-a55" },
+	{ .compatible = "arm,cortex-a57" },
+	{ .compatible = "arm,cortex-a72" },
+	{ .compatible = "arm,cortex-a73" },
+	{ }
+};
+
+U_BOOT_DRIVER(armv8_cpu) = {
+	.name		= "armv8_cpu",
+	.id		= UCLASS_CPU,
+	.of_match	= armv8_cpu_ids,
+	.ops		= &armv8_cpu_ops,
+	.probe		= armv8_cpu_probe,
+	.remove		= armv8_cpu_remove,
+	.priv_auto_alloc_size = sizeof(struct armv8_cpu_priv),
+};
@@ -8,9 +8,44 @@
 #include <cpu.h>
 #include <dm.h>
 #include <errno.h>
+#include <watchdog.h>
 #include <dm/lists.h>
 #include <dm/root.h>
 
+/* Time allowed for a secondary CPU to start running a function, in ms */
+#define CPU_START_TIMEOUT_MS	1000
+
+enum cpu_job_state {
+	CPU_JOB_WAITING,	/* the secondary CPU has not picked it up */
+	CPU_JOB_STARTED,	/* the secondary CPU is running it */
+	CPU_JOB_CANCELLED,	/* cpu_wait() gave up, it must not run */
+};
+
+/**
+ * struct cpu_job - a function being run by cpu_run()
+ *
+ * @state and @done are shared with the secondary CPU, so they are accessed
+ * with acquire/release semantics. Both CPUs move @state on from
+ * CPU_JOB_WAITING with a compare-and-swap, so a job is either run or
+ * cancelled, never both.
+ *
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ * @running:	true if cpu_run() started the function and cpu_wait() has not
+ *		yet seen it finish
+ * @dead:	true if the CPU once failed to start, so is not used again
+ * @state:	State of the job (enum cpu_job_state)
+ * @done:	true once @func has returned
+ */
+struct cpu_job {
+	void (*func)(void *arg);
+	void *arg;
+	bool running;
+	bool dead;
+	int state;
+	bool done;
+};
+
 int cpu_probe_all(void)
 {
 	struct udevice *cpu;
@@ -74,6 +109,95 @@ int cpu_get_vendor(struct udevice *dev, char *buf, int size)
 	return ops->get_vendor(dev, buf, size);
 }
 
+int cpu_is_current(struct udevice *dev)
+{
+	struct cpu_ops *ops = cpu_get_ops(dev);
+
+	if (!ops->is_current)
+		return -ENOSYS;
+
+	return ops->is_current(dev);
+}
+
+/* Runs on the secondary CPU */
+static void cpu_job_entry(void *arg)
+{
+	struct cpu_job *job = arg;
+	int state = CPU_JOB_WAITING;
+
+	/* Too late: cpu_wait() has given up on this CPU */
+	if (!__atomic_compare_exchange_n(&job->state, &state, CPU_JOB_STARTED,
+					 false, __ATOMIC_ACQ_REL,
+					 __ATOMIC_ACQUIRE))
+		return;
+	job->func(job->arg);
+	__atomic_store_n(&job->done, true, __ATOMIC_RELEASE);
+}
+
+int cpu_run(struct udevice *dev, void (*func)(void *arg), void *arg)
+{
+	struct cpu_job *job = dev_get_uclass_priv(dev);
+	struct cpu_ops *ops = cpu_get_ops(dev);
+	int ret;
+
+	if (!ops->start)
+		return -ENOSYS;
+	if (job->dead)
+		return -ENODEV;
+	if (job->running || cpu_is_current(dev) == 1)
+		return -EBUSY;
+
+	job->func = func;
+	job->arg = arg;
+	job->state = CPU_JOB_WAITING;
+	job->done = false;
+	ret = ops->start(dev, cpu_job_entry, job);
+	if (ret) {
+		debug("%s: Cannot start CPU %s (err = %d)\n", __func__,
+		      dev->name, ret);
+		return ret;
+	}
+	job->running = true;
+
+	return 0;
+}
+
+int cpu_wait(struct udevice *dev)
+{
+	struct cpu_job *job = dev_get_uclass_priv(dev);
+	ulong start = get_timer(0);
+	int state = CPU_JOB_WAITING;
+
+	if (!job->running)
+		return 0;
+
+	while (__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) ==
+	       CPU_JOB_WAITING) {
+		if (get_timer(start) <= CPU_START_TIMEOUT_MS) {
+			WATCHDOG_RESET();
+			continue;
+		}
+		/* Make sure it never runs, unless it has just started */
+		if (__atomic_compare_exchange_n(&job->state, &state,
+						CPU_JOB_CANCELLED, false,
+						__ATOMIC_ACQ_REL,
+						__ATOMIC_ACQUIRE)) {
+			debug("%s: CPU %s did not start, not using it again\n",
+			      __func__, dev->name);
+			job->running = false;
+			job->dead = true;
+			return -ETIMEDOUT;
+		}
+	}
+
+	/* However long the function takes, it is known to be running */
+	while (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE))
+		WATCHDOG_RESET();
+	job->running = false;
+
+	return 0;
+}
+
 U_BOOT_DRIVER(cpu_bus) = {
 	.name	= "cpu_bus",
 	.id	= UCLASS_SIMPLE_BUS,
@@ -101,4 +225,5 @@ UCLASS_DRIVER(cpu) = {
 	.name		= "cpu",
 	.flags		= DM_UC_FLAG_SEQ_ALIAS,
 	.init		= uclass_cpu_init,
+	.per_device_auto_alloc_size = sizeof(struct cpu_job),
 };
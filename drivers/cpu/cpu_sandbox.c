@@ -7,6 +7,9 @@
 #include <common.h>
 #include <dm.h>
 #include <cpu.h>
+#include <os.h>
+#include <asm/test.h>
+#include <dm/uclass-internal.h>
 
 int cpu_sandbox_get_desc(struct udevice *dev, char *buf, int size)
 {
@@ -35,11 +38,51 @@ int cpu_sandbox_get_vendor(struct udevice *dev, char *buf, int size)
 	return 0;
 }
 
+/* The first CPU runs U-Boot, the others are emulated with host threads */
+int cpu_sandbox_is_current(struct udevice *dev)
+{
+	struct udevice *first;
+
+	uclass_find_first_device(UCLASS_CPU, &first);
+
+	return dev == first;
+}
+
+/* Set to emulate a CPU which is slow to start, holding what it was given */
+static bool cpu_sandbox_stuck;
+static void (*cpu_sandbox_func)(void *arg);
+static void *cpu_sandbox_arg;
+
+void sandbox_cpu_set_stuck(bool stuck)
+{
+	cpu_sandbox_stuck = stuck;
+	if (!stuck && cpu_sandbox_func) {
+		os_thread_create(cpu_sandbox_func, cpu_sandbox_arg);
+		cpu_sandbox_func = NULL;
+	}
+}
+
+int cpu_sandbox_start(struct udevice *dev, void (*func)(void *arg),
+		      void *arg)
+{
+	if (cpu_sandbox_is_current(dev))
+		return -EBUSY;
+	if (cpu_sandbox_stuck) {
+		cpu_sandbox_func = func;
+		cpu_sandbox_arg = arg;
+		return 0;
+	}
+
+	return os_thread_create(func, arg);
+}
+
 static const struct cpu_ops cpu_sandbox_ops = {
 	.get_desc = cpu_sandbox_get_desc,
 	.get_info = cpu_sandbox_get_info,
 	.get_count = cpu_sandbox_get_count,
 	.get_vendor = cpu_sandbox_get_vendor,
+	.is_current = cpu_sandbox_is_current,
+	.start = cpu_sandbox_start,
 };
 
 int cpu_sandbox_probe(struct udevice *dev)
@@ -13,6 +13,7 @@
 #include <asm/arch/clk.h>
 #include <asm/arch/i2c.h>
 #include <dm.h>
+#include <dm/uclass-internal.h>
 #include <mapmem.h>
 
 /*
@@ -281,7 +282,7 @@ U_BOOT_I2C_ADAP_COMPLETE(lpc32xx_2, lpc32xx_i2c_init, NULL,
 static int lpc32xx_i2c_probe(struct udevice *bus)
 {
 	struct lpc32xx_i2c_dev *dev = dev_get_platdata(bus);
-	bus->seq = dev->index;
+	uclass_set_seq(bus, dev->index);
 
 	__i2c_init(dev->base, dev->speed, 0, dev->index);
 	return 0;
@@ -17,6 +17,12 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static bool skip_timeout;
 
+/* Index of the receive buffer the next injected packet goes to */
+static int sb_eth_recv_tail(struct eth_sandbox_priv *priv)
+{
+	return (priv->recv_packet_head + priv->recv_packets) % PKTBUFSRX;
+}
+
 /*
  * sandbox_eth_disable_response()
  *
@@ -72,14 +78,16 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_rx_dropped(dev, 1);
 		return 0;
+	}
 
 	/* store this as the assumed IP of the fake host */
 	priv->fake_host_ipaddr = net_read_ip(&arp->ar_tpa);
 
 	/* Formulate a fake response */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	eth_recv = (void *)priv->recv_packet_buffer[sb_eth_recv_tail(priv)];
 	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
 	eth_recv->et_protlen = htons(PROT_ARP);
@@ -95,7 +103,7 @@ int sandbox_eth_arp_req_to_reply(struct udevice *dev, void *packet,
 	memcpy(&arp_recv->ar_tha, &arp->ar_sha, ARP_HLEN);
 	net_copy_ip(&arp_recv->ar_tpa, &arp->ar_spa);
 
-	priv->recv_packet_length[priv->recv_packets] =
+	priv->recv_packet_length[sb_eth_recv_tail(priv)] =
 		ETHER_HDR_SIZE + ARP_HDR_SIZE;
 	++priv->recv_packets;
 
@@ -134,11 +142,13 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 		return -EAGAIN;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_rx_dropped(dev, 1);
 		return 0;
+	}
 
 	/* reply to the ping */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	eth_recv = (void *)priv->recv_packet_buffer[sb_eth_recv_tail(priv)];
 	memcpy(eth_recv, packet, len);
 	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
 	icmpr = (struct icmp_hdr *)&ipr->udp_src;
@@ -154,7 +164,7 @@ int sandbox_eth_ping_req_to_reply(struct udevice *dev, void *packet,
 	icmpr->checksum = 0;
 	icmpr->checksum = compute_ip_checksum(icmpr, ICMP_HDR_SIZE);
 
-	priv->recv_packet_length[priv->recv_packets] = len;
+	priv->recv_packet_length[sb_eth_recv_tail(priv)] = len;
 	++priv->recv_packets;
 
 	return 0;
@@ -174,11 +184,13 @@ int sandbox_eth_recv_arp_req(struct udevice *dev)
 	struct arp_hdr *arp_recv;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_rx_dropped(dev, 1);
 		return -EOVERFLOW;
+	}
 
 	/* Formulate a fake request */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	eth_recv = (void *)priv->recv_packet_buffer[sb_eth_recv_tail(priv)];
 	memcpy(eth_recv->et_dest, net_bcast_ethaddr, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
 	eth_recv->et_protlen = htons(PROT_ARP);
@@ -194,7 +206,7 @@ int sandbox_eth_recv_arp_req(struct udevice *dev)
 	memcpy(&arp_recv->ar_tha, net_null_ethaddr, ARP_HLEN);
 	net_write_ip(&arp_recv->ar_tpa, net_ip);
 
-	priv->recv_packet_length[priv->recv_packets] =
+	priv->recv_packet_length[sb_eth_recv_tail(priv)] =
 		ETHER_HDR_SIZE + ARP_HDR_SIZE;
 	++priv->recv_packets;
 
@@ -216,11 +228,13 @@ int sandbox_eth_recv_ping_req(struct udevice *dev)
 	struct icmp_hdr *icmpr;
 
 	/* Don't allow the buffer to overrun */
-	if (priv->recv_packets >= PKTBUFSRX)
+	if (priv->recv_packets >= PKTBUFSRX) {
+		eth_rx_dropped(dev, 1);
 		return -EOVERFLOW;
+	}
 
 	/* Formulate a fake ping */
-	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	eth_recv = (void *)priv->recv_packet_buffer[sb_eth_recv_tail(priv)];
 
 	memcpy(eth_recv->et_dest, net_ethaddr, ARP_HLEN);
 	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
@@ -245,7 +259,7 @@ int sandbox_eth_recv_ping_req(struct udevice *dev)
 	icmpr->un.echo.sequence = htons(1);
 	icmpr->checksum = compute_ip_checksum(icmpr, ICMP_HDR_SIZE);
 
-	priv->recv_packet_length[priv->recv_packets] =
+	priv->recv_packet_length[sb_eth_recv_tail(priv)] =
 		ETHER_HDR_SIZE + IP_ICMP_HDR_SIZE;
 	++priv->recv_packets;
 
@@ -325,6 +339,7 @@ static int sb_eth_start(struct udevice *dev)
 	debug("eth_sandbox: Start\n");
 
 	priv->recv_packets = 0;
+	priv->recv_packet_head = 0;
 	for (int i = 0; i < PKTBUFSRX; i++) {
 		priv->recv_packet_buffer[i] = net_rx_packets[i];
 		priv->recv_packet_length[i] = 0;
@@ -355,32 +370,50 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	}
 
 	if (priv->recv_packets) {
-		int lcl_recv_packet_length = priv->recv_packet_length[0];
+		int head = priv->recv_packet_head;
+		int lcl_recv_packet_length = priv->recv_packet_length[head];
 
 		debug("eth_sandbox: received packet[%d], %d waiting\n",
 		      lcl_recv_packet_length, priv->recv_packets - 1);
-		*packetp = priv->recv_packet_buffer[0];
+		*packetp = priv->recv_packet_buffer[head];
 		return lcl_recv_packet_length;
 	}
 	return 0;
 }
 
+static int sb_eth_recv_batch(struct udevice *dev, int flags, uchar **packetp,
+			     int *lengths, uint *pkt_flags, int count)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i, slot;
+
+	if (skip_timeout) {
+		timer_test_add_offset(11000UL);
+		skip_timeout = false;
+	}
+
+	count = min(count, priv->recv_packets);
+	for (i = 0; i < count; i++) {
+		slot = (priv->recv_packet_head + i) % PKTBUFSRX;
+		packetp[i] = priv->recv_packet_buffer[slot];
+		lengths[i] = priv->recv_packet_length[slot];
+	}
+	debug("eth_sandbox: received %d packets, %d waiting\n", count,
+	      priv->recv_packets - count);
+
+	return count;
+}
+
 static int sb_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
-	int i;
 
 	if (!priv->recv_packets)
 		return 0;
 
+	priv->recv_packet_length[priv->recv_packet_head] = 0;
+	priv->recv_packet_head = (priv->recv_packet_head + 1) % PKTBUFSRX;
 	--priv->recv_packets;
-	for (i = 0; i < priv->recv_packets; i++) {
-		priv->recv_packet_length[i] = priv->recv_packet_length[i + 1];
-		memcpy(priv->recv_packet_buffer[i],
-		       priv->recv_packet_buffer[i + 1],
-		       priv->recv_packet_length[i + 1]);
-	}
-	priv->recv_packet_length[priv->recv_packets] = 0;
 
 	return 0;
 }
@@ -403,6 +436,7 @@ static const struct eth_ops sb_eth_ops = {
 	.start			= sb_eth_start,
 	.send			= sb_eth_send,
 	.recv			= sb_eth_recv,
+	.recv_batch		= sb_eth_recv_batch,
 	.free_pkt		= sb_eth_free_pkt,
 	.stop			= sb_eth_stop,
 	.write_hwaddr		= sb_eth_write_hwaddr,
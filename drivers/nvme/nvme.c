@@ -14,13 +14,13 @@
 #include <dm/device-internal.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+/* The I/O queue holds up to NVME_Q_DEPTH - 1 commands in flight */
+#define NVME_Q_DEPTH		32
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -46,6 +46,9 @@ struct nvme_queue {
 	u16 qid;
 	u8 cq_phase;
 	u8 cqe_seen;
+	/* slots of I/O commands which timed out but have not completed */
+	u16 nr_stale;
+	bool stale[NVME_Q_DEPTH];
 	unsigned long cmdid_data[];
 };
 
@@ -67,7 +70,13 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/* Get the PRP list for an I/O command, given its slot in the queue */
+static u64 *nvme_prp_list(struct nvme_dev *dev, int slot)
+{
+	return (void *)dev->prp_pool + slot * dev->prp_list_size;
+}
+
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2, u64 *prp_list,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
@@ -76,7 +85,6 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = (page_size >> 3) - 1;
-	u32 num_pages;
 
 	length -= (page_size - offset);
 
@@ -94,39 +102,48 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	}
 
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
-
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
+	if (nprps > dev->prp_entry_num)
+		return -E2BIG;
 
-	prp_pool = dev->prp_pool;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
-		if (i == ((page_size >> 3) - 1)) {
+		/* The last entry of a full page points to the next page */
+		if (i == prps_per_page && nprps > 1) {
 			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += page_size >> 3;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
+
+	flush_dcache_range((ulong)prp_list,
+			   (ulong)prp_list + dev->prp_list_size);
+
+	return 0;
+}
+
+/* Allocate a PRP list for each I/O command which can be in flight */
+static int nvme_alloc_prp_pool(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = (page_size >> 3) - 1;
+	u32 nprps, num_pages;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	/* The first page of a transfer is in PRP1, not in the list */
+	nprps = max(1U << dev->max_transfer_shift, page_size) / page_size;
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
+
+	dev->prp_list_size = num_pages * page_size;
+	dev->prp_pool = memalign(page_size,
+				 (dev->q_depth - 1) * dev->prp_list_size);
+	if (!dev->prp_pool)
+		return -ENOMEM;
+	dev->prp_entry_num = prps_per_page * num_pages;
 
 	return 0;
 }
@@ -149,12 +166,14 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue
+ *
+ * The controller does not see the command until nvme_ring_sq() is called.
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	u16 tail = nvmeq->sq_tail;
 
@@ -164,10 +183,83 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+/**
+ * nvme_ring_sq() - ring the doorbell for the commands copied into a queue
+ *
+ * @nvmeq:	The queue to use
+ */
+static void nvme_ring_sq(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	nvme_ring_sq(nvmeq);
+}
+
+/**
+ * nvme_reap_cqes() - collect the completions posted to a queue
+ *
+ * This waits for at least one completion, then takes all those which are
+ * ready, up to @max. The controller is told about them with a single
+ * doorbell write.
+ *
+ * @nvmeq:	The queue to use
+ * @cqes:	Returns the completions, as written by the controller
+ * @max:	Maximum number of completions to collect
+ * @timeout:	Timeout to wait for the first completion, as for
+ *		nvme_submit_sync_cmd()
+ * @return number of completions collected, or -ETIMEDOUT if none
+ */
+static int nvme_reap_cqes(struct nvme_queue *nvmeq,
+			  struct nvme_completion *cqes, int max,
+			  unsigned timeout)
+{
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	u16 status;
+	ulong start_time;
+	ulong timeout_us = timeout * 100000;
+	int count = 0;
+
+	start_time = timer_get_us();
+
+	while (count < max) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) != phase) {
+			if (count)
+				break;
+			if (timeout_us > 0 && (timer_get_us() - start_time)
+			    >= timeout_us)
+				return -ETIMEDOUT;
+			continue;
+		}
+		memcpy(&cqes[count++], &nvmeq->cqes[head], sizeof(*cqes));
+
+		if (++head == nvmeq->q_depth) {
+			head = 0;
+			phase = !phase;
+		}
+	}
+
+	writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
+	nvmeq->cq_head = head;
+	nvmeq->cq_phase = phase;
+
+	return count;
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -251,6 +343,8 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 
 	nvmeq->cq_head = 0;
 	nvmeq->cq_phase = 1;
+	nvmeq->nr_stale = 0;
+	memset(nvmeq->stale, '\0', sizeof(nvmeq->stale));
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	nvmeq->q_depth = depth;
 	nvmeq->qid = qid;
@@ -615,14 +709,8 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		 * and is reported as a power of two (2^n).
 		 *
 		 * The spec also says: a value of 0h indicates no restrictions
-		 * on transfer size. But in nvme_blk_read/write() below we have
-		 * the following algorithm for maximum number of logic blocks
-		 * per transfer:
-		 *
-		 * u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-		 *
-		 * In order for lbas not to overflow, the maximum number is 15
-		 * which means dev->max_transfer_shift = 15 + 9 (ns->lba_shift).
+		 * on transfer size. But nvme_blk_rw() below needs a PRP list
+		 * for each command in flight, sized for the maximum transfer.
 		 * Let's use 20 which provides 1MB size.
 		 */
 		dev->max_transfer_shift = 20;
@@ -706,64 +794,128 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/*
+ * Transfers are split into commands of up to the maximum transfer size, with
+ * as many in flight as the I/O queue holds. Each command uses its slot in
+ * the queue as its command ID, which selects its PRP list. If a command
+ * fails, no more are sent, and the blocks before the first failure are
+ * reported as transferred.
+ *
+ * Commands which time out still belong to the controller, which may yet
+ * complete them, so their slots are marked stale and not reused until their
+ * completions arrive.
+ */
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_completion cqes[NVME_Q_DEPTH];
+	u64 slot_lba[NVME_Q_DEPTH];
+	bool busy[NVME_Q_DEPTH] = { false };
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
-	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
+	void *buf = buffer;
+	u64 prp2;
 
 	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	u64 end = blknr + blkcnt;
+	u64 fail = end;
+	u32 lbas, max_lbas;
+	int slots = nvmeq->q_depth - 1;
+	int inflight = 0;
+	bool queued;
+	int i, count;
+	u16 id;
+
+	/* The length field has 16 bits */
+	max_lbas = min(1U << (dev->max_transfer_shift - ns->lba_shift),
+		       0x10000U);
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+
+	while (inflight || (slba < end && fail == end)) {
+		queued = false;
+		for (i = 0; i < slots && slba < end && fail == end; i++) {
+			if (busy[i] || nvmeq->stale[i])
+				continue;
+			lbas = min_t(u64, end - slba, max_lbas);
+			if (nvme_setup_prps(dev, &prp2, nvme_prp_list(dev, i),
+					    lbas << ns->lba_shift,
+					    (ulong)buf)) {
+				fail = slba;
+				break;
+			}
+			c.rw.command_id = cpu_to_le16(i);
+			c.rw.slba = cpu_to_le64(slba);
+			c.rw.length = cpu_to_le16(lbas - 1);
+			c.rw.prp1 = cpu_to_le64((ulong)buf);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, &c);
+			busy[i] = true;
+			slot_lba[i] = slba;
+			inflight++;
+			queued = true;
+
+			slba += lbas;
+			buf += lbas << ns->lba_shift;
 		}
+		if (queued)
+			nvme_ring_sq(nvmeq);
+		/* Otherwise every slot is stale, so wait for one to free up */
+		if (!inflight && (slba >= end || fail != end))
+			break;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, (ulong)buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64((ulong)buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		count = nvme_reap_cqes(nvmeq, cqes, inflight + nvmeq->nr_stale,
+				       IO_TIMEOUT);
+		if (count < 0) {
+			/* Nothing still in flight can be relied on */
+			fail = min(fail, slba);
+			for (i = 0; i < slots; i++) {
+				if (!busy[i])
+					continue;
+				fail = min(fail, slot_lba[i]);
+				nvmeq->stale[i] = true;
+				nvmeq->nr_stale++;
+			}
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		buffer += lbas << ns->lba_shift;
+		}
+		for (i = 0; i < count; i++) {
+			id = le16_to_cpu(cqes[i].command_id);
+			if (id < slots && nvmeq->stale[id]) {
+				debug("%s: late completion of command %d\n",
+				      __func__, id);
+				nvmeq->stale[id] = false;
+				nvmeq->nr_stale--;
+				continue;
+			}
+			if (id >= slots || !busy[id]) {
+				printf("ERROR: unexpected command id %d\n", id);
+				continue;
+			}
+			busy[id] = false;
+			inflight--;
+			if (le16_to_cpu(cqes[i].status) >> 1) {
+				printf("ERROR: status = %x, lba = %llx\n",
+				       le16_to_cpu(cqes[i].status) >> 1,
+				       slot_lba[id]);
+				fail = min(fail, slot_lba[id]);
+			}
+		}
 	}
 
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
 					(unsigned long)buffer + total_len);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return fail - blknr;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -834,21 +986,19 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page size and maximum transfer are known */
+	ret = nvme_alloc_prp_pool(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	return 0;
 
 free_queue:
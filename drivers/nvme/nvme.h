@@ -626,6 +626,7 @@ struct nvme_dev {
 	u8 vwc;
 	u64 *prp_pool;
 	u32 prp_entry_num;
+	u32 prp_list_size;
 	u32 nn;
 };
 
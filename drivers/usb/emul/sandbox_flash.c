@@ -9,16 +9,27 @@
 #include <os.h>
 #include <scsi.h>
 #include <usb.h>
+#include <asm/unaligned.h>
 
 /*
  * This driver emulates a flash stick using the UFI command specification and
  * the BBB (bulk/bulk/bulk) protocol. It supports only a single logical unit
  * number (LUN 0).
+ *
+ * With the "sandbox,uas" property it also offers USB Attached SCSI as
+ * alternate setting 1 of its interface, without streams as on a high-speed
+ * port. With "sandbox,lba-base" the backing file appears a second time at
+ * that block, so that a small file can stand in for a disk which needs
+ * 16-byte commands.
  */
 
 enum {
 	SANDBOX_FLASH_EP_OUT		= 1,	/* endpoints */
 	SANDBOX_FLASH_EP_IN		= 2,
+	SANDBOX_FLASH_EP_UAS_CMD	= 3,	/* UAS endpoints */
+	SANDBOX_FLASH_EP_UAS_STATUS	= 4,
+	SANDBOX_FLASH_EP_UAS_IN		= 5,
+	SANDBOX_FLASH_EP_UAS_OUT	= 6,
 	SANDBOX_FLASH_BLOCK_LEN		= 512,
 };
 
@@ -43,7 +54,10 @@ enum {
  * @alloc_len:	Allocation length from the last incoming command
  * @transfer_len: Transfer length from CBW header
  * @read_len:	Number of blocks of data left in the current read command
+ * @write_len:	Number of blocks of data left in the current write command
  * @tag:	Tag value from last command
+ * @alt:	Alternate setting of the interface: 0 for BBB, 1 for UAS
+ * @uas_ready:	true if the UAS Read Ready or Write Ready IU has been sent
  * @fd:		File descriptor of backing file
  * @file_size:	Size of file in bytes
  * @status_buff:	Data buffer for outgoing status
@@ -55,8 +69,11 @@ struct sandbox_flash_priv {
 	int alloc_len;
 	int transfer_len;
 	int read_len;
+	int write_len;
 	enum cmd_phase phase;
 	u32 tag;
+	int alt;
+	bool uas_ready;
 	int fd;
 	loff_t file_size;
 	struct umass_bbb_csw status;
@@ -64,8 +81,18 @@ struct sandbox_flash_priv {
 	u8 buff[512];
 };
 
+/**
+ * struct sandbox_flash_plat - platform data for this driver
+ *
+ * @pathname:	Path of the backing file
+ * @uas:	true to offer UAS as alternate setting 1
+ * @lba_base:	Block at which the backing file appears again, 0 if none
+ * @flash_strings: USB strings
+ */
 struct sandbox_flash_plat {
 	const char *pathname;
+	bool uas;
+	u64 lba_base;
 	struct usb_string flash_strings[STRINGID_COUNT];
 };
 
@@ -86,6 +113,12 @@ struct scsi_read_capacity_resp {
 	u32 block_len;
 };
 
+struct scsi_read_capacity16_resp {
+	u64 last_block_addr;
+	u32 block_len;
+	u8 spare[20];
+};
+
 struct __packed scsi_read10_req {
 	u8 cmd;
 	u8 lun_flags;
@@ -95,6 +128,15 @@ struct __packed scsi_read10_req {
 	u8 spare2[3];
 };
 
+struct __packed scsi_read16_req {
+	u8 cmd;
+	u8 lun_flags;
+	u64 lba;
+	u32 transfer_len;
+	u8 spare;
+	u8 control;
+};
+
 static struct usb_device_descriptor flash_device_desc = {
 	.bLength =		sizeof(flash_device_desc),
 	.bDescriptorType =	USB_DT_DEVICE,
@@ -167,10 +209,133 @@ static void *flash_desc_list[] = {
 	NULL,
 };
 
+/* A flash stick offering UAS has its own config, as wTotalLength differs */
+static struct usb_config_descriptor flash_uas_config0 = {
+	.bLength		= sizeof(flash_uas_config0),
+	.bDescriptorType	= USB_DT_CONFIG,
+
+	/* wTotalLength is set up by usb-emul-uclass */
+	.bNumInterfaces		= 1,
+	.bConfigurationValue	= 0,
+	.iConfiguration		= 0,
+	.bmAttributes		= 1 << 7,
+	.bMaxPower		= 50,
+};
+
+static struct usb_interface_descriptor flash_uas_interface0_alt0 = {
+	.bLength		= sizeof(flash_uas_interface0_alt0),
+	.bDescriptorType	= USB_DT_INTERFACE,
+
+	.bInterfaceNumber	= 0,
+	.bAlternateSetting	= 0,
+	.bNumEndpoints		= 2,
+	.bInterfaceClass	= USB_CLASS_MASS_STORAGE,
+	.bInterfaceSubClass	= US_SC_SCSI,
+	.bInterfaceProtocol	= US_PR_BULK,
+	.iInterface		= 0,
+};
+
+static struct usb_interface_descriptor flash_uas_interface0_alt1 = {
+	.bLength		= sizeof(flash_uas_interface0_alt1),
+	.bDescriptorType	= USB_DT_INTERFACE,
+
+	.bInterfaceNumber	= 0,
+	.bAlternateSetting	= 1,
+	.bNumEndpoints		= 4,
+	.bInterfaceClass	= USB_CLASS_MASS_STORAGE,
+	.bInterfaceSubClass	= US_SC_SCSI,
+	.bInterfaceProtocol	= US_PR_UAS,
+	.iInterface		= 0,
+};
+
+static struct usb_endpoint_descriptor flash_uas_endpoint_cmd = {
+	.bLength		= USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType	= USB_DT_ENDPOINT,
+
+	.bEndpointAddress	= SANDBOX_FLASH_EP_UAS_CMD,
+	.bmAttributes		= USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize		= __constant_cpu_to_le16(512),
+	.bInterval		= 0,
+};
+
+static struct uas_pipe_usage_desc flash_uas_usage_cmd = {
+	.bLength		= sizeof(flash_uas_usage_cmd),
+	.bDescriptorType	= USB_DT_PIPE_USAGE,
+	.bPipeID		= UAS_PIPE_ID_CMD,
+};
+
+static struct usb_endpoint_descriptor flash_uas_endpoint_status = {
+	.bLength		= USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType	= USB_DT_ENDPOINT,
+
+	.bEndpointAddress	= SANDBOX_FLASH_EP_UAS_STATUS |
+				  USB_ENDPOINT_DIR_MASK,
+	.bmAttributes		= USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize		= __constant_cpu_to_le16(512),
+	.bInterval		= 0,
+};
+
+static struct uas_pipe_usage_desc flash_uas_usage_status = {
+	.bLength		= sizeof(flash_uas_usage_status),
+	.bDescriptorType	= USB_DT_PIPE_USAGE,
+	.bPipeID		= UAS_PIPE_ID_STATUS,
+};
+
+static struct usb_endpoint_descriptor flash_uas_endpoint_in = {
+	.bLength		= USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType	= USB_DT_ENDPOINT,
+
+	.bEndpointAddress	= SANDBOX_FLASH_EP_UAS_IN | USB_ENDPOINT_DIR_MASK,
+	.bmAttributes		= USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize		= __constant_cpu_to_le16(512),
+	.bInterval		= 0,
+};
+
+static struct uas_pipe_usage_desc flash_uas_usage_in = {
+	.bLength		= sizeof(flash_uas_usage_in),
+	.bDescriptorType	= USB_DT_PIPE_USAGE,
+	.bPipeID		= UAS_PIPE_ID_DATA_IN,
+};
+
+static struct usb_endpoint_descriptor flash_uas_endpoint_out = {
+	.bLength		= USB_DT_ENDPOINT_SIZE,
+	.bDescriptorType	= USB_DT_ENDPOINT,
+
+	.bEndpointAddress	= SANDBOX_FLASH_EP_UAS_OUT,
+	.bmAttributes		= USB_ENDPOINT_XFER_BULK,
+	.wMaxPacketSize		= __constant_cpu_to_le16(512),
+	.bInterval		= 0,
+};
+
+static struct uas_pipe_usage_desc flash_uas_usage_out = {
+	.bLength		= sizeof(flash_uas_usage_out),
+	.bDescriptorType	= USB_DT_PIPE_USAGE,
+	.bPipeID		= UAS_PIPE_ID_DATA_OUT,
+};
+
+static void *flash_uas_desc_list[] = {
+	&flash_device_desc,
+	&flash_uas_config0,
+	&flash_uas_interface0_alt0,
+	&flash_endpoint0_out,
+	&flash_endpoint1_in,
+	&flash_uas_interface0_alt1,
+	&flash_uas_endpoint_cmd,
+	&flash_uas_usage_cmd,
+	&flash_uas_endpoint_status,
+	&flash_uas_usage_status,
+	&flash_uas_endpoint_in,
+	&flash_uas_usage_in,
+	&flash_uas_endpoint_out,
+	&flash_uas_usage_out,
+	NULL,
+};
+
 static int sandbox_flash_control(struct udevice *dev, struct usb_device *udev,
 				 unsigned long pipe, void *buff, int len,
 				 struct devrequest *setup)
 {
+	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
 	struct sandbox_flash_priv *priv = dev_get_priv(dev);
 
 	if (pipe == usb_rcvctrlpipe(udev, 0)) {
@@ -185,6 +350,19 @@ static int sandbox_flash_control(struct udevice *dev, struct usb_device *udev,
 			debug("request=%x\n", setup->request);
 			break;
 		}
+	} else if (pipe == usb_sndctrlpipe(udev, 0)) {
+		switch (setup->request) {
+		case USB_REQ_SET_INTERFACE:
+			if (le16_to_cpu(setup->value) > (plat->uas ? 1 : 0))
+				break;
+			priv->alt = le16_to_cpu(setup->value);
+			priv->phase = PHASE_START;
+			priv->error = false;
+			return 0;
+		default:
+			debug("request=%x\n", setup->request);
+			break;
+		}
 	}
 	debug("pipe=%lx\n", pipe);
 
@@ -223,12 +401,29 @@ static void setup_response(struct sandbox_flash_priv *priv, void *resp,
 	priv->buff_used = size;
 }
 
-static void handle_read(struct sandbox_flash_priv *priv, ulong lba,
+/* Get the number of blocks of the emulated disk */
+static u64 flash_get_blocks(struct sandbox_flash_plat *plat,
+			    struct sandbox_flash_priv *priv)
+{
+	return plat->lba_base + priv->file_size / SANDBOX_FLASH_BLOCK_LEN;
+}
+
+/* Seek to a block, which may be in the second copy of the file */
+static void flash_seek(struct sandbox_flash_plat *plat,
+		       struct sandbox_flash_priv *priv, u64 lba)
+{
+	if (plat->lba_base && lba >= plat->lba_base)
+		lba -= plat->lba_base;
+	os_lseek(priv->fd, lba * SANDBOX_FLASH_BLOCK_LEN, OS_SEEK_SET);
+}
+
+static void handle_read(struct sandbox_flash_plat *plat,
+			struct sandbox_flash_priv *priv, u64 lba,
 			ulong transfer_len)
 {
-	debug("%s: lba=%lx, transfer_len=%lx\n", __func__, lba, transfer_len);
+	debug("%s: lba=%llx, transfer_len=%lx\n", __func__, lba, transfer_len);
 	if (priv->fd != -1) {
-		os_lseek(priv->fd, lba * SANDBOX_FLASH_BLOCK_LEN, OS_SEEK_SET);
+		flash_seek(plat, priv, lba);
 		priv->read_len = transfer_len;
 		setup_response(priv, priv->buff,
 			       transfer_len * SANDBOX_FLASH_BLOCK_LEN);
@@ -237,6 +432,20 @@ static void handle_read(struct sandbox_flash_priv *priv, ulong lba,
 	}
 }
 
+static void handle_write(struct sandbox_flash_plat *plat,
+			 struct sandbox_flash_priv *priv, u64 lba,
+			 ulong transfer_len)
+{
+	debug("%s: lba=%llx, transfer_len=%lx\n", __func__, lba, transfer_len);
+	if (priv->fd != -1) {
+		flash_seek(plat, priv, lba);
+		priv->write_len = transfer_len;
+		setup_response(priv, NULL, 0);
+	} else {
+		setup_fail_response(priv);
+	}
+}
+
 static int handle_ufi_command(struct sandbox_flash_plat *plat,
 			      struct sandbox_flash_priv *priv, const void *buff,
 			      int len)
@@ -266,24 +475,62 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 		break;
 	case SCSI_RD_CAPAC: {
 		struct scsi_read_capacity_resp *resp = (void *)priv->buff;
-		uint blocks;
-
-		if (priv->file_size)
-			blocks = priv->file_size / SANDBOX_FLASH_BLOCK_LEN - 1;
-		else
-			blocks = 0;
+		u64 blocks;
+
+		blocks = flash_get_blocks(plat, priv);
+		if (blocks)
+			blocks--;
+		/* Tell the host to use READ CAPACITY(16) */
+		if (blocks > 0xffffffff)
+			blocks = 0xffffffff;
 		resp->last_block_addr = cpu_to_be32(blocks);
 		resp->block_len = cpu_to_be32(SANDBOX_FLASH_BLOCK_LEN);
 		setup_response(priv, resp, sizeof(*resp));
 		break;
 	}
+	case SCSI_RD_CAPAC16: {
+		struct scsi_read_capacity16_resp *resp = (void *)priv->buff;
+		u64 blocks;
+
+		blocks = flash_get_blocks(plat, priv);
+		if (blocks)
+			blocks--;
+		priv->alloc_len = get_unaligned_be32(&req->cmd[10]);
+		memset(resp, '\0', sizeof(*resp));
+		resp->last_block_addr = cpu_to_be64(blocks);
+		resp->block_len = cpu_to_be32(SANDBOX_FLASH_BLOCK_LEN);
+		setup_response(priv, resp, sizeof(*resp));
+		break;
+	}
 	case SCSI_READ10: {
 		struct scsi_read10_req *req = (void *)buff;
 
-		handle_read(priv, be32_to_cpu(req->lba),
+		handle_read(plat, priv, be32_to_cpu(req->lba),
 			    be16_to_cpu(req->transfer_len));
 		break;
 	}
+	case SCSI_READ16: {
+		struct scsi_read16_req *req = (void *)buff;
+
+		handle_read(plat, priv, be64_to_cpu(req->lba),
+			    be32_to_cpu(req->transfer_len));
+		break;
+	}
+	case SCSI_WRITE10: {
+		/* WRITE(10) has the same layout as READ(10) */
+		struct scsi_read10_req *req = (void *)buff;
+
+		handle_write(plat, priv, be32_to_cpu(req->lba),
+			     be16_to_cpu(req->transfer_len));
+		break;
+	}
+	case SCSI_WRITE16: {
+		struct scsi_read16_req *req = (void *)buff;
+
+		handle_write(plat, priv, be64_to_cpu(req->lba),
+			     be32_to_cpu(req->transfer_len));
+		break;
+	}
 	default:
 		debug("Command not supported: %x\n", req->cmd[0]);
 		return -EPROTONOSUPPORT;
@@ -293,61 +540,86 @@ static int handle_ufi_command(struct sandbox_flash_plat *plat,
 	return 0;
 }
 
-static int sandbox_flash_bulk(struct udevice *dev, struct usb_device *udev,
-			      unsigned long pipe, void *buff, int len)
+/* Send data to the host in the data phase */
+static int handle_data_in(struct sandbox_flash_priv *priv, void *buff,
+			  int len)
+{
+	debug("data in, len=%x, alloc_len=%x, priv->read_len=%x\n",
+	      len, priv->alloc_len, priv->read_len);
+	if (priv->read_len) {
+		ulong bytes_read;
+
+		bytes_read = os_read(priv->fd, buff, len);
+		if (bytes_read != len)
+			return -EIO;
+		priv->read_len -= len / SANDBOX_FLASH_BLOCK_LEN;
+		if (!priv->read_len)
+			priv->phase = PHASE_STATUS;
+	} else {
+		if (priv->alloc_len && len > priv->alloc_len)
+			len = priv->alloc_len;
+		memcpy(buff, priv->buff, len);
+		priv->phase = PHASE_STATUS;
+	}
+
+	return len;
+}
+
+/* Accept data from the host in the data phase */
+static int handle_data_out(struct sandbox_flash_priv *priv, const void *buff,
+			   int len)
+{
+	debug("data out, len=%x, priv->write_len=%x\n", len, priv->write_len);
+	/* The command failed, so drop the data; the status says so */
+	if (!priv->write_len) {
+		priv->phase = PHASE_STATUS;
+		return len;
+	}
+	if (os_write(priv->fd, buff, len) != len)
+		return -EIO;
+	priv->write_len -= len / SANDBOX_FLASH_BLOCK_LEN;
+	if (priv->write_len <= 0)
+		priv->phase = PHASE_STATUS;
+
+	return len;
+}
+
+static int sandbox_flash_bulk_bbb(struct udevice *dev, int ep, void *buff,
+				  int len)
 {
 	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
 	struct sandbox_flash_priv *priv = dev_get_priv(dev);
-	int ep = usb_pipeendpoint(pipe);
 	struct umass_bbb_cbw *cbw = buff;
 
-	debug("%s: dev=%s, pipe=%lx, ep=%x, len=%x, phase=%d\n", __func__,
-	      dev->name, pipe, ep, len, priv->phase);
 	switch (ep) {
 	case SANDBOX_FLASH_EP_OUT:
 		switch (priv->phase) {
 		case PHASE_START:
 			priv->alloc_len = 0;
 			priv->read_len = 0;
+			priv->write_len = 0;
 			if (priv->error || len != UMASS_BBB_CBW_SIZE ||
 			    cbw->dCBWSignature != CBWSIGNATURE)
 				goto err;
 			if ((cbw->bCBWFlags & CBWFLAGS_SBZ) ||
 			    cbw->bCBWLUN != 0)
 				goto err;
-			if (cbw->bCDBLength < 1 || cbw->bCDBLength >= 0x10)
+			if (cbw->bCDBLength < 1 || cbw->bCDBLength > 0x10)
 				goto err;
 			priv->transfer_len = cbw->dCBWDataTransferLength;
 			priv->tag = cbw->dCBWTag;
 			return handle_ufi_command(plat, priv, cbw->CBWCDB,
 						  cbw->bCDBLength);
 		case PHASE_DATA:
-			debug("data out\n");
-			break;
+			return handle_data_out(priv, buff, len);
 		default:
 			break;
 		}
+		break;
 	case SANDBOX_FLASH_EP_IN:
 		switch (priv->phase) {
 		case PHASE_DATA:
-			debug("data in, len=%x, alloc_len=%x, priv->read_len=%x\n",
-			      len, priv->alloc_len, priv->read_len);
-			if (priv->read_len) {
-				ulong bytes_read;
-
-				bytes_read = os_read(priv->fd, buff, len);
-				if (bytes_read != len)
-					return -EIO;
-				priv->read_len -= len / SANDBOX_FLASH_BLOCK_LEN;
-				if (!priv->read_len)
-					priv->phase = PHASE_STATUS;
-			} else {
-				if (priv->alloc_len && len > priv->alloc_len)
-					len = priv->alloc_len;
-				memcpy(buff, priv->buff, len);
-				priv->phase = PHASE_STATUS;
-			}
-			return len;
+			return handle_data_in(priv, buff, len);
 		case PHASE_STATUS:
 			debug("status in, len=%x\n", len);
 			if (len > sizeof(priv->status))
@@ -365,11 +637,102 @@ err:
 	return 0;
 }
 
+/*
+ * With UAS the command comes on its own pipe. Without streams, the status
+ * pipe then gives a Read Ready or Write Ready IU if the command has data,
+ * and a Sense IU once it is done.
+ */
+static int sandbox_flash_bulk_uas(struct udevice *dev, int ep, void *buff,
+				  int len)
+{
+	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
+	struct sandbox_flash_priv *priv = dev_get_priv(dev);
+	struct uas_command_iu *cmd = buff;
+	struct uas_sense_iu *sense = buff;
+	int ret, size;
+
+	switch (ep) {
+	case SANDBOX_FLASH_EP_UAS_CMD:
+		if (priv->phase != PHASE_START || len < UAS_COMMAND_IU_SIZE ||
+		    cmd->iu_id != UAS_IU_COMMAND)
+			break;
+		priv->alloc_len = 0;
+		priv->read_len = 0;
+		priv->write_len = 0;
+		priv->buff_used = 0;
+		priv->transfer_len = 0;
+		priv->uas_ready = false;
+		priv->tag = be16_to_cpu(cmd->tag);
+		ret = handle_ufi_command(plat, priv, cmd->cdb, sizeof(cmd->cdb));
+		if (ret)
+			setup_fail_response(priv);
+		else if (priv->status.bCSWStatus == CSWSTATUS_GOOD &&
+			 (priv->buff_used || priv->write_len))
+			priv->phase = PHASE_DATA;
+		else
+			priv->phase = PHASE_STATUS;
+		return len;
+	case SANDBOX_FLASH_EP_UAS_STATUS:
+		if (priv->phase == PHASE_START || len < UAS_SENSE_IU_SIZE)
+			break;
+		memset(sense, '\0', len);
+		sense->tag = cpu_to_be16(priv->tag);
+		if (priv->phase == PHASE_DATA) {
+			if (priv->uas_ready)
+				break;
+			sense->iu_id = priv->write_len ? UAS_IU_WRITE_READY :
+				       UAS_IU_READ_READY;
+			priv->uas_ready = true;
+			return 4;
+		}
+		sense->iu_id = UAS_IU_SENSE;
+		size = offsetof(struct uas_sense_iu, sense);
+		if (priv->status.bCSWStatus != CSWSTATUS_GOOD) {
+			/* CHECK CONDITION, with fixed-format sense data */
+			sense->status = 2;
+			sense->len = cpu_to_be16(18);
+			sense->sense[0] = 0x70;
+			sense->sense[2] = 0x05;	/* ILLEGAL REQUEST */
+			sense->sense[7] = 10;
+			size += 18;
+		}
+		priv->phase = PHASE_START;
+		return size;
+	case SANDBOX_FLASH_EP_UAS_IN:
+		if (priv->phase != PHASE_DATA || !priv->uas_ready ||
+		    priv->write_len)
+			break;
+		return handle_data_in(priv, buff, len);
+	case SANDBOX_FLASH_EP_UAS_OUT:
+		if (priv->phase != PHASE_DATA || !priv->uas_ready)
+			break;
+		return handle_data_out(priv, buff, len);
+	}
+	debug("%s: Detected transfer error\n", __func__);
+
+	return -EIO;
+}
+
+static int sandbox_flash_bulk(struct udevice *dev, struct usb_device *udev,
+			      unsigned long pipe, void *buff, int len)
+{
+	struct sandbox_flash_priv *priv = dev_get_priv(dev);
+	int ep = usb_pipeendpoint(pipe);
+
+	debug("%s: dev=%s, pipe=%lx, ep=%x, len=%x, phase=%d\n", __func__,
+	      dev->name, pipe, ep, len, priv->phase);
+	if (priv->alt)
+		return sandbox_flash_bulk_uas(dev, ep, buff, len);
+
+	return sandbox_flash_bulk_bbb(dev, ep, buff, len);
+}
+
 static int sandbox_flash_ofdata_to_platdata(struct udevice *dev)
 {
 	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
 
 	plat->pathname = dev_read_string(dev, "sandbox,filepath");
+	plat->lba_base = dev_read_u64_default(dev, "sandbox,lba-base", 0);
 
 	return 0;
 }
@@ -387,7 +750,11 @@ static int sandbox_flash_bind(struct udevice *dev)
 	fs[2].id = STRINGID_SERIAL;
 	fs[2].s = dev->name;
 
-	return usb_emul_setup_device(dev, plat->flash_strings, flash_desc_list);
+	plat->uas = dev_read_bool(dev, "sandbox,uas");
+
+	return usb_emul_setup_device(dev, plat->flash_strings,
+				     plat->uas ? flash_uas_desc_list :
+				     flash_desc_list);
 }
 
 static int sandbox_flash_probe(struct udevice *dev)
@@ -395,7 +762,10 @@ static int sandbox_flash_probe(struct udevice *dev)
 	struct sandbox_flash_plat *plat = dev_get_platdata(dev);
 	struct sandbox_flash_priv *priv = dev_get_priv(dev);
 
-	priv->fd = os_open(plat->pathname, OS_O_RDONLY);
+	/* Writes fail if the file cannot be opened for writing */
+	priv->fd = os_open(plat->pathname, OS_O_RDWR);
+	if (priv->fd == -1)
+		priv->fd = os_open(plat->pathname, OS_O_RDONLY);
 	if (priv->fd != -1)
 		return os_get_filesize(plat->pathname, &priv->file_size);
 
@@ -66,16 +66,34 @@ int submit_control_msg(struct usb_device *udev, unsigned long pipe,
 	return err;
 }
 
+static void usb_update_stats(struct usb_device *udev, unsigned long pipe,
+			     int ret)
+{
+#ifdef CONFIG_USB_STATS
+	struct usb_ep_stats *stats = usb_pipe_stats(udev, pipe);
+
+	stats->transfers++;
+	if (ret < 0 || udev->status)
+		stats->errors++;
+	if (ret >= 0)
+		stats->bytes += udev->act_len;
+#endif
+}
+
 int submit_bulk_msg(struct usb_device *udev, unsigned long pipe, void *buffer,
 		    int length)
 {
 	struct udevice *bus = udev->controller_dev;
 	struct dm_usb_ops *ops = usb_get_ops(bus);
+	int ret;
 
 	if (!ops->bulk)
 		return -ENOSYS;
 
-	return ops->bulk(bus, udev, pipe, buffer, length);
+	ret = ops->bulk(bus, udev, pipe, buffer, length);
+	usb_update_stats(udev, pipe, ret);
+
+	return ret;
 }
 
 struct int_queue *create_int_queue(struct usb_device *udev,
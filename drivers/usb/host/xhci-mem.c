@@ -76,7 +76,7 @@ static void xhci_segment_free(struct xhci_segment *seg)
  * @param ptr	pointer to "ring" to be freed
  * @return none
  */
-static void xhci_ring_free(struct xhci_ring *ring)
+void xhci_ring_free(struct xhci_ring *ring)
 {
 	struct xhci_segment *seg;
 	struct xhci_segment *first_seg;
@@ -308,6 +308,7 @@ struct xhci_ring *xhci_ring_alloc(unsigned int num_segs, bool link_trbs)
 	ring = (struct xhci_ring *)malloc(sizeof(struct xhci_ring));
 	BUG_ON(!ring);
 
+	ring->num_segs = num_segs;
 	if (num_segs == 0)
 		return ring;
 
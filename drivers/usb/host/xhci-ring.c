@@ -382,24 +382,6 @@ static void giveback_first_trb(struct usb_device *udev, int ep_index,
 
 /**** POLLING mechanism for XHCI ****/
 
-/**
- * Finalizes a handled event TRB by advancing our dequeue pointer and giving
- * the TRB back to the hardware for recycling. Must call this exactly once at
- * the end of each event handler, and not touch the TRB again afterwards.
- *
- * @param ctrl	Host controller data structure
- * @return none
- */
-void xhci_acknowledge_event(struct xhci_ctrl *ctrl)
-{
-	/* Advance our dequeue pointer to the next event */
-	inc_deq(ctrl, ctrl->event_ring);
-
-	/* Inform the hardware */
-	xhci_writeq(&ctrl->ir_set->erst_dequeue,
-		(uintptr_t)ctrl->event_ring->dequeue | ERST_EHB);
-}
-
 /**
  * Checks if there is a new event to handle on the event ring.
  *
@@ -423,6 +405,31 @@ static int event_ready(struct xhci_ctrl *ctrl)
 	return 1;
 }
 
+/**
+ * Finalizes a handled event TRB by advancing our dequeue pointer and giving
+ * the TRB back to the hardware for recycling. Must call this exactly once at
+ * the end of each event handler, and not touch the TRB again afterwards.
+ * If more events are already waiting, the hardware is told when the last of
+ * them is handled.
+ *
+ * @param ctrl	Host controller data structure
+ * @return none
+ */
+void xhci_acknowledge_event(struct xhci_ctrl *ctrl)
+{
+	/* Advance our dequeue pointer to the next event */
+	inc_deq(ctrl, ctrl->event_ring);
+
+	/*
+	 * Inform the hardware once we have caught up with it, rather than
+	 * writing the dequeue pointer back for each event in a batch
+	 */
+	if (event_ready(ctrl))
+		return;
+	xhci_writeq(&ctrl->ir_set->erst_dequeue,
+		(uintptr_t)ctrl->event_ring->dequeue | ERST_EHB);
+}
+
 /**
  * Waits for a specific type of event and returns it. Discards unexpected
  * events. Caller *must* call xhci_acknowledge_event() after it is finished
@@ -542,6 +549,37 @@ static void record_transfer_result(struct usb_device *udev,
 	}
 }
 
+/**
+ * Works out how much data a TD transferred when it ended with a short packet.
+ * The transfer event then points to the TRB which received the short packet
+ * and gives the residue of that TRB only, so add the lengths of the TRBs
+ * before it in the TD.
+ *
+ * @param start_trb	pointer to the first TRB of the TD
+ * @param event		transfer event for the TD
+ * @return number of bytes transferred
+ */
+int xhci_td_actual_len(union xhci_trb *start_trb, union xhci_trb *event)
+{
+	union xhci_trb *last = (union xhci_trb *)(uintptr_t)
+		le64_to_cpu(event->trans_event.buffer);
+	union xhci_trb *trb = start_trb;
+	int len = 0;
+
+	while (trb != last) {
+		if (TRB_TYPE_LINK_LE32(trb->link.control)) {
+			trb = (union xhci_trb *)(uintptr_t)
+				le64_to_cpu(trb->link.segment_ptr);
+			continue;
+		}
+		len += le32_to_cpu(trb->generic.field[2]) & TRB_LEN_MASK;
+		trb++;
+	}
+	len += le32_to_cpu(trb->generic.field[2]) & TRB_LEN_MASK;
+
+	return len - EVENT_TRB_LEN(le32_to_cpu(event->trans_event.transfer_len));
+}
+
 /**** Bulk and Control transfer methods ****/
 /**
  * Queues up the BULK Request
@@ -613,6 +651,20 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		running_total += TRB_MAX_BUFF_SIZE;
 	}
 
+	/*
+	 * The whole TD goes on the ring at once, so it must fit, leaving out
+	 * the link TRB at the end of each segment
+	 */
+	if (num_trbs > ring->num_segs * (TRBS_PER_SEGMENT - 1)) {
+		debug("XHCI bulk transfer of %d bytes needs too many TRBs\n",
+		      length);
+		return -EINVAL;
+	}
+#ifdef CONFIG_USB_STATS
+	if (usb_pipebulk(pipe))
+		usb_pipe_stats(udev, pipe)->descs += num_trbs;
+#endif
+
 	/*
 	 * XXX: Calling routine prepare_ring() called in place of
 	 * prepare_trasfer() as there in 'Linux' since we are not
@@ -728,6 +780,10 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		buffer > (size_t)length);
 
 	record_transfer_result(udev, event, length);
+	if (GET_COMP_CODE(le32_to_cpu(event->trans_event.transfer_len)) ==
+	    COMP_SHORT_TX)
+		udev->act_len = xhci_td_actual_len((union xhci_trb *)start_trb,
+						   event);
 	xhci_acknowledge_event(ctrl);
 	xhci_inval_cache((uintptr_t)buffer, length);
 
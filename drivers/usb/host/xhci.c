@@ -570,8 +570,10 @@ static int xhci_set_configuration(struct usb_device *udev)
 		ep_index = xhci_get_ep_index(endpt_desc);
 		ep_ctx[ep_index] = xhci_get_ep_ctx(ctrl, in_ctx, ep_index);
 
-		/* Allocate the ep rings */
-		virt_dev->eps[ep_index].ring = xhci_ring_alloc(1, true);
+		/* Allocate the ep rings, with room for large bulk transfers */
+		virt_dev->eps[ep_index].ring = xhci_ring_alloc(
+			usb_endpoint_xfer_bulk(endpt_desc) ? BULK_RING_SEGS : 1,
+			true);
 		if (!virt_dev->eps[ep_index].ring)
 			return -ENOMEM;
 
@@ -1471,13 +1473,17 @@ static int xhci_update_hub_device(struct udevice *dev, struct usb_device *udev)
 static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
 	/*
-	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
-	 * and the last TRB in this segment is configured as a link TRB to form
-	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
-	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
-	 * Hence the maximum number of TRBs we can use in one transfer is 62.
+	 * xHCD allocates BULK_RING_SEGS segments of 64 TRBs for each bulk
+	 * endpoint and the last TRB in each segment is a link TRB, which
+	 * joins the segments into a TRB ring. Each TRB can transfer up to 64K
+	 * bytes, however data buffers referenced by transfer TRBs shall not
+	 * span 64KB boundaries, so an unaligned buffer needs one more TRB
+	 * than its size suggests. Hence the maximum number of full TRBs we
+	 * can use in one transfer is 62 per segment, plus 1 for each segment
+	 * after the first.
 	 */
-	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
+	*size = (BULK_RING_SEGS * (TRBS_PER_SEGMENT - 1) - 1) *
+		TRB_MAX_BUFF_SIZE;
 
 	return 0;
 }
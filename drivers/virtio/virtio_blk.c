@@ -10,48 +10,171 @@
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
+#include <linux/sizes.h>
 #include "virtio_blk.h"
 
+/* Largest segment used when the device does not set a limit */
+#define VIRTIO_BLK_SEG_SIZE	SZ_4M
+
+/**
+ * struct virtio_blk_req - a request which may be in flight
+ *
+ * @out_hdr:	Header read by the device, which must be first since the
+ *		virtqueue returns its address when the request is done
+ * @sector:	First sector of the request
+ * @status:	Status written by the device
+ * @busy:	true if the request is in flight
+ */
+struct virtio_blk_req {
+	struct virtio_blk_outhdr out_hdr;
+	u64 sector;
+	u8 status;
+	bool busy;
+};
+
+/**
+ * struct virtio_blk_priv - private data for a virtio block device
+ *
+ * @vq:		Request queue
+ * @reqs:	Requests, enough to fill the queue
+ * @num_reqs:	Number of requests in @reqs
+ * @sg:		Data segments of the request being added
+ * @sgs:	Header, data segments and status of the request being added
+ * @max_segs:	Maximum number of data segments in a request
+ * @seg_size:	Maximum size of each segment in bytes, a multiple of 512
+ */
 struct virtio_blk_priv {
 	struct virtqueue *vq;
+	struct virtio_blk_req *reqs;
+	uint num_reqs;
+	struct virtio_sg *sg;
+	struct virtio_sg **sgs;
+	uint max_segs;
+	u32 seg_size;
 };
 
-static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
-			       lbaint_t blkcnt, void *buffer, u32 type)
+static const u32 feature[] = {
+	VIRTIO_BLK_F_SIZE_MAX,
+	VIRTIO_BLK_F_SEG_MAX,
+};
+
+static struct virtio_blk_req *virtio_blk_get_req(struct virtio_blk_priv *priv)
+{
+	uint i;
+
+	for (i = 0; i < priv->num_reqs; i++) {
+		if (!priv->reqs[i].busy)
+			return &priv->reqs[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Add a request for as much of the transfer as fits, returning the number
+ * of sectors added, or 0 if the queue is full
+ */
+static lbaint_t virtio_blk_add_req(struct udevice *dev, u64 sector,
+				   lbaint_t blkcnt, void *buffer, u32 type)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_req *req;
 	unsigned int num_out = 0, num_in = 0;
-	struct virtio_sg *sgs[3];
-	u8 status;
-	int ret;
+	struct virtio_sg hdr_sg, status_sg;
+	u64 len = (u64)blkcnt * 512;
+	lbaint_t count = 0;
+	uint nsg, i;
 
-	struct virtio_blk_outhdr out_hdr = {
-		.type = cpu_to_virtio32(dev, type),
-		.sector = cpu_to_virtio64(dev, sector),
-	};
-	struct virtio_sg hdr_sg = { &out_hdr, sizeof(out_hdr) };
-	struct virtio_sg data_sg = { buffer, blkcnt * 512 };
-	struct virtio_sg status_sg = { &status, sizeof(status) };
+	req = virtio_blk_get_req(priv);
+	if (!req)
+		return 0;
 
-	sgs[num_out++] = &hdr_sg;
+	for (nsg = 0; nsg < priv->max_segs && len; nsg++) {
+		priv->sg[nsg].addr = buffer;
+		priv->sg[nsg].length = min_t(u64, len, priv->seg_size);
+		buffer += priv->sg[nsg].length;
+		len -= priv->sg[nsg].length;
+		count += priv->sg[nsg].length / 512;
+	}
+	if (!virtqueue_has_room(priv->vq, nsg + 2))
+		return 0;
 
-	if (type & VIRTIO_BLK_T_OUT)
-		sgs[num_out++] = &data_sg;
-	else
-		sgs[num_out + num_in++] = &data_sg;
+	req->out_hdr.type = cpu_to_virtio32(dev, type);
+	req->out_hdr.ioprio = 0;
+	req->out_hdr.sector = cpu_to_virtio64(dev, sector);
+	req->sector = sector;
+	req->status = VIRTIO_BLK_S_IOERR;
+	hdr_sg.addr = &req->out_hdr;
+	hdr_sg.length = sizeof(req->out_hdr);
+	status_sg.addr = &req->status;
+	status_sg.length = sizeof(req->status);
 
-	sgs[num_out + num_in++] = &status_sg;
+	priv->sgs[num_out++] = &hdr_sg;
+	for (i = 0; i < nsg; i++) {
+		if (type & VIRTIO_BLK_T_OUT)
+			priv->sgs[num_out++] = &priv->sg[i];
+		else
+			priv->sgs[num_out + num_in++] = &priv->sg[i];
+	}
+	priv->sgs[num_out + num_in++] = &status_sg;
 
-	ret = virtqueue_add(priv->vq, sgs, num_out, num_in);
-	if (ret)
-		return ret;
+	if (virtqueue_add(priv->vq, priv->sgs, num_out, num_in))
+		return 0;
+	req->busy = true;
 
-	virtqueue_kick(priv->vq);
+	return count;
+}
 
-	while (!virtqueue_get_buf(priv->vq, NULL))
-		;
+/*
+ * The transfer is split into requests which fit the device's limits. As
+ * many as possible are added to the queue before it is kicked, then all
+ * those which are done are collected before adding more. If a request
+ * fails, no more are added, and the sectors before the first failure are
+ * reported as transferred.
+ */
+static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
+			       lbaint_t blkcnt, void *buffer, u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_outhdr *hdr;
+	struct virtio_blk_req *req;
+	u64 start = sector, end = sector + blkcnt, fail = end;
+	uint inflight = 0;
+	lbaint_t count;
+	bool queued;
+
+	while (inflight || (sector < end && fail == end)) {
+		queued = false;
+		while (sector < end && fail == end) {
+			count = virtio_blk_add_req(dev, sector, end - sector,
+						   buffer, type);
+			if (!count)
+				break;
+			sector += count;
+			buffer += count * 512;
+			inflight++;
+			queued = true;
+		}
+		if (queued)
+			virtqueue_kick(priv->vq);
+		if (!inflight) {
+			/* Nothing could be added, so give up */
+			fail = min(fail, sector);
+			break;
+		}
+
+		while (!(hdr = virtqueue_get_buf(priv->vq, NULL)))
+			;
+		do {
+			req = container_of(hdr, struct virtio_blk_req, out_hdr);
+			req->busy = false;
+			inflight--;
+			if (req->status != VIRTIO_BLK_S_OK)
+				fail = min(fail, req->sector);
+		} while ((hdr = virtqueue_get_buf(priv->vq, NULL)));
+	}
 
-	return status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+	return fail - start;
 }
 
 static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
@@ -68,6 +191,16 @@ static ulong virtio_blk_write(struct udevice *dev, lbaint_t start,
 				 VIRTIO_BLK_T_OUT);
 }
 
+static void virtio_blk_free(struct virtio_blk_priv *priv)
+{
+	free(priv->reqs);
+	free(priv->sg);
+	free(priv->sgs);
+	priv->reqs = NULL;
+	priv->sg = NULL;
+	priv->sgs = NULL;
+}
+
 static int virtio_blk_bind(struct udevice *dev)
 {
 	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev->parent);
@@ -97,7 +230,8 @@ static int virtio_blk_bind(struct udevice *dev)
 	desc->bdev = dev;
 
 	/* Indicate what driver features we support */
-	virtio_driver_features_init(uc_priv, NULL, 0, NULL, 0);
+	virtio_driver_features_init(uc_priv, feature, ARRAY_SIZE(feature),
+				    feature, ARRAY_SIZE(feature));
 
 	return 0;
 }
@@ -106,6 +240,8 @@ static int virtio_blk_probe(struct udevice *dev)
 {
 	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	u32 seg_max, size_max;
+	uint vring_size;
 	u64 cap;
 	int ret;
 
@@ -117,9 +253,47 @@ static int virtio_blk_probe(struct udevice *dev)
 	virtio_cread(dev, struct virtio_blk_config, capacity, &cap);
 	desc->lba = cap;
 
+	/* Use requests as large as the device allows */
+	priv->max_segs = 1;
+	if (!virtio_cread_feature(dev, VIRTIO_BLK_F_SEG_MAX,
+				  struct virtio_blk_config, seg_max, &seg_max) &&
+	    seg_max)
+		priv->max_segs = seg_max;
+	vring_size = virtqueue_get_vring_size(priv->vq);
+	if (!virtio_has_feature(dev, VIRTIO_RING_F_INDIRECT_DESC))
+		priv->max_segs = min(priv->max_segs, max(vring_size, 3U) - 2);
+	priv->seg_size = VIRTIO_BLK_SEG_SIZE;
+	if (!virtio_cread_feature(dev, VIRTIO_BLK_F_SIZE_MAX,
+				  struct virtio_blk_config, size_max,
+				  &size_max) && size_max >= 512)
+		priv->seg_size = min_t(u32, size_max & ~511, priv->seg_size);
+	debug("(%s): %u segments of up to %u bytes\n", dev->name,
+	      priv->max_segs, priv->seg_size);
+
+	priv->num_reqs = vring_size;
+	priv->reqs = calloc(priv->num_reqs, sizeof(*priv->reqs));
+	priv->sg = calloc(priv->max_segs, sizeof(*priv->sg));
+	priv->sgs = calloc(priv->max_segs + 2, sizeof(*priv->sgs));
+	if (!priv->reqs || !priv->sg || !priv->sgs) {
+		virtio_blk_free(priv);
+		virtio_del_vqs(dev);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
+static int virtio_blk_remove(struct udevice *dev)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = virtio_reset(dev);
+	virtio_blk_free(priv);
+
+	return ret;
+}
+
 static const struct blk_ops virtio_blk_ops = {
 	.read	= virtio_blk_read,
 	.write	= virtio_blk_write,
@@ -131,7 +305,7 @@ U_BOOT_DRIVER(virtio_blk) = {
 	.ops	= &virtio_blk_ops,
 	.bind	= virtio_blk_bind,
 	.probe	= virtio_blk_probe,
-	.remove	= virtio_reset,
+	.remove	= virtio_blk_remove,
 	.priv_auto_alloc_size = sizeof(struct virtio_blk_priv),
 	.flags	= DM_FLAG_ACTIVE_DMA,
 };
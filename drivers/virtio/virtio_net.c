@@ -12,15 +12,28 @@
 #include <virtio_ring.h>
 #include "virtio_net.h"
 
-/* Amount of buffers to keep in the RX virtqueue */
-#define VIRTIO_NET_NUM_RX_BUFS	32
-
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
  * 14 for the Ethernet header, 12 for virtio_net_hdr. In total 1526 bytes.
+ * A larger packet, e.g. with a VLAN tag, only fits if the device can merge
+ * buffers.
  */
 #define VIRTIO_NET_RX_BUF_SIZE	1526
 
+/**
+ * struct virtio_net_priv - private data for a virtio net device
+ *
+ * @rx_vq:	Receive queue
+ * @tx_vq:	Transmit queue
+ * @rx_buff:	Receive buffers, each VIRTIO_NET_RX_BUF_SIZE bytes
+ * @rx_bufs:	Number of receive buffers
+ * @rx_added:	Number of buffers given back to the receive queue since the
+ *		device was last told about them
+ * @rx_merged:	Packet copied from several buffers, PKTSIZE_ALIGN bytes
+ * @rx_running:	true if the receive buffers have been set up
+ * @mergeable:	true if a packet can be received in several buffers
+ * @net_hdr_len: Size of the header before each packet
+ */
 struct virtio_net_priv {
 	union {
 		struct virtqueue *vqs[2];
@@ -30,42 +43,59 @@ struct virtio_net_priv {
 		};
 	};
 
-	char rx_buff[VIRTIO_NET_NUM_RX_BUFS][VIRTIO_NET_RX_BUF_SIZE];
+	char *rx_buff;
+	uint rx_bufs;
+	uint rx_added;
+	uchar *rx_merged;
 	bool rx_running;
+	bool mergeable;
 	int net_hdr_len;
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
  * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
  * we should assume the link is always active.
+ *
+ * With VIRTIO_NET_F_GUEST_CSUM the device reports packets whose checksum it
+ * has checked, so that the network stack need not do so again. It may also
+ * pass on packets from the host with only a partial checksum, which are
+ * treated in the same way since they have not crossed a wire.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
 static const u32 feature_legacy[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
+	VIRTIO_NET_F_GUEST_CSUM,
 };
 
+/* Give a receive buffer back to the device */
+static void virtio_net_rx_refill(struct virtio_net_priv *priv, void *buf)
+{
+	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
+	struct virtio_sg *sgs[] = { &sg };
+
+	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	priv->rx_added++;
+}
+
 static int virtio_net_start(struct udevice *dev)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_sg sg;
-	struct virtio_sg *sgs[] = { &sg };
 	int i;
 
 	if (!priv->rx_running) {
-		/* receive buffer length is always 1526 */
-		sg.length = VIRTIO_NET_RX_BUF_SIZE;
-
 		/* setup the receive buffer address */
-		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
-			sg.addr = priv->rx_buff[i];
-			virtqueue_add(priv->rx_vq, sgs, 0, 1);
-		}
+		for (i = 0; i < priv->rx_bufs; i++)
+			virtio_net_rx_refill(priv, priv->rx_buff +
+					     i * VIRTIO_NET_RX_BUF_SIZE);
 
 		virtqueue_kick(priv->rx_vq);
+		priv->rx_added = 0;
 
 		/* setup the receive queue only once */
 		priv->rx_running = true;
@@ -106,29 +136,143 @@ static int virtio_net_send(struct udevice *dev, void *packet, int length)
 	return 0;
 }
 
-static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
+/*
+ * Copy a packet which the device split over @num buffers, starting with @buf
+ * holding @len bytes, into priv->rx_merged. The buffers are given back to
+ * the device. Returns the length of the packet, or 0 if it is dropped.
+ */
+static int virtio_net_rx_merge(struct udevice *dev, void *buf, uint len,
+			       uint num, uchar **packetp)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
+	uint skip = priv->net_hdr_len;
+	uint total = 0;
+	bool fits = true;
+
+	for (;;) {
+		if (total + len - skip > PKTSIZE_ALIGN)
+			fits = false;
+		else
+			memcpy(priv->rx_merged + total, buf + skip, len - skip);
+		total += len - skip;
+		virtio_net_rx_refill(priv, buf);
+		if (!--num)
+			break;
+
+		/* The device makes all the buffers used at once */
+		buf = virtqueue_get_buf(priv->rx_vq, &len);
+		if (!buf)
+			return 0;
+		skip = 0;
+	}
+	if (!fits) {
+		debug("(%s): dropping %u byte packet\n", dev->name, total);
+		return 0;
+	}
+	*packetp = priv->rx_merged;
+
+	return total;
+}
+
+/*
+ * Take the next packet from the receive queue, setting @pkt_flags from its
+ * header. Returns its length, 0 if it is dropped, or -EAGAIN if there is
+ * none.
+ */
+static int virtio_net_rx_packet(struct udevice *dev, uchar **packetp,
+				uint *pkt_flags)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_net_hdr_v1 *hdr;
 	unsigned int len;
+	uint num = 1;
 	void *buf;
 
 	buf = virtqueue_get_buf(priv->rx_vq, &len);
 	if (!buf)
 		return -EAGAIN;
+	if (len < priv->net_hdr_len) {
+		virtio_net_rx_refill(priv, buf);
+		return 0;
+	}
+
+	/* The flags are at the start of both the legacy and v1 headers */
+	hdr = buf;
+	if (hdr->flags & (VIRTIO_NET_HDR_F_NEEDS_CSUM |
+			  VIRTIO_NET_HDR_F_DATA_VALID))
+		*pkt_flags |= ETH_PKT_CSUM_VALID;
+	if (priv->mergeable)
+		num = virtio16_to_cpu(dev, hdr->num_buffers);
+	if (num > 1)
+		return virtio_net_rx_merge(dev, buf, len, num, packetp);
 
 	*packetp = buf + priv->net_hdr_len;
+
 	return len - priv->net_hdr_len;
 }
 
+/* Tell the device about buffers given back since the last poll */
+static void virtio_net_rx_kick(struct virtio_net_priv *priv)
+{
+	if (priv->rx_added) {
+		virtqueue_kick(priv->rx_vq);
+		priv->rx_added = 0;
+	}
+}
+
+static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	uint pkt_flags = 0;
+	int ret;
+
+	virtio_net_rx_kick(priv);
+	do {
+		ret = virtio_net_rx_packet(dev, packetp, &pkt_flags);
+		if (!ret)
+			eth_rx_dropped(dev, 1);
+	} while (!ret);
+
+	return ret;
+}
+
+static int virtio_net_recv_batch(struct udevice *dev, int flags,
+				 uchar **packetp, int *lengths, uint *pkt_flags,
+				 int count)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int i, ret;
+
+	virtio_net_rx_kick(priv);
+	for (i = 0; i < count; ) {
+		ret = virtio_net_rx_packet(dev, &packetp[i], &pkt_flags[i]);
+		if (ret < 0)
+			break;
+		if (!ret) {
+			pkt_flags[i] = 0;
+			eth_rx_dropped(dev, 1);
+			continue;
+		}
+		lengths[i++] = ret;
+
+		/* There is only one buffer for merged packets */
+		if (packetp[i - 1] == priv->rx_merged)
+			break;
+	}
+
+	return i;
+}
+
 static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	void *buf = packet - priv->net_hdr_len;
-	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
-	struct virtio_sg *sgs[] = { &sg };
+
+	/* The buffers of a merged packet were given back when copying it */
+	if (packet == priv->rx_merged)
+		return 0;
 
 	/* Put the buffer back to the rx ring */
-	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	virtio_net_rx_refill(priv, packet - priv->net_hdr_len);
 
 	return 0;
 }
@@ -191,6 +335,14 @@ static int virtio_net_bind(struct udevice *dev)
 	return 0;
 }
 
+static void virtio_net_free(struct virtio_net_priv *priv)
+{
+	free(priv->rx_buff);
+	free(priv->rx_merged);
+	priv->rx_buff = NULL;
+	priv->rx_merged = NULL;
+}
+
 static int virtio_net_probe(struct udevice *dev)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
@@ -208,18 +360,45 @@ static int virtio_net_probe(struct udevice *dev)
 	 * VIRTIO_NET_F_MRG_RXBUF was negotiated. Without that feature
 	 * the structure was 2 bytes shorter.
 	 */
-	if (uc_priv->legacy)
+	priv->mergeable = virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF);
+	if (uc_priv->legacy && !priv->mergeable)
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr);
 	else
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr_v1);
 
+	/* Each buffer takes one descriptor */
+	priv->rx_bufs = min_t(uint, CONFIG_VIRTIO_NET_RX_BUFS,
+			      virtqueue_get_vring_size(priv->rx_vq));
+	priv->rx_buff = malloc(priv->rx_bufs * VIRTIO_NET_RX_BUF_SIZE);
+	if (priv->mergeable)
+		priv->rx_merged = malloc(PKTSIZE_ALIGN);
+	if (!priv->rx_buff || (priv->mergeable && !priv->rx_merged)) {
+		virtio_net_free(priv);
+		virtio_del_vqs(dev);
+		return -ENOMEM;
+	}
+	debug("(%s): %u receive buffers%s\n", dev->name, priv->rx_bufs,
+	      priv->mergeable ? ", mergeable" : "");
+
 	return 0;
 }
 
+static int virtio_net_remove(struct udevice *dev)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = virtio_reset(dev);
+	virtio_net_free(priv);
+
+	return ret;
+}
+
 static const struct eth_ops virtio_net_ops = {
 	.start = virtio_net_start,
 	.send = virtio_net_send,
 	.recv = virtio_net_recv,
+	.recv_batch = virtio_net_recv_batch,
 	.free_pkt = virtio_net_free_pkt,
 	.stop = virtio_net_stop,
 	.write_hwaddr = virtio_net_write_hwaddr,
@@ -231,7 +410,7 @@ U_BOOT_DRIVER(virtio_net) = {
 	.id	= UCLASS_ETH,
 	.bind	= virtio_net_bind,
 	.probe	= virtio_net_probe,
-	.remove = virtio_reset,
+	.remove = virtio_net_remove,
 	.ops	= &virtio_net_ops,
 	.priv_auto_alloc_size = sizeof(struct virtio_net_priv),
 	.platdata_auto_alloc_size = sizeof(struct eth_pdata),
@@ -13,21 +13,52 @@
 #include <virtio.h>
 #include <virtio_ring.h>
 
+static struct vring_desc *alloc_indirect(struct virtqueue *vq,
+					 unsigned int total_sg)
+{
+	struct vring_desc *desc;
+	unsigned int i;
+
+	desc = malloc(total_sg * sizeof(struct vring_desc));
+	if (!desc)
+		return NULL;
+
+	/* The table is used as a chain, like the ring itself */
+	for (i = 0; i < total_sg; i++)
+		desc[i].next = cpu_to_virtio16(vq->vdev, i + 1);
+
+	return desc;
+}
+
 int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 		  unsigned int out_sgs, unsigned int in_sgs)
 {
 	struct vring_desc *desc;
 	unsigned int total_sg = out_sgs + in_sgs;
 	unsigned int i, n, avail, descs_used, uninitialized_var(prev);
+	bool indirect;
 	int head;
 
 	WARN_ON(total_sg == 0);
 
 	head = vq->free_head;
 
-	desc = vq->vring.desc;
-	i = head;
-	descs_used = total_sg;
+	/* A buffer in several parts can use just one descriptor in the ring */
+	if (vq->indir_desc && total_sg > 1 && vq->num_free)
+		desc = alloc_indirect(vq, total_sg);
+	else
+		desc = NULL;
+
+	if (desc) {
+		indirect = true;
+		i = 0;
+		descs_used = 1;
+	} else {
+		indirect = false;
+		desc = vq->vring.desc;
+		i = head;
+		descs_used = total_sg;
+	}
 
 	if (vq->num_free < descs_used) {
 		debug("Can't add buf len %i - avail = %i\n",
@@ -67,11 +98,25 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 	/* Last one doesn't continue */
 	desc[prev].flags &= cpu_to_virtio16(vq->vdev, ~VRING_DESC_F_NEXT);
 
+	if (indirect) {
+		vq->vring.desc[head].flags = cpu_to_virtio16(vq->vdev,
+						VRING_DESC_F_INDIRECT);
+		vq->vring.desc[head].addr = cpu_to_virtio64(vq->vdev,
+						(u64)(uintptr_t)desc);
+		vq->vring.desc[head].len = cpu_to_virtio32(vq->vdev,
+					total_sg * sizeof(struct vring_desc));
+		vq->indir_desc[head] = desc;
+	}
+
 	/* We're using some buffers from the free list. */
 	vq->num_free -= descs_used;
 
 	/* Update free pointer */
-	vq->free_head = i;
+	if (indirect)
+		vq->free_head = virtio16_to_cpu(vq->vdev,
+						vq->vring.desc[head].next);
+	else
+		vq->free_head = i;
 
 	/*
 	 * Put entry in available array (but don't update avail->idx
@@ -99,6 +144,14 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 	return 0;
 }
 
+bool virtqueue_has_room(struct virtqueue *vq, unsigned int total_sg)
+{
+	if (vq->indir_desc && total_sg > 1)
+		return vq->num_free >= 1;
+
+	return vq->num_free >= total_sg;
+}
+
 static bool virtqueue_kick_prepare(struct virtqueue *vq)
 {
 	u16 new, old;
@@ -136,6 +189,12 @@ static void detach_buf(struct virtqueue *vq, unsigned int head)
 	unsigned int i;
 	__virtio16 nextflag = cpu_to_virtio16(vq->vdev, VRING_DESC_F_NEXT);
 
+	/* An indirect table only uses the descriptor pointing to it */
+	if (vq->indir_desc && vq->indir_desc[head]) {
+		free(vq->indir_desc[head]);
+		vq->indir_desc[head] = NULL;
+	}
+
 	/* Put back on free list: unmap first-level descriptors and find end */
 	i = head;
 
@@ -161,6 +220,7 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 {
 	unsigned int i;
 	u16 last_used;
+	__virtio64 addr;
 
 	if (!more_used(vq)) {
 		debug("(%s.%d): No more buffers in queue\n",
@@ -186,6 +246,12 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		return NULL;
 	}
 
+	/* Return the first buffer, whether or not it is in an indirect table */
+	if (vq->indir_desc && vq->indir_desc[i])
+		addr = vq->indir_desc[i][0].addr;
+	else
+		addr = vq->vring.desc[i].addr;
+
 	detach_buf(vq, i);
 	vq->last_used_idx++;
 	/*
@@ -197,8 +263,7 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		virtio_store_mb(&vring_used_event(&vq->vring),
 				cpu_to_virtio16(vq->vdev, vq->last_used_idx));
 
-	return (void *)(uintptr_t)virtio64_to_cpu(vq->vdev,
-						  vq->vring.desc[i].addr);
+	return (void *)(uintptr_t)virtio64_to_cpu(vq->vdev, addr);
 }
 
 static struct virtqueue *__vring_new_virtqueue(unsigned int index,
@@ -226,6 +291,11 @@ static struct virtqueue *__vring_new_virtqueue(unsigned int index,
 
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
 
+	/* If this cannot be allocated, just use the ring for every buffer */
+	vq->indir_desc = NULL;
+	if (virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC))
+		vq->indir_desc = calloc(vring.num, sizeof(*vq->indir_desc));
+
 	/* Tell other side not to bother us */
 	vq->avail_flags_shadow |= VRING_AVAIL_F_NO_INTERRUPT;
 	if (!vq->event)
@@ -287,6 +357,13 @@ struct virtqueue *vring_create_virtqueue(unsigned int index, unsigned int num,
 
 void vring_del_virtqueue(struct virtqueue *vq)
 {
+	unsigned int i;
+
+	if (vq->indir_desc) {
+		for (i = 0; i < vq->vring.num; i++)
+			free(vq->indir_desc[i]);
+		free(vq->indir_desc);
+	}
 	free(vq->vring.desc);
 	list_del(&vq->list);
 	free(vq);
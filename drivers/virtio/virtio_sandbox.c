@@ -10,8 +10,17 @@
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
+#include <asm/test.h>
 #include <linux/compat.h>
 #include <linux/io.h>
+#include "virtio_blk.h"
+#include "virtio_net.h"
+
+/* Size of the disk emulated by virtio-sandbox-blk, in sectors */
+#define SANDBOX_BLK_SECTORS	64
+
+/* Most descriptors in a request to the emulated disk */
+#define SANDBOX_BLK_MAX_DESCS	16
 
 struct virtio_sandbox_priv {
 	u8 id;
@@ -21,11 +30,25 @@ struct virtio_sandbox_priv {
 	ulong queue_desc;
 	ulong queue_available;
 	ulong queue_used;
+	uint queue_num;
+	union {
+		struct virtio_blk_config blk;
+		struct virtio_net_config net;
+	} config;
+	u8 *disk;
+	u16 last_avail[2];
+	int notify_count;
 };
 
 static int virtio_sandbox_get_config(struct udevice *udev, unsigned int offset,
 				     void *buf, unsigned int len)
 {
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+
+	if (offset + len > sizeof(priv->config))
+		return -EINVAL;
+	memcpy(buf, (u8 *)&priv->config + offset, len);
+
 	return 0;
 }
 
@@ -94,7 +117,7 @@ static struct virtqueue *virtio_sandbox_setup_vq(struct udevice *udev,
 	int err;
 
 	/* Create the vring */
-	vq = vring_create_virtqueue(index, 4, 4096, udev);
+	vq = vring_create_virtqueue(index, priv->queue_num, 4096, udev);
 	if (!vq) {
 		err = -ENOMEM;
 		goto error_new_virtqueue;
@@ -134,8 +157,11 @@ static int virtio_sandbox_del_vqs(struct udevice *udev)
 static int virtio_sandbox_find_vqs(struct udevice *udev, unsigned int nvqs,
 				   struct virtqueue *vqs[])
 {
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
 	int i;
 
+	memset(priv->last_avail, '\0', sizeof(priv->last_avail));
+
 	for (i = 0; i < nvqs; ++i) {
 		vqs[i] = virtio_sandbox_setup_vq(udev, i);
 		if (IS_ERR(vqs[i])) {
@@ -159,6 +185,7 @@ static int virtio_sandbox_probe(struct udevice *udev)
 
 	/* fake some information for testing */
 	priv->device_features = VIRTIO_F_VERSION_1;
+	priv->queue_num = 4;
 	uc_priv->device = VIRTIO_ID_BLOCK;
 	uc_priv->vendor = ('u' << 24) | ('b' << 16) | ('o' << 8) | 't';
 
@@ -177,6 +204,109 @@ static int virtio_sandbox_child_post_remove(struct udevice *vdev)
 	return 0;
 }
 
+/*
+ * Carry out a request to the emulated disk, checking that it keeps to the
+ * limits in the config. Returns the number of bytes written to the buffer.
+ */
+static u32 virtio_sandbox_blk_req(struct virtio_sandbox_priv *priv,
+				  struct virtqueue *vq, uint head)
+{
+	struct udevice *vdev = vq->vdev;
+	struct vring_desc *desc = vq->vring.desc;
+	struct vring_desc *chain[SANDBOX_BLK_MAX_DESCS];
+	struct virtio_blk_outhdr *hdr;
+	uint i = head, n = 0, seg;
+	u8 status = VIRTIO_BLK_S_OK;
+	u32 written = 1;
+	u64 start, offset;
+	u8 *addr;
+	u32 len;
+
+	if (virtio16_to_cpu(vdev, desc[head].flags) & VRING_DESC_F_INDIRECT) {
+		desc = (void *)(uintptr_t)virtio64_to_cpu(vdev,
+							  desc[head].addr);
+		i = 0;
+	}
+	for (;;) {
+		if (n == SANDBOX_BLK_MAX_DESCS)
+			return 0;
+		chain[n++] = &desc[i];
+		if (!(virtio16_to_cpu(vdev, desc[i].flags) & VRING_DESC_F_NEXT))
+			break;
+		i = virtio16_to_cpu(vdev, desc[i].next);
+	}
+	if (n < 3)
+		return 0;
+
+	hdr = (void *)(uintptr_t)virtio64_to_cpu(vdev, chain[0]->addr);
+	start = virtio64_to_cpu(vdev, hdr->sector) * 512;
+
+	/* Check the whole request first, so that a bad one has no effect */
+	offset = start;
+	if (n - 2 > priv->config.blk.seg_max)
+		status = VIRTIO_BLK_S_IOERR;
+	for (seg = 1; seg < n - 1 && status == VIRTIO_BLK_S_OK; seg++) {
+		len = virtio32_to_cpu(vdev, chain[seg]->len);
+		if (len > priv->config.blk.size_max || len % 512 ||
+		    offset + len > SANDBOX_BLK_SECTORS * 512)
+			status = VIRTIO_BLK_S_IOERR;
+		offset += len;
+	}
+
+	offset = start;
+	for (seg = 1; seg < n - 1 && status == VIRTIO_BLK_S_OK; seg++) {
+		addr = (void *)(uintptr_t)virtio64_to_cpu(vdev,
+							  chain[seg]->addr);
+		len = virtio32_to_cpu(vdev, chain[seg]->len);
+		if (virtio32_to_cpu(vdev, hdr->type) & VIRTIO_BLK_T_OUT) {
+			memcpy(priv->disk + offset, addr, len);
+		} else {
+			memcpy(addr, priv->disk + offset, len);
+			written += len;
+		}
+		offset += len;
+	}
+	addr = (void *)(uintptr_t)virtio64_to_cpu(vdev, chain[n - 1]->addr);
+	*addr = status;
+
+	return written;
+}
+
+static int virtio_sandbox_blk_notify(struct udevice *udev,
+				     struct virtqueue *vq)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+	struct udevice *vdev = vq->vdev;
+	struct vring_used_elem *used;
+	uint num = vq->vring.num;
+	u16 used_idx;
+	uint head;
+
+	priv->notify_count++;
+	while (priv->last_avail[0] != virtio16_to_cpu(vdev,
+						      vq->vring.avail->idx)) {
+		head = virtio16_to_cpu(vdev, vq->vring.avail->ring[
+					priv->last_avail[0] & (num - 1)]);
+		used_idx = virtio16_to_cpu(vdev, vq->vring.used->idx);
+		used = &vq->vring.used->ring[used_idx & (num - 1)];
+		used->len = cpu_to_virtio32(vdev,
+					    virtio_sandbox_blk_req(priv, vq,
+								   head));
+		used->id = cpu_to_virtio32(vdev, head);
+		vq->vring.used->idx = cpu_to_virtio16(vdev, used_idx + 1);
+		priv->last_avail[0]++;
+	}
+
+	return 0;
+}
+
+int sandbox_virtio_blk_get_notify_count(struct udevice *dev)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(dev);
+
+	return priv->notify_count;
+}
+
 static const struct dm_virtio_ops virtio_sandbox1_ops = {
 	.get_config	= virtio_sandbox_get_config,
 	.set_config	= virtio_sandbox_set_config,
@@ -231,3 +361,203 @@ U_BOOT_DRIVER(virtio_sandbox2) = {
 	.probe	= virtio_sandbox_probe,
 	.priv_auto_alloc_size = sizeof(struct virtio_sandbox_priv),
 };
+
+static int virtio_sandbox_blk_probe(struct udevice *udev)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(udev);
+
+	/* A small disk which needs each transfer split into requests */
+	priv->device_features = 1ULL << VIRTIO_F_VERSION_1 |
+				1ULL << VIRTIO_BLK_F_SIZE_MAX |
+				1ULL << VIRTIO_BLK_F_SEG_MAX |
+				1ULL << VIRTIO_RING_F_INDIRECT_DESC;
+	priv->queue_num = 8;
+	priv->config.blk.capacity = cpu_to_le64(SANDBOX_BLK_SECTORS);
+	priv->config.blk.size_max = cpu_to_le32(1024);
+	priv->config.blk.seg_max = cpu_to_le32(4);
+	priv->disk = calloc(SANDBOX_BLK_SECTORS, 512);
+	if (!priv->disk)
+		return -ENOMEM;
+	uc_priv->device = VIRTIO_ID_BLOCK;
+	uc_priv->vendor = ('u' << 24) | ('b' << 16) | ('o' << 8) | 't';
+
+	return 0;
+}
+
+static int virtio_sandbox_blk_remove(struct udevice *udev)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+
+	free(priv->disk);
+
+	return 0;
+}
+
+/* this one emulates a block device */
+static const struct dm_virtio_ops virtio_sandbox_blk_ops = {
+	.get_config	= virtio_sandbox_get_config,
+	.set_config	= virtio_sandbox_set_config,
+	.get_status	= virtio_sandbox_get_status,
+	.set_status	= virtio_sandbox_set_status,
+	.reset		= virtio_sandbox_reset,
+	.get_features	= virtio_sandbox_get_features,
+	.set_features	= virtio_sandbox_set_features,
+	.find_vqs	= virtio_sandbox_find_vqs,
+	.del_vqs	= virtio_sandbox_del_vqs,
+	.notify		= virtio_sandbox_blk_notify,
+};
+
+static const struct udevice_id virtio_sandbox_blk_ids[] = {
+	{ .compatible = "sandbox,virtio-blk" },
+	{ }
+};
+
+U_BOOT_DRIVER(virtio_sandbox_blk) = {
+	.name	= "virtio-sandbox-blk",
+	.id	= UCLASS_VIRTIO,
+	.of_match = virtio_sandbox_blk_ids,
+	.ops	= &virtio_sandbox_blk_ops,
+	.probe	= virtio_sandbox_blk_probe,
+	.remove	= virtio_sandbox_blk_remove,
+	.child_post_remove = virtio_sandbox_child_post_remove,
+	.priv_auto_alloc_size = sizeof(struct virtio_sandbox_priv),
+};
+
+/* Put buffers given to the transmit queue straight into the used ring */
+static int virtio_sandbox_net_notify(struct udevice *udev,
+				     struct virtqueue *vq)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+	struct udevice *vdev = vq->vdev;
+	struct vring_used_elem *used;
+	uint num = vq->vring.num;
+	u16 used_idx;
+
+	priv->notify_count++;
+	if (vq->index != 1)
+		return 0;
+	while (priv->last_avail[1] != virtio16_to_cpu(vdev,
+						      vq->vring.avail->idx)) {
+		used_idx = virtio16_to_cpu(vdev, vq->vring.used->idx);
+		used = &vq->vring.used->ring[used_idx & (num - 1)];
+		used->len = 0;
+		used->id = cpu_to_virtio32(vdev, vq->vring.avail->ring[
+					priv->last_avail[1] & (num - 1)]);
+		vq->vring.used->idx = cpu_to_virtio16(vdev, used_idx + 1);
+		priv->last_avail[1]++;
+	}
+
+	return 0;
+}
+
+int sandbox_virtio_net_rx(struct udevice *dev, const void *packet, int len,
+			  u8 flags)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(dev);
+	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+	struct udevice *vdev = uc_priv->vdev;
+	struct virtio_net_hdr_v1 hdr = { .flags = flags };
+	struct virtqueue *vq = NULL, *pos;
+	struct vring_used_elem *used;
+	struct vring_desc *desc;
+	const u8 *src = packet;
+	uint num, buffers, i;
+	u16 avail, used_idx;
+	int left, size, written;
+	u8 *addr;
+
+	list_for_each_entry(pos, &uc_priv->vqs, list) {
+		if (pos->index == 0)
+			vq = pos;
+	}
+	if (!vq)
+		return -ENOENT;
+	num = vq->vring.num;
+	avail = virtio16_to_cpu(vdev, vq->vring.avail->idx);
+
+	/* Work out how many buffers are needed, as a real device would */
+	left = sizeof(hdr) + len;
+	for (buffers = 0; left > 0; buffers++) {
+		if ((u16)(priv->last_avail[0] + buffers) == avail)
+			return -ENOSPC;
+		i = virtio16_to_cpu(vdev, vq->vring.avail->ring[
+				(priv->last_avail[0] + buffers) & (num - 1)]);
+		left -= virtio32_to_cpu(vdev, vq->vring.desc[i].len);
+	}
+	hdr.num_buffers = cpu_to_virtio16(vdev, buffers);
+
+	used_idx = virtio16_to_cpu(vdev, vq->vring.used->idx);
+	for (left = len; buffers--; used_idx++) {
+		i = virtio16_to_cpu(vdev, vq->vring.avail->ring[
+				priv->last_avail[0]++ & (num - 1)]);
+		desc = &vq->vring.desc[i];
+		addr = (u8 *)(uintptr_t)virtio64_to_cpu(vdev, desc->addr);
+		size = virtio32_to_cpu(vdev, desc->len);
+		written = 0;
+		if (left == len) {
+			/* the header goes at the start of the first buffer */
+			memcpy(addr, &hdr, sizeof(hdr));
+			written = sizeof(hdr);
+		}
+		size = min(size - written, left);
+		memcpy(addr + written, src, size);
+		written += size;
+		src += size;
+		left -= size;
+		used = &vq->vring.used->ring[used_idx & (num - 1)];
+		used->id = cpu_to_virtio32(vdev, i);
+		used->len = cpu_to_virtio32(vdev, written);
+	}
+	/* All the buffers of a packet become used at once */
+	virtio_wmb();
+	vq->vring.used->idx = cpu_to_virtio16(vdev, used_idx);
+
+	return 0;
+}
+
+static int virtio_sandbox_net_probe(struct udevice *udev)
+{
+	struct virtio_sandbox_priv *priv = dev_get_priv(udev);
+	struct virtio_dev_priv *uc_priv = dev_get_uclass_priv(udev);
+	static const u8 mac[] = { 0x02, 0x00, 0x11, 0x22, 0x33, 0x44 };
+
+	/* A network device with small queues, to test receiving */
+	priv->device_features = 1ULL << VIRTIO_F_VERSION_1 |
+				1ULL << VIRTIO_NET_F_MAC |
+				1ULL << VIRTIO_NET_F_MRG_RXBUF |
+				1ULL << VIRTIO_NET_F_GUEST_CSUM;
+	priv->queue_num = 8;
+	memcpy(priv->config.net.mac, mac, sizeof(mac));
+	uc_priv->device = VIRTIO_ID_NET;
+	uc_priv->vendor = ('u' << 24) | ('b' << 16) | ('o' << 8) | 't';
+
+	return 0;
+}
+
+/* this one emulates a network device */
+static const struct dm_virtio_ops virtio_sandbox_net_ops = {
+	.get_config	= virtio_sandbox_get_config,
+	.set_config	= virtio_sandbox_set_config,
+	.get_status	= virtio_sandbox_get_status,
+	.set_status	= virtio_sandbox_set_status,
+	.reset		= virtio_sandbox_reset,
+	.get_features	= virtio_sandbox_get_features,
+	.set_features	= virtio_sandbox_set_features,
+	.find_vqs	= virtio_sandbox_find_vqs,
+	.del_vqs	= virtio_sandbox_del_vqs,
+	.notify		= virtio_sandbox_net_notify,
+};
+
+/*
+ * This is bound by the test rather than from the device tree, so that the
+ * other Ethernet tests do not see another device
+ */
+U_BOOT_DRIVER(virtio_sandbox_net) = {
+	.name	= "virtio-sandbox-net",
+	.id	= UCLASS_VIRTIO,
+	.ops	= &virtio_sandbox_net_ops,
+	.probe	= virtio_sandbox_net_probe,
+	.child_post_remove = virtio_sandbox_child_post_remove,
+	.priv_auto_alloc_size = sizeof(struct virtio_sandbox_priv),
+};
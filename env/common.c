@@ -122,8 +122,8 @@ int env_import(const char *buf, int check)
 		}
 	}
 
-	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
-			0, NULL)) {
+	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0',
+			H_INCREMENTAL, 0, 0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
 		return 0;
 	}
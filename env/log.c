@@ -0,0 +1,398 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Environment stored as a log of changes
+ *
+ * Rewriting the whole environment on each save is slow on large flash
+ * sectors and wears them out. Instead each of the two storage areas holds a
+ * header and a series of records. The first record is a complete environment
+ * and each later one has just the variables changed by a save, in the format
+ * used by himport_r(), so "name=value" sets a variable and "name" deletes it.
+ *
+ * A save appends a record with the differences from the last one. When the
+ * area is full, the whole environment is written to the other area, which is
+ * then marked valid by writing its header, with a higher sequence number.
+ * Power failure during a save therefore leaves either a torn last record,
+ * which is ignored since its CRC is wrong, or an area without a valid header,
+ * which is ignored too. Either way the environment from the previous save is
+ * loaded.
+ */
+
+#include <common.h>
+#include <env.h>
+#include <env_internal.h>
+#include <errno.h>
+#include <malloc.h>
+#include <search.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#if defined(CONFIG_CMD_SAVEENV) && !defined(CONFIG_SPL_BUILD)
+#define CMD_SAVEENV
+#endif
+
+#define ENV_LOG_MAGIC	0x47564e45	/* "ENVG" */
+#define ENV_LOG_ERASED	0xffffffff
+
+/**
+ * struct env_log_hdr - header at the start of an area
+ *
+ * @magic:	ENV_LOG_MAGIC
+ * @seq:	Sequence number, higher in the newer area (wrapping)
+ * @crc:	CRC32 of @magic and @seq
+ */
+struct env_log_hdr {
+	u32 magic;
+	u32 seq;
+	u32 crc;
+};
+
+/**
+ * struct env_log_rec - header of each record in an area
+ *
+ * The record data follows, padded to a multiple of four bytes.
+ *
+ * @len:	Length of the data in bytes, ENV_LOG_ERASED at the end of the log
+ * @crc:	CRC32 of @len and the data
+ */
+struct env_log_rec {
+	u32 len;
+	u32 crc;
+};
+
+/**
+ * struct env_log_state - what is in storage
+ *
+ * @area:	Area holding the log (0 or 1), -1 if none
+ * @seq:	Its sequence number
+ * @end:	Offset of the free space at its end, 0 if it cannot be
+ *		appended to (e.g. after a torn record)
+ * @saved:	Environment as last loaded or saved, from hexport_r(), or NULL
+ *		if not known
+ * @saved_len:	Length of @saved, including the NUL after each variable
+ */
+struct env_log_state {
+	int area;
+	u32 seq;
+	ulong end;
+	char *saved;
+	ulong saved_len;
+};
+
+static struct env_log_state env_log = {
+	.area	= -1,
+};
+
+static u32 env_log_hdr_crc(const struct env_log_hdr *hdr)
+{
+	return crc32(0, (const u8 *)hdr, offsetof(struct env_log_hdr, crc));
+}
+
+static u32 env_log_rec_crc(u32 len, const void *data)
+{
+	return crc32(crc32(0, (const u8 *)&len, sizeof(len)), data, len);
+}
+
+/* Read the header of an area, returning 0 if it is valid */
+static int env_log_read_hdr(const struct env_log_storage *stor, int area,
+			    u32 *seqp)
+{
+	struct env_log_hdr hdr;
+	int ret;
+
+	ret = stor->read(stor->offset[area], sizeof(hdr), &hdr);
+	if (ret)
+		return ret;
+	if (hdr.magic != ENV_LOG_MAGIC || hdr.crc != env_log_hdr_crc(&hdr))
+		return -ENOENT;
+	*seqp = hdr.seq;
+
+	return 0;
+}
+
+/*
+ * Import the records of an area read into @buf, setting up the state to
+ * append to it. Returns -ENOENT if it does not even hold a full environment.
+ */
+static int env_log_import(char *buf, ulong *endp)
+{
+	ulong pos = ALIGN(sizeof(struct env_log_hdr), 4);
+	int flag = H_INCREMENTAL;
+	bool found = false;
+
+	*endp = 0;
+	while (pos + sizeof(struct env_log_rec) <= CONFIG_ENV_SIZE) {
+		struct env_log_rec *rec = (struct env_log_rec *)(buf + pos);
+		char *data = (char *)(rec + 1);
+		ulong room = CONFIG_ENV_SIZE - pos - sizeof(*rec);
+
+		if (rec->len == ENV_LOG_ERASED) {
+			*endp = pos;
+			break;
+		}
+		/* A torn record ends the log, so the next save compacts it */
+		if (rec->len > room ||
+		    rec->crc != env_log_rec_crc(rec->len, data)) {
+			debug("%s: bad record at %lx\n", __func__, pos);
+			break;
+		}
+		if (!himport_r(&env_htab, data, rec->len, '\0', flag, 0, 0,
+			       NULL))
+			return -EIO;
+		flag = H_NOCLEAR | H_FORCE;
+		found = true;
+		pos += sizeof(*rec) + ALIGN(rec->len, 4);
+	}
+
+	return found ? 0 : -ENOENT;
+}
+
+/*
+ * Import an environment in the usual format, which is converted by the next
+ * save. This is written to the area not holding the environment in use.
+ */
+static int env_log_import_old(const struct env_log_storage *stor, char *buf)
+{
+	int ret;
+
+#ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
+	char *buf2;
+	int read1_fail, read2_fail;
+
+	buf2 = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (!buf2) {
+		env_set_default("malloc() failed", 0);
+		return -ENOMEM;
+	}
+	read1_fail = stor->read(stor->offset[0], CONFIG_ENV_SIZE, buf);
+	read2_fail = stor->read(stor->offset[1], CONFIG_ENV_SIZE, buf2);
+	ret = env_import_redund(buf, read1_fail, buf2, read2_fail);
+	free(buf2);
+	env_log.area = gd->env_valid == ENV_REDUND ? 1 : 0;
+#else
+	ret = stor->read(stor->offset[0], CONFIG_ENV_SIZE, buf);
+	if (ret)
+		env_set_default("read failed", 0);
+	else
+		ret = env_import(buf, 1);
+	env_log.area = 0;
+#endif
+	/* Whatever happened, the next save must not overwrite this area */
+	env_log.end = 0;
+
+	return ret;
+}
+
+int env_log_load(const struct env_log_storage *stor)
+{
+	u32 seq[2];
+	int valid[2];
+	ssize_t __maybe_unused len;
+	char *buf;
+	int i, area, ret;
+
+	buf = memalign(ARCH_DMA_MINALIGN, CONFIG_ENV_SIZE);
+	if (!buf) {
+		env_set_default("malloc() failed", 0);
+		return -ENOMEM;
+	}
+
+	free(env_log.saved);
+	env_log.saved = NULL;
+	env_log.saved_len = 0;
+	env_log.area = -1;
+	env_log.seq = 0;
+	env_log.end = 0;
+
+	for (i = 0; i < 2; i++)
+		valid[i] = !env_log_read_hdr(stor, i, &seq[i]);
+
+	/* Try the newer area first, then the other one */
+	area = valid[1] && (!valid[0] || (s32)(seq[1] - seq[0]) > 0);
+	ret = -ENOENT;
+	for (i = 0; i < 2 && ret; i++, area = !area) {
+		if (!valid[area])
+			continue;
+		ret = stor->read(stor->offset[area], CONFIG_ENV_SIZE, buf);
+		if (!ret)
+			ret = env_log_import(buf, &env_log.end);
+		if (!ret) {
+			env_log.area = area;
+			env_log.seq = seq[area];
+		}
+	}
+
+	if (ret) {
+		debug("%s: no log found, err %d\n", __func__, ret);
+		ret = env_log_import_old(stor, buf);
+	} else {
+		gd->env_valid = ENV_VALID;
+		gd->flags |= GD_FLG_ENV_READY;
+	}
+	free(buf);
+	if (ret)
+		return ret;
+
+#ifdef CMD_SAVEENV
+	/* Remember what is stored, to find the differences when saving */
+	len = hexport_r(&env_htab, '\0', 0, &env_log.saved, 0, 0, NULL);
+	if (len < 0)
+		env_log.saved = NULL;
+	else
+		env_log.saved_len = len;
+#endif
+
+	return 0;
+}
+
+#ifdef CMD_SAVEENV
+/* Compare the names of two "name=value" strings */
+static int env_log_keycmp(const char *a, const char *b)
+{
+	for (; *a == *b && *a != '=' && *a; a++, b++)
+		;
+
+	return (*a == '=' ? 0 : (u8)*a) - (*b == '=' ? 0 : (u8)*b);
+}
+
+/*
+ * Find the changes from @old to @new, both lists of "name=value" strings in
+ * the order written by hexport_r(). Returns the length of the changes
+ * written to @diff, which must have room for both lists.
+ */
+static ulong env_log_diff(const char *old, const char *new, char *diff)
+{
+	char *p = diff;
+	int cmp;
+
+	while (*old || *new) {
+		if (!*old)
+			cmp = 1;
+		else if (!*new)
+			cmp = -1;
+		else
+			cmp = env_log_keycmp(old, new);
+
+		if (cmp < 0) {
+			/* deleted, so just write the name */
+			while (*old != '=')
+				*p++ = *old++;
+			*p++ = '\0';
+		} else if (cmp > 0 || strcmp(old, new)) {
+			strcpy(p, new);
+			p += strlen(new) + 1;
+		}
+		if (cmp <= 0)
+			old += strlen(old) + 1;
+		if (cmp >= 0)
+			new += strlen(new) + 1;
+	}
+
+	return p - diff;
+}
+
+/* Write a record with @len bytes of @data at @offset */
+static int env_log_write_rec(const struct env_log_storage *stor, ulong offset,
+			     const char *data, ulong len)
+{
+	struct env_log_rec *rec;
+	int ret;
+
+	rec = malloc(sizeof(*rec) + len);
+	if (!rec)
+		return -ENOMEM;
+	rec->len = len;
+	rec->crc = env_log_rec_crc(len, data);
+	memcpy(rec + 1, data, len);
+	ret = stor->write(offset, sizeof(*rec) + len, rec);
+	free(rec);
+
+	return ret;
+}
+
+/* Write the whole environment to the other area, then switch to it */
+static int env_log_compact(const struct env_log_storage *stor,
+			   const char *env, ulong len)
+{
+	ulong start = ALIGN(sizeof(struct env_log_hdr), 4);
+	struct env_log_hdr hdr;
+	int area = env_log.area == 0 ? 1 : 0;
+	int ret;
+
+	if (start + sizeof(struct env_log_rec) + len > CONFIG_ENV_SIZE)
+		return -ENOSPC;
+
+	debug("%s: writing %lu bytes to area %d\n", __func__, len, area);
+	ret = stor->erase(stor->offset[area], CONFIG_ENV_SIZE);
+	if (ret)
+		return ret;
+	ret = env_log_write_rec(stor, stor->offset[area] + start, env, len);
+	if (ret)
+		return ret;
+
+	/* Only now does the area become valid */
+	hdr.magic = ENV_LOG_MAGIC;
+	hdr.seq = env_log.seq + 1;
+	hdr.crc = env_log_hdr_crc(&hdr);
+	ret = stor->write(stor->offset[area], sizeof(hdr), &hdr);
+	if (ret)
+		return ret;
+
+	env_log.area = area;
+	env_log.seq = hdr.seq;
+	env_log.end = start + sizeof(struct env_log_rec) + ALIGN(len, 4);
+
+	return 0;
+}
+
+int env_log_save(const struct env_log_storage *stor)
+{
+	char *env = NULL, *diff = NULL;
+	ssize_t len;
+	ulong difflen, need;
+	int ret;
+
+	len = hexport_r(&env_htab, '\0', 0, &env, 0, 0, NULL);
+	if (len < 0)
+		return -EINVAL;
+
+	if (env_log.area != -1 && env_log.end && env_log.saved) {
+		/* Worst case: every old name deleted, every new one written */
+		diff = malloc(env_log.saved_len + len);
+		if (!diff) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		difflen = env_log_diff(env_log.saved, env, diff);
+		if (!difflen) {
+			ret = 0;
+			goto out;
+		}
+		need = sizeof(struct env_log_rec) + ALIGN(difflen, 4);
+		if (env_log.end + need <= CONFIG_ENV_SIZE) {
+			debug("%s: appending %lu bytes at %lx\n", __func__,
+			      difflen, env_log.end);
+			ret = env_log_write_rec(stor,
+						stor->offset[env_log.area] +
+						env_log.end, diff, difflen);
+			/* The record may be partly written, so do not reuse */
+			env_log.end = ret ? 0 : env_log.end + need;
+			goto done;
+		}
+	}
+	ret = env_log_compact(stor, env, len);
+
+done:
+	if (!ret) {
+		free(env_log.saved);
+		env_log.saved = env;
+		env_log.saved_len = len;
+		env = NULL;
+	}
+out:
+	free(diff);
+	free(env);
+
+	return ret;
+}
+#endif /* CMD_SAVEENV */
@@ -25,7 +25,7 @@
 #define INITENV
 #endif
 
-#ifdef CONFIG_ENV_OFFSET_REDUND
+#if defined(CONFIG_ENV_OFFSET_REDUND) && !defined(CONFIG_ENV_SPI_FLASH_LOG)
 #ifdef CMD_SAVEENV
 static ulong env_offset		= CONFIG_ENV_OFFSET;
 static ulong env_new_offset	= CONFIG_ENV_OFFSET_REDUND;
@@ -68,7 +68,61 @@ static int setup_flash_device(void)
 	return 0;
 }
 
-#if defined(CONFIG_ENV_OFFSET_REDUND)
+#if defined(CONFIG_ENV_SPI_FLASH_LOG)
+static int env_sf_log_read(ulong offset, size_t len, void *buf)
+{
+	return spi_flash_read(env_flash, offset, len, buf);
+}
+
+static int env_sf_log_write(ulong offset, size_t len, const void *buf)
+{
+	return spi_flash_write(env_flash, offset, len, buf);
+}
+
+static int env_sf_log_erase(ulong offset, size_t len)
+{
+	u32 sector = DIV_ROUND_UP(len, CONFIG_ENV_SECT_SIZE);
+
+	return spi_flash_erase(env_flash, offset,
+			       sector * CONFIG_ENV_SECT_SIZE);
+}
+
+static const struct env_log_storage env_sf_log = {
+	.offset	= { CONFIG_ENV_OFFSET, CONFIG_ENV_OFFSET_REDUND },
+	.read	= env_sf_log_read,
+	.write	= env_sf_log_write,
+	.erase	= env_sf_log_erase,
+};
+
+#ifdef CMD_SAVEENV
+static int env_sf_save(void)
+{
+	int ret;
+
+	ret = setup_flash_device();
+	if (ret)
+		return ret;
+
+	return env_log_save(&env_sf_log);
+}
+#endif /* CMD_SAVEENV */
+
+static int env_sf_load(void)
+{
+	int ret;
+
+	ret = setup_flash_device();
+	if (ret)
+		return ret;
+
+	ret = env_log_load(&env_sf_log);
+
+	spi_flash_free(env_flash);
+	env_flash = NULL;
+
+	return ret;
+}
+#elif defined(CONFIG_ENV_OFFSET_REDUND)
 #ifdef CMD_SAVEENV
 static int env_sf_save(void)
 {
@@ -81,7 +81,6 @@ int btrfs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
 
 	memset(&btrfs_info, 0, sizeof(btrfs_info));
 
-	btrfs_hash_init();
 	if (btrfs_read_superblock())
 		return -1;
 
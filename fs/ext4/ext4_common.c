@@ -1639,6 +1639,94 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/*
+ * Map 'fileblock' of an extent-mapped inode. Returns the first physical
+ * block, 0 for a hole or a negative value on error. *count is set to the
+ * number of blocks from 'fileblock' onwards which are mapped the same way,
+ * i.e. the rest of the extent or of the hole. If 'unwritten_hole' is set,
+ * unwritten (preallocated) extents are reported as holes, since their
+ * blocks hold stale data which must read as zeroes.
+ */
+static long int read_extent_blocks(struct ext2_inode *inode, int fileblock,
+				   long int *count, bool unwritten_hole,
+				   struct ext_block_cache *cache)
+{
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+			 get_fs()->dev_desc->log2blksz;
+	long int startblock, endblock;
+	struct ext_block_cache *c, cd;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	long int blknr = 0;
+	int len;
+	int i;
+
+	if (cache) {
+		c = cache;
+	} else {
+		c = &cd;
+		ext_cache_init(c);
+	}
+	*count = 1;
+	ext_block = ext4fs_get_extent_block(ext4fs_root, c,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		blknr = -EINVAL;
+		goto out;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		len = le16_to_cpu(extent[i].ee_len);
+		if (len > EXT_INIT_MAX_LEN)
+			len -= EXT_INIT_MAX_LEN;
+		endblock = startblock + len;
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			*count = startblock - fileblock;
+			break;
+		} else if (fileblock < endblock) {
+			*count = endblock - fileblock;
+			if (unwritten_hole &&
+			    le16_to_cpu(extent[i].ee_len) > EXT_INIT_MAX_LEN)
+				break;
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			blknr = (fileblock - startblock) + start;
+			break;
+		}
+	}
+
+out:
+	if (!cache)
+		ext_cache_fini(c);
+	return blknr;
+}
+
+/*
+ * Like read_allocated_block(), but also return in *count how many of the
+ * following file blocks are physically contiguous with 'fileblock' (or
+ * part of the same hole), so that callers can read a whole extent at once.
+ * Unwritten extents are returned as holes.
+ */
+long int read_allocated_extent(struct ext2_inode *inode, int fileblock,
+			       long int *count, struct ext_block_cache *cache)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return read_extent_blocks(inode, fileblock, count, true, cache);
+
+	*count = 1;
+	return read_allocated_block(inode, fileblock, cache);
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1649,62 +1737,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
-				return 0;
+		long int count;
 
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
-				return (fileblock - startblock) + start;
-			}
-		}
-
-		if (!cache)
-			ext_cache_fini(c);
-		return 0;
+		return read_extent_blocks(inode, fileblock, &count, false,
+					  cache);
 	}
 
 	/* Direct blocks. */
@@ -44,12 +44,15 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are mapped an extent at a time, so each extent is looked up once
+ * and read with a single ext4fs_devread() straight into the caller's buffer.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	lbaint_t i;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
@@ -61,7 +64,6 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
-	char *start_buf = buf;
 	short status;
 	struct ext_block_cache cache;
 
@@ -78,40 +80,41 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	for (i = lldiv(pos, blocksize); i < blockcnt; ) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+		long int count;
+		loff_t runstart = (loff_t)i * blocksize;
+		loff_t runend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
+		int runlen;
+
+		blknr = read_allocated_extent(&node->inode, i, &count, &cache);
 		if (blknr < 0) {
 			ext_cache_fini(&cache);
 			return -1;
 		}
+		if (count > blockcnt - i)
+			count = blockcnt - i;
+		/* Keep each read within the range of ext4fs_devread() */
+		if (count > INT_MAX / 2 / blocksize)
+			count = INT_MAX / 2 / blocksize;
 
 		blknr = blknr << log2_fs_blocksize;
-
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		runend = min(runstart + (loff_t)count * blocksize, pos + len);
 
 		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
-		}
+		if (runstart < pos)
+			skipfirst = pos - runstart;
+		runlen = runend - runstart - skipfirst;
+
 		if (blknr) {
 			int status;
 
 			if (previous_block_number != -1) {
 				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
+					delayed_extent += runlen;
+					delayed_next += (lbaint_t)count <<
+							log2_fs_blocksize;
 				} else {	/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
@@ -123,24 +126,26 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					}
 					previous_block_number = blknr;
 					delayed_start = blknr;
-					delayed_extent = blockend;
+					delayed_extent = runlen;
 					delayed_skipfirst = skipfirst;
 					delayed_buf = buf;
 					delayed_next = blknr +
-						(blockend >> log2blksz);
+						((lbaint_t)count <<
+						 log2_fs_blocksize);
 				}
 			} else {
 				previous_block_number = blknr;
 				delayed_start = blknr;
-				delayed_extent = blockend;
+				delayed_extent = runlen;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
 				delayed_next = blknr +
-					(blockend >> log2blksz);
+					((lbaint_t)count << log2_fs_blocksize);
 			}
+			/* Never let a merged read overflow ext4fs_devread() */
+			if (delayed_extent >= INT_MAX / 2)
+				delayed_next = -1;
 		} else {
-			int n;
-			int n_left;
 			if (previous_block_number != -1) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
@@ -153,14 +158,11 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 				}
 				previous_block_number = -1;
 			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			n_left = len - ( buf - start_buf );
-			if (n > n_left)
-				n = n_left;
-			memset(buf, 0, n);
+			/* Holes read as zeroes */
+			memset(buf, 0, runlen);
 		}
-		buf += blocksize - skipfirst;
+		buf += runlen;
+		i += count;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
@@ -277,24 +279,50 @@ void ext_cache_init(struct ext_block_cache *cache)
 
 void ext_cache_fini(struct ext_block_cache *cache)
 {
-	free(cache->buf);
+	int i;
+
+	for (i = 0; i < EXT_CACHE_ENTRIES; i++)
+		free(cache->entry[i].buf);
 	ext_cache_init(cache);
 }
 
 int ext_cache_read(struct ext_block_cache *cache, lbaint_t block, int size)
 {
-	/* This could be more lenient, but this is simple and enough for now */
-	if (cache->buf && cache->block == block && cache->size == size)
-		return 1;
-	ext_cache_fini(cache);
-	cache->buf = malloc(size);
-	if (!cache->buf)
-		return 0;
-	if (!ext4fs_devread(block, 0, size, cache->buf)) {
-		ext_cache_fini(cache);
+	struct ext_block_cache_entry *entry, *victim = cache->entry;
+	int i;
+
+	for (i = 0, entry = cache->entry; i < EXT_CACHE_ENTRIES; i++, entry++) {
+		if (entry->buf && entry->block == block &&
+		    entry->size == size) {
+			entry->age = ++cache->clock;
+			cache->buf = entry->buf;
+			return 1;
+		}
+		/* replace an unused entry, or else the least recently used */
+		if (victim->buf && (!entry->buf ||
+				    cache->clock - entry->age >
+				    cache->clock - victim->age))
+			victim = entry;
+	}
+
+	cache->buf = NULL;
+	if (victim->size != size) {
+		free(victim->buf);
+		victim->buf = malloc(size);
+		if (!victim->buf) {
+			victim->size = 0;
+			return 0;
+		}
+		victim->size = size;
+	}
+	if (!ext4fs_devread(block, 0, size, victim->buf)) {
+		free(victim->buf);
+		victim->buf = NULL;
+		victim->size = 0;
 		return 0;
 	}
-	cache->block = block;
-	cache->size = size;
+	victim->block = block;
+	victim->age = ++cache->clock;
+	cache->buf = victim->buf;
 	return 1;
 }
@@ -155,6 +155,74 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 }
 #endif
 
+static inline bool fatbuf_test(const __u8 *map, __u32 chunk)
+{
+	return map[chunk / 8] & (1 << (chunk % 8));
+}
+
+static inline void fatbuf_set(__u8 *map, __u32 chunk)
+{
+	map[chunk / 8] |= 1 << (chunk % 8);
+}
+
+/*
+ * Allocate a FAT buffer of 'blocks' sectors, which must be a multiple of
+ * FATBUFBLOCKS, along with the bitmaps of its chunks. All of it is freed
+ * by freeing mydata->fatbuf.
+ */
+static int fat_alloc_buf(fsdata *mydata, __u32 blocks)
+{
+	mydata->fatbufblocks = blocks;
+	mydata->fatbufnum = -1;
+	mydata->fat_dirty = 0;
+	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE + 2 * FATBUFMAPSIZE);
+	if (!mydata->fatbuf)
+		return -ENOMEM;
+	mydata->fatbuf_valid = mydata->fatbuf + FATBUFSIZE;
+	mydata->fatbuf_dirty = mydata->fatbuf_valid + FATBUFMAPSIZE;
+	memset(mydata->fatbuf_valid, '\0', 2 * FATBUFMAPSIZE);
+
+	return 0;
+}
+
+/*
+ * Make sure the chunk of the FAT buffer holding byte 'offset' of window
+ * 'bufnum' has been read. A chunk is FATBUFBLOCKS sectors, so only the part
+ * of a large window which is used is ever read.
+ * Return 0 on success, -1 on error.
+ */
+static int fat_load_chunk(fsdata *mydata, __u32 bufnum, __u32 offset)
+{
+	__u32 chunk = offset / (mydata->sect_size * FATBUFBLOCKS);
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 startblock;
+
+	if (bufnum != mydata->fatbufnum) {
+		/* Write back the fatbuf to the disk */
+		if (flush_dirty_fat_buffer(mydata) < 0)
+			return -1;
+		memset(mydata->fatbuf_valid, '\0', FATBUFMAPSIZE);
+		mydata->fatbufnum = bufnum;
+	}
+	if (fatbuf_test(mydata->fatbuf_valid, chunk))
+		return 0;
+
+	startblock = bufnum * mydata->fatbufblocks + chunk * FATBUFBLOCKS;
+	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+	if (startblock + getsize > mydata->fatlength)
+		getsize = mydata->fatlength - startblock;
+	startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+	if (disk_read(startblock, getsize, mydata->fatbuf +
+		      chunk * FATBUFBLOCKS * mydata->sect_size) < 0) {
+		debug("Error reading FAT blocks\n");
+		return -1;
+	}
+	fatbuf_set(mydata->fatbuf_valid, chunk);
+
+	return 0;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
@@ -192,29 +260,9 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
 	       mydata->fatsize, entry, entry, offset, offset);
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	/* Read the FAT entries into the cache, if needed */
+	if (fat_load_chunk(mydata, bufnum, offset * mydata->fatsize / 8) < 0)
+		return ret;
 
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
@@ -259,21 +307,35 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		unsigned long bytesperclust = mydata->clust_size *
+					      mydata->sect_size;
+		__u8 *tmpbuf;
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* Bounce a cluster at a time rather than a sector at a time */
+		tmpbuf = malloc_cache_aligned(bytesperclust);
+		if (!tmpbuf) {
+			debug("Error: allocating buffer\n");
+			return -1;
+		}
+
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min(size, bytesperclust) / mydata->sect_size;
+			ret = disk_read(startsect, idx, tmpbuf);
+			if (ret != idx) {
 				debug("Error reading data (got %d)\n", ret);
+				free(tmpbuf);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			memcpy(buffer, tmpbuf, idx);
+			buffer += idx;
+			size -= idx;
 		}
+		free(tmpbuf);
 	} else {
 		idx = size / mydata->sect_size;
 		ret = disk_read(startsect, idx, buffer);
@@ -552,6 +614,28 @@ exit:
 	return ret;
 }
 
+/*
+ * Get the number of FAT sectors to buffer. With FS_FAT_TABLE_CACHE this is
+ * the whole FAT if it fits into the configured budget, so that a cluster
+ * chain can be followed without further reads. The size is kept a multiple
+ * of FATBUFBLOCKS, which guarantees that no FAT12 entry straddles two
+ * windows.
+ */
+static __u32 fat_buf_blocks(fsdata *mydata)
+{
+#if CONFIG_IS_ENABLED(FS_FAT_TABLE_CACHE)
+	__u32 blocks = CONFIG_FS_FAT_TABLE_CACHE_SIZE * 1024 /
+		       mydata->sect_size;
+
+	if (mydata->fatlength <= blocks)
+		return roundup(mydata->fatlength, FATBUFBLOCKS);
+
+	return max_t(__u32, rounddown(blocks, FATBUFBLOCKS), FATBUFBLOCKS);
+#else
+	return FATBUFBLOCKS;
+#endif
+}
+
 static int get_fs_info(fsdata *mydata)
 {
 	boot_sector bs;
@@ -621,10 +705,13 @@ static int get_fs_info(fsdata *mydata)
 		mydata->root_cluster = 0;
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	ret = fat_alloc_buf(mydata, fat_buf_blocks(mydata));
+	if (ret && mydata->fatbufblocks != FATBUFBLOCKS) {
+		debug("FAT: cannot buffer %u FAT sectors\n",
+		      mydata->fatbufblocks);
+		ret = fat_alloc_buf(mydata, FATBUFBLOCKS);
+	}
+	if (ret) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
@@ -104,10 +104,8 @@ static void set_name(dir_entry *dirent, const char *filename)
  */
 static int flush_dirty_fat_buffer(fsdata *mydata)
 {
-	int getsize = FATBUFBLOCKS;
-	__u32 fatlength = mydata->fatlength;
-	__u8 *bufptr = mydata->fatbuf;
-	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
+	__u32 first, last, startblock, getsize;
+	__u8 *bufptr;
 
 	debug("debug: evicting %d, dirty: %d\n", mydata->fatbufnum,
 	      (int)mydata->fat_dirty);
@@ -115,26 +113,44 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 	if ((!mydata->fat_dirty) || (mydata->fatbufnum == -1))
 		return 0;
 
-	/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-	if (startblock + getsize > fatlength)
-		getsize = fatlength - startblock;
+	/* Write back each run of modified chunks */
+	for (first = 0; first < FATBUFCHUNKS; first = last + 1) {
+		if (!fatbuf_test(mydata->fatbuf_dirty, first)) {
+			last = first;
+			continue;
+		}
+		for (last = first; last + 1 < FATBUFCHUNKS; last++)
+			if (!fatbuf_test(mydata->fatbuf_dirty, last + 1))
+				break;
 
-	startblock += mydata->fat_sect;
+		startblock = mydata->fatbufnum * mydata->fatbufblocks +
+			     first * FATBUFBLOCKS;
+		getsize = (last + 1 - first) * FATBUFBLOCKS;
+		bufptr = mydata->fatbuf + first * FATBUFBLOCKS *
+			 mydata->sect_size;
 
-	/* Write FAT buf */
-	if (disk_write(startblock, getsize, bufptr) < 0) {
-		debug("error: writing FAT blocks\n");
-		return -1;
-	}
+		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+		if (startblock + getsize > mydata->fatlength)
+			getsize = mydata->fatlength - startblock;
 
-	if (mydata->fats == 2) {
-		/* Update corresponding second FAT blocks */
-		startblock += mydata->fatlength;
+		startblock += mydata->fat_sect;
+
+		/* Write FAT buf */
 		if (disk_write(startblock, getsize, bufptr) < 0) {
-			debug("error: writing second FAT blocks\n");
+			debug("error: writing FAT blocks\n");
 			return -1;
 		}
+
+		if (mydata->fats == 2) {
+			/* Update corresponding second FAT blocks */
+			startblock += mydata->fatlength;
+			if (disk_write(startblock, getsize, bufptr) < 0) {
+				debug("error: writing second FAT blocks\n");
+				return -1;
+			}
+		}
 	}
+	memset(mydata->fatbuf_dirty, '\0', FATBUFMAPSIZE);
 	mydata->fat_dirty = 0;
 
 	return 0;
@@ -263,7 +279,7 @@ fill_dir_slot(fat_itr *itr, const char *l_name)
  */
 static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 {
-	__u32 bufnum, offset, off16;
+	__u32 bufnum, offset, off8, off16;
 	__u16 val1, val2;
 
 	switch (mydata->fatsize) {
@@ -284,30 +300,14 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		return -1;
 	}
 
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		startblock += mydata->fat_sect;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return -1;
-		}
-		mydata->fatbufnum = bufnum;
-	}
+	/* Read the FAT entries into the cache, if needed */
+	off8 = offset * mydata->fatsize / 8;
+	if (fat_load_chunk(mydata, bufnum, off8) < 0)
+		return -1;
 
 	/* Mark as dirty */
+	fatbuf_set(mydata->fatbuf_dirty,
+		   off8 / (mydata->sect_size * FATBUFBLOCKS));
 	mydata->fat_dirty = 1;
 
 	/* Set the actual entry */
@@ -1217,8 +1217,7 @@ int file_fat_write(const char *filename, void *buffer, loff_t offset,
 static int fat_dir_entries(fat_itr *itr)
 {
 	fat_itr *dirs;
-	fsdata fsdata = { .fatbuf = NULL, }, *mydata = &fsdata;
-						/* for FATBUFSIZE */
+	fsdata fsdata = { .fatbuf = NULL, };
 	int count;
 
 	dirs = malloc_cache_aligned(sizeof(fat_itr));
@@ -1233,13 +1232,11 @@ static int fat_dir_entries(fat_itr *itr)
 	fsdata = *dirs->fsdata;
 
 	/* allocate local fat buffer */
-	fsdata.fatbuf = malloc_cache_aligned(FATBUFSIZE);
-	if (!fsdata.fatbuf) {
+	if (fat_alloc_buf(&fsdata, FATBUFBLOCKS)) {
 		debug("Error: allocating memory\n");
 		count = -ENOMEM;
 		goto exit;
 	}
-	fsdata.fatbufnum = -1;
 	dirs->fsdata = &fsdata;
 
 	for (count = 0; fat_itr_next(dirs); count++)
@@ -67,6 +67,10 @@ typedef struct global_data {
 	struct udevice	*dm_root;	/* Root instance for Driver Model */
 	struct udevice	*dm_root_f;	/* Pre-relocation root instance */
 	struct list_head uclass_root;	/* Head of core tree */
+	/* Drivers by compatible string, or ERR_PTR() if it cannot be built */
+	struct lists_compat_index *dm_compat_index;
+	/* Number of devices whose probe is started but not finished */
+	uint dm_probe_pending;
 #endif
 #ifdef CONFIG_TIMER
 	struct udevice	*timer;		/* Timer instance for Driver Model */
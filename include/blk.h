@@ -168,9 +168,23 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned evictions;
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned ways; /* entries per hash set */
+};
+
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+	unsigned entries; /* current entry count for this device */
 };
 
 /**
@@ -180,6 +194,16 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of one device and reset
+ *
+ * @param index - index of the device, starting at 0
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 if OK, -ENOENT if there is no device with this index
+ */
+int blkcache_dev_stats(int index, struct block_cache_dev_stats *stats);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -87,6 +87,29 @@ struct cpu_ops {
 	 * @return 0 if OK, -ENOSPC if buffer is too small, other -ve on error
 	 */
 	int (*get_vendor)(struct udevice *dev, char *buf, int size);
+
+	/**
+	 * is_current() - Check if the CPU is the one running this code
+	 *
+	 * @dev:	Device to check (UCLASS_CPU)
+	 * @return 1 if it is, 0 if not, -ve on error
+	 */
+	int (*is_current)(struct udevice *dev);
+
+	/**
+	 * start() - Start a secondary CPU running a function
+	 *
+	 * This returns once the CPU has been started, without waiting for
+	 * @func to return. When it does, the CPU must go back to the state
+	 * it was in before, so that it can be started again, or by the OS.
+	 *
+	 * @dev:	Device to start (UCLASS_CPU)
+	 * @func:	Function to run
+	 * @arg:	Argument to pass to @func
+	 * @return 0 if OK, -EBUSY if the CPU is running this code or is not
+	 *	ready to be started, other -ve on error
+	 */
+	int (*start)(struct udevice *dev, void (*func)(void *arg), void *arg);
 };
 
 #define cpu_get_ops(dev)        ((struct cpu_ops *)(dev)->driver->ops)
@@ -128,6 +151,43 @@ int cpu_get_count(struct udevice *dev);
  */
 int cpu_get_vendor(struct udevice *dev, char *buf, int size);
 
+/**
+ * cpu_is_current() - Check if a CPU is the one running this code
+ * @dev:	Device to check (UCLASS_CPU)
+ *
+ * Return: 1 if it is, 0 if not, -ve on error
+ */
+int cpu_is_current(struct udevice *dev);
+
+/**
+ * cpu_run() - Run a function on a secondary CPU
+ * @dev:	Device to run on (UCLASS_CPU)
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ *
+ * This starts @func on the CPU and returns without waiting for it to finish.
+ * Call cpu_wait() to wait for that. The function runs alongside U-Boot, so
+ * it must not use anything which is not safe to use from two CPUs at once,
+ * such as malloc(), driver model and the console. Its stack is small.
+ *
+ * Return: 0 if OK, -ENOSYS if the CPU cannot run functions, -EBUSY if it is
+ * the current CPU or is still running an earlier function, -ENODEV if it
+ * failed to start before, other -ve on error
+ */
+int cpu_run(struct udevice *dev, void (*func)(void *arg), void *arg);
+
+/**
+ * cpu_wait() - Wait for a function started by cpu_run() to finish
+ * @dev:	Device to wait for (UCLASS_CPU)
+ *
+ * If the CPU does not start running the function in time, the function is
+ * cancelled: it is never run, even if the CPU starts later, so the caller may
+ * free its argument. The CPU is not used again.
+ *
+ * Return: 0 if OK, -ETIMEDOUT if the CPU did not start running the function
+ */
+int cpu_wait(struct udevice *dev);
+
 /**
  * cpu_probe_all() - Probe all available CPUs
  *
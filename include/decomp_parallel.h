@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompressing the independent frames of an image on several CPUs
+ */
+
+#ifndef __DECOMP_PARALLEL_H
+#define __DECOMP_PARALLEL_H
+
+#include <linux/types.h>
+
+/**
+ * decomp_parallel() - Decompress independent frames on several CPUs
+ *
+ * This splits LZ4 or Zstandard data into its frames and shares them out
+ * between this CPU and the secondary CPUs which can run functions (see
+ * cpu_run()), each frame being decompressed straight to its place in @dst.
+ * That needs the decompressed size of each frame to be in its header, as
+ * written by 'lz4 --content-size' and by zstd.
+ *
+ * Nothing is written to @dst if -ENOSYS is returned, so the caller can then
+ * decompress the data in the usual way.
+ *
+ * @comp: Compression type, IH_COMP_LZ4 or IH_COMP_ZSTD
+ * @src: Compressed data
+ * @srcn: Length of @src in bytes
+ * @dst: Buffer for the decompressed data, which must not overlap @src
+ * @dstn: On entry, the size of @dst. Returns the length of the decompressed
+ *	data
+ * @return 0 if OK, -ENOSYS if the data has only one frame, the size of a
+ *	frame is not known, the buffers overlap or there are no secondary
+ *	CPUs, -ENOSPC if the data does not fit in @dst, -ENOMEM if out of
+ *	memory, other -ve value if the data is corrupt
+ */
+int decomp_parallel(int comp, const void *src, size_t srcn, void *dst,
+		    size_t *dstn);
+
+#endif
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Decompressing data a piece at a time, as it is loaded
+ */
+
+#ifndef __DECOMP_STREAM_H
+#define __DECOMP_STREAM_H
+
+#include <linux/types.h>
+
+/**
+ * struct decomp_stream - a sink for compressed data
+ *
+ * A loader writes the compressed data to the stream in pieces of any size as
+ * they arrive, and they are decompressed straight to their final place in
+ * memory. So decompression can start before loading finishes and there is
+ * no need for a buffer holding the whole of the compressed data.
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @dst:	Buffer for the decompressed data
+ * @dst_size:	Size of @dst in bytes
+ * @pos:	Number of bytes decompressed to @dst so far
+ * @done:	true if the compressed data seen so far is complete
+ * @err:	First error seen, returned by any later calls
+ * @priv:	State of the decompressor
+ */
+struct decomp_stream {
+	int comp;
+	void *dst;
+	size_t dst_size;
+	size_t pos;
+	bool done;
+	int err;
+	void *priv;
+};
+
+/**
+ * decomp_stream_start() - Start decompressing to a buffer
+ *
+ * @ds: Stream to set up
+ * @comp: Compression type (IH_COMP_...). IH_COMP_NONE copies the data
+ * @dst: Buffer for the decompressed data
+ * @dst_size: Size of @dst in bytes
+ * @return 0 if OK, -ENOSYS if @comp cannot be decompressed as a stream,
+ *	-ENOMEM if the decompressor cannot allocate its state
+ */
+int decomp_stream_start(struct decomp_stream *ds, int comp, void *dst,
+			size_t dst_size);
+
+/**
+ * decomp_stream_write() - Decompress the next piece of the compressed data
+ *
+ * Data following the end of the compressed data is ignored, except with
+ * zstd, where it must be another frame.
+ *
+ * @ds: Stream to write to
+ * @buf: Compressed data, which need not stay in place after the call
+ * @len: Length of @buf in bytes
+ * @return 0 if OK, -ENOSPC if the decompressed data does not fit in the
+ *	buffer, -EINVAL if the compressed data is corrupt (lz4 also reports a
+ *	block which does not fit this way), other -ve value on other errors
+ */
+int decomp_stream_write(struct decomp_stream *ds, const void *buf,
+			size_t len);
+
+/**
+ * decomp_stream_finish() - Finish decompressing
+ *
+ * This frees the state of the decompressor, so must be called for each
+ * successful decomp_stream_start(), even after an error.
+ *
+ * @ds: Stream to finish
+ * @lenp: If not NULL, returns the number of bytes decompressed
+ * @return 0 if OK, -EINVAL if the compressed data ended early, or the error
+ *	returned by an earlier decomp_stream_write()
+ */
+int decomp_stream_finish(struct decomp_stream *ds, size_t *lenp);
+
+/*
+ * Decompressor interfaces used by the functions above. Each sets up
+ * ds->priv in its start function, may update ds->pos and ds->done in its
+ * write function and frees ds->priv in its end function.
+ */
+int gzip_stream_start(struct decomp_stream *ds);
+int gzip_stream_write(struct decomp_stream *ds, const void *buf, size_t len);
+void gzip_stream_end(struct decomp_stream *ds);
+
+int lz4_stream_start(struct decomp_stream *ds);
+int lz4_stream_write(struct decomp_stream *ds, const void *buf, size_t len);
+void lz4_stream_end(struct decomp_stream *ds);
+
+int lzma_stream_start(struct decomp_stream *ds);
+int lzma_stream_write(struct decomp_stream *ds, const void *buf, size_t len);
+void lzma_stream_end(struct decomp_stream *ds);
+
+int zstd_stream_start(struct decomp_stream *ds);
+int zstd_stream_write(struct decomp_stream *ds, const void *buf, size_t len);
+void zstd_stream_end(struct decomp_stream *ds);
+
+#endif
@@ -89,11 +89,56 @@ int device_bind_by_name(struct udevice *parent, bool pre_reloc_only,
  * Activate a device so that it is ready for use. All its parents are probed
  * first.
  *
+ * If the device's probe was started with device_probe_start() and has not
+ * finished, this waits for it to finish.
+ *
  * @dev: Pointer to device to probe
  * @return 0 if OK, -ve on error
  */
 int device_probe(struct udevice *dev);
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/**
+ * device_probe_start() - Start probing a device, without waiting for it
+ *
+ * This is like device_probe() except that if the device's driver has the
+ * DM_FLAG_PROBE_ASYNC flag, it returns once the driver's probe() method
+ * has started the device. The device then has the DM_FLAG_PROBE_PENDING
+ * flag, and device_active() is false, until the probe is finished by
+ * device_probe_poll(), or by device_probe() when the device is needed.
+ *
+ * All the device's parents are fully probed first.
+ *
+ * @dev: Pointer to device to probe
+ * @return 0 if OK, -ve on error
+ */
+int device_probe_start(struct udevice *dev);
+
+/**
+ * device_probe_poll() - Try to finish probing a device
+ *
+ * This calls the driver's probe_finish() method once, if the device's probe
+ * is pending. If that has finished, the probe is completed as for
+ * device_probe(). If the driver reports an error, the device is no longer
+ * active.
+ *
+ * @dev: Pointer to device to poll
+ * @return 0 if the probe is finished (or was not pending), -EAGAIN if it is
+ *	still in progress, other -ve on error
+ */
+int device_probe_poll(struct udevice *dev);
+#else
+static inline int device_probe_start(struct udevice *dev)
+{
+	return device_probe(dev);
+}
+
+static inline int device_probe_poll(struct udevice *dev)
+{
+	return 0;
+}
+#endif
+
 /**
  * device_remove() - Remove a device, de-activating it
  *
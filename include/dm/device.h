@@ -64,6 +64,15 @@ struct driver_info;
 /* DM does not enable/disable the power domains corresponding to this device */
 #define DM_FLAG_DEFAULT_PD_CTRL_OFF	(1 << 11)
 
+/*
+ * The driver's probe() method only starts the device, which may then be left
+ * to finish in the background. The probe_finish() method completes it.
+ */
+#define DM_FLAG_PROBE_ASYNC		(1 << 12)
+
+/* Device probe is started but not finished (see device_probe_start()) */
+#define DM_FLAG_PROBE_PENDING		(1 << 13)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -107,7 +116,8 @@ enum {
  * @platdata: Configuration data for this device
  * @parent_platdata: The parent bus's configuration data for this device
  * @uclass_platdata: The uclass's configuration data for this device
- * @node: Reference to device tree node for this device
+ * @node: Reference to device tree node for this device. Once the device
+ *	is bound, change this with dev_set_ofnode()
  * @driver_data: Driver data word for the entry that matched this device with
  *		its driver
  * @parent: Parent of this device, or NULL for the top level device
@@ -157,17 +167,33 @@ struct udevice {
 /* Returns the operations for a device */
 #define device_get_ops(dev)	(dev->driver->ops)
 
-/* Returns non-zero if the device is active (probed and not removed) */
-#define device_active(dev)	((dev)->flags & DM_FLAG_ACTIVATED)
+/*
+ * Returns non-zero if the device is active (probed and not removed). A device
+ * whose probe is still pending is not active yet.
+ */
+#define device_active(dev)	(((dev)->flags & (DM_FLAG_ACTIVATED | \
+					  DM_FLAG_PROBE_PENDING)) == \
+				 DM_FLAG_ACTIVATED)
 
 static inline int dev_of_offset(const struct udevice *dev)
 {
 	return ofnode_to_offset(dev->node);
 }
 
+/**
+ * dev_set_ofnode() - Set the device tree node of a device
+ *
+ * Drivers which give a device a node after binding it must use this rather
+ * than setting dev->node, so that it can still be found by its node.
+ *
+ * @dev:	Device to update
+ * @node:	New node for the device
+ */
+void dev_set_ofnode(struct udevice *dev, ofnode node);
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
-	dev->node = offset_to_ofnode(of_offset);
+	dev_set_ofnode(dev, offset_to_ofnode(of_offset));
 }
 
 static inline bool dev_has_of_node(struct udevice *dev)
@@ -210,6 +236,14 @@ struct udevice_id {
  * for each.
  * @bind: Called to bind a device to its driver
  * @probe: Called to probe a device, i.e. activate it
+ * @probe_finish: Called after probe() for drivers with DM_FLAG_PROBE_ASYNC,
+ * to check whether the device is ready. This returns -EAGAIN if it is still
+ * starting up, 0 when it is ready, or another error if it failed, in which
+ * case the driver must tidy up as if probe() had failed. It is called
+ * repeatedly until it returns something other than -EAGAIN, so must not
+ * block. Only then does the uclass's post_probe() method run. If the device
+ * is needed and is not ready within CONFIG_DM_PROBE_ASYNC_TIMEOUT, remove()
+ * is called and the probe fails with -ETIMEDOUT.
  * @remove: Called to remove a device, i.e. de-activate it
  * @unbind: Called to unbind a device from its driver
  * @ofdata_to_platdata: Called before probe to decode device tree data
@@ -243,6 +277,7 @@ struct driver {
 	const struct udevice_id *of_match;
 	int (*bind)(struct udevice *dev);
 	int (*probe)(struct udevice *dev);
+	int (*probe_finish)(struct udevice *dev);
 	int (*remove)(struct udevice *dev);
 	int (*unbind)(struct udevice *dev);
 	int (*ofdata_to_platdata)(struct udevice *dev);
@@ -44,6 +44,19 @@ struct uclass_driver *lists_uclass_lookup(enum uclass_id id);
  */
 int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * If more than one driver has the compatible string, this returns the first
+ * in the linker list.
+ *
+ * @compat: Compatible string to look up
+ * @idp: Returns the driver's match for the string
+ * @return pointer to driver, or NULL if not found
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp);
+
 /**
  * lists_bind_fdt() - bind a device tree node
  *
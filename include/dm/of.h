@@ -39,6 +39,8 @@ struct property {
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
  * @sibling: Pointer to the next sibling node, or NULL if this is the last
+ * @prop_hash: Hash table of the properties, or NULL to search the list (see
+ *	CONFIG_OF_LIVE_INDEX)
  */
 struct device_node {
 	const char *name;
@@ -50,6 +52,7 @@ struct device_node {
 	struct device_node *parent;
 	struct device_node *child;
 	struct device_node *sibling;
+	struct of_prop_hash *prop_hash;
 };
 
 #define OF_MAX_PHANDLE_ARGS 16
@@ -401,6 +401,45 @@ int of_parse_phandle_with_args(const struct device_node *np,
 int of_count_phandle_with_args(const struct device_node *np,
 			       const char *list_name, const char *cells_name);
 
+/**
+ * of_write_prop() - Set the value of a property, adding it if needed
+ *
+ * The value is not copied, so must remain valid while the property exists.
+ *
+ * @np: Node to update
+ * @propname: Name of property
+ * @len: Length of value in bytes
+ * @value: New value
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int of_write_prop(struct device_node *np, const char *propname, int len,
+		  const void *value);
+
+/**
+ * of_remove_prop() - Remove a property from a node
+ *
+ * The property is unlinked from the node but not freed, since it may be
+ * part of the block allocated when the tree was unflattened.
+ *
+ * @np: Node to update
+ * @propname: Name of property
+ * @return 0 if OK, -ENOENT if the property does not exist
+ */
+int of_remove_prop(struct device_node *np, const char *propname);
+
+/**
+ * of_index_scan() - Set up faster lookups in a live tree
+ *
+ * This interns the property names, builds hash tables for nodes with many
+ * properties and an array of nodes by phandle. It does nothing unless
+ * CONFIG_OF_LIVE_INDEX is enabled. If it runs out of memory, the lookups
+ * fall back to searching.
+ *
+ * @root: Root of the tree, which must be the tree in use
+ * @return 0 if OK, -ENOMEM if not enough memory
+ */
+int of_index_scan(struct device_node *root);
+
 /**
  * of_alias_scan() - Scan all properties of the 'aliases' node
  *
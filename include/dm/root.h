@@ -114,6 +114,31 @@ int dm_init(bool of_live);
  */
 int dm_uninit(void);
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/**
+ * dm_probe_async_start() - Start probing devices which can probe in background
+ *
+ * This calls device_probe_start() on each device whose driver has the
+ * DM_FLAG_PROBE_ASYNC flag, so that slow devices can start up together.
+ * Failures are reported but otherwise ignored, as with any other device
+ * which fails to probe.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int dm_probe_async_start(void);
+
+/**
+ * dm_probe_poll() - Try to finish probing devices started in background
+ *
+ * This calls device_probe_poll() on each device whose probe is pending. It
+ * can be called from places where U-Boot is waiting anyway.
+ */
+void dm_probe_poll(void);
+#else
+static inline int dm_probe_async_start(void) { return 0; }
+static inline void dm_probe_poll(void) {}
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * dm_remove_devices_flags - Call remove function of all drivers with
@@ -182,6 +182,17 @@ int uclass_find_device_by_phandle(enum uclass_id id, struct udevice *parent,
  */
 int uclass_bind_device(struct udevice *dev);
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This keeps the uclass's index of sequence numbers up to date, so must be
+ * used instead of setting dev->seq once the device is bound.
+ *
+ * @dev:	Pointer to the device
+ * @seq:	New sequence number, or -1 for none
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
 /**
  * uclass_unbind_device() - Deassociate device with a uclass
  *
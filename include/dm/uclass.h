@@ -30,12 +30,15 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @index: Hash tables to find devices by sequence number, node and phandle,
+ * or NULL if not built (see CONFIG_DM_UCLASS_INDEX)
  */
 struct uclass {
 	void *priv;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+	struct uclass_index *index;
 };
 
 struct driver;
@@ -209,6 +209,46 @@ struct env_driver {
 
 extern struct hsearch_data env_htab;
 
+/**
+ * struct env_log_storage - storage for an environment kept as a log
+ *
+ * Each of the two areas is CONFIG_ENV_SIZE bytes long. The methods return 0
+ * if OK, -ve on error.
+ *
+ * @offset:	Offset of each area
+ * @read:	Read @len bytes from @offset into @buf
+ * @write:	Write @len bytes from @buf to @offset, which has been erased
+ * @erase:	Erase @len bytes from @offset, so it reads as 0xff
+ */
+struct env_log_storage {
+	ulong offset[2];
+	int (*read)(ulong offset, size_t len, void *buf);
+	int (*write)(ulong offset, size_t len, const void *buf);
+	int (*erase)(ulong offset, size_t len);
+};
+
+/**
+ * env_log_load() - Load an environment kept as a log of changes
+ *
+ * If neither area holds a log, this imports an environment in the usual
+ * format instead, which is converted by the next save.
+ *
+ * @stor: Storage to use
+ * @return 0 if OK, -ve on error
+ */
+int env_log_load(const struct env_log_storage *stor);
+
+/**
+ * env_log_save() - Save the environment as a log of changes
+ *
+ * This appends the changes since the last load or save if there is room,
+ * else writes the whole environment to the other area.
+ *
+ * @stor: Storage to use
+ * @return 0 if OK, -ve on error
+ */
+int env_log_save(const struct env_log_storage *stor);
+
 #endif /* DO_DEPS_ONLY */
 
 #endif /* _ENV_INTERNAL_H_ */
@@ -58,6 +58,12 @@ struct ext4_extent {
 	__le32	ee_start_lo;	/* low 32 bits of physical block */
 };
 
+/*
+ * An ee_len above EXT_INIT_MAX_LEN marks an unwritten extent, which covers
+ * ee_len - EXT_INIT_MAX_LEN blocks.
+ */
+#define EXT_INIT_MAX_LEN	(1UL << 15)
+
 /*
  * This is index on-disk structure.
  * It's used at all the levels except the bottom.
@@ -117,10 +123,20 @@ struct ext_filesystem {
 	struct blk_desc *dev_desc;
 };
 
-struct ext_block_cache {
+/* Number of metadata blocks kept by an ext_block_cache */
+#define EXT_CACHE_ENTRIES	8
+
+struct ext_block_cache_entry {
 	char *buf;
 	lbaint_t block;
 	int size;
+	unsigned int age;
+};
+
+struct ext_block_cache {
+	struct ext_block_cache_entry entry[EXT_CACHE_ENTRIES];
+	unsigned int clock;
+	char *buf;	/* data of the block returned by ext_cache_read() */
 };
 
 extern struct ext2_data *ext4fs_root;
@@ -155,6 +171,8 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, disk_partition_t *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache);
+long int read_allocated_extent(struct ext2_inode *inode, int fileblock,
+			       long int *count, struct ext_block_cache *cache);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 disk_partition_t *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
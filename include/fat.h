@@ -24,7 +24,10 @@
 			 sizeof(dir_entry))
 
 #define FATBUFBLOCKS	6
-#define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
+#define FATBUFSIZE	(mydata->sect_size * mydata->fatbufblocks)
+/* fatbuf is read and written back in chunks of FATBUFBLOCKS sectors */
+#define FATBUFCHUNKS	(mydata->fatbufblocks / FATBUFBLOCKS)
+#define FATBUFMAPSIZE	DIV_ROUND_UP(FATBUFCHUNKS, 8)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
@@ -171,6 +174,9 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	__u32	fatbufblocks;	/* Size of fatbuf in sectors */
+	__u8	*fatbuf_valid;	/* Bitmap of the chunks read into fatbuf */
+	__u8	*fatbuf_dirty;	/* Bitmap of the chunks modified in fatbuf */
 	int	rootdir_size;	/* Size of root dir for non-FAT32 */
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
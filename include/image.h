@@ -32,8 +32,12 @@ struct fdt_region;
 #define CONFIG_FIT_VERBOSE	1 /* enable fit_format_{error,warning}() */
 #define CONFIG_FIT_ENABLE_RSASSA_PSS_SUPPORT 1
 #define CONFIG_FIT_ENABLE_SHA256_SUPPORT
+#define CONFIG_FIT_ENABLE_SHA384_SUPPORT
+#define CONFIG_FIT_ENABLE_SHA512_SUPPORT
 #define CONFIG_SHA1
 #define CONFIG_SHA256
+#define CONFIG_SHA384
+#define CONFIG_SHA512
 
 #define IMAGE_ENABLE_IGNORE	0
 #define IMAGE_INDENT_STRING	""
@@ -57,6 +61,9 @@ struct fdt_region;
 #include <hash.h>
 #include <linux/libfdt.h>
 #include <fdt_support.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
 # ifdef CONFIG_SPL_BUILD
 #  ifdef CONFIG_SPL_CRC32_SUPPORT
 #   define IMAGE_ENABLE_CRC32	1
@@ -92,6 +99,20 @@ struct fdt_region;
 #define IMAGE_ENABLE_SHA256	0
 #endif
 
+#if defined(CONFIG_FIT_ENABLE_SHA384_SUPPORT) || \
+	defined(CONFIG_SPL_SHA384_SUPPORT)
+#define IMAGE_ENABLE_SHA384	1
+#else
+#define IMAGE_ENABLE_SHA384	0
+#endif
+
+#if defined(CONFIG_FIT_ENABLE_SHA512_SUPPORT) || \
+	defined(CONFIG_SPL_SHA512_SUPPORT)
+#define IMAGE_ENABLE_SHA512	1
+#else
+#define IMAGE_ENABLE_SHA512	0
+#endif
+
 #endif /* IMAGE_ENABLE_FIT */
 
 #ifdef CONFIG_SYS_BOOT_GET_CMDLINE
@@ -303,6 +324,7 @@ enum {
 	IH_COMP_LZMA,			/* lzma  Compression Used	*/
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -1054,6 +1076,98 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 
 int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *data, size_t size);
+
+/* Number of hash nodes per image which are computed progressively */
+#define FIT_VERIFY_MAX_HASHES	4
+
+enum fit_verify_algo {
+	FIT_VERIFY_ALGO_NONE,
+	FIT_VERIFY_ALGO_CRC32,
+	FIT_VERIFY_ALGO_SHA1,
+	FIT_VERIFY_ALGO_SHA256,
+	FIT_VERIFY_ALGO_SHA384,
+	FIT_VERIFY_ALGO_SHA512,
+};
+
+/**
+ * struct fit_verify_hash - progressive state of one hash node
+ *
+ * @noffset: Offset of the hash node
+ * @algo: Algorithm, FIT_VERIFY_ALGO_NONE if it is computed at the end
+ * @value_len: Length of @value, 0 until the hash is final
+ * @value: Final hash value
+ */
+struct fit_verify_hash {
+	int noffset;
+	int algo;
+	int value_len;
+	union {
+		uint32_t crc32;
+		sha1_context sha1;
+		sha256_context sha256;
+		sha512_context sha512;
+	} ctx;
+	uint8_t value[FIT_MAX_HASH_LEN];
+};
+
+/**
+ * struct fit_verify_ctx - state of an incremental image verification
+ *
+ * @fit: FIT containing the image
+ * @image_noffset: Offset of the component image node
+ * @count: Number of entries in @hash
+ * @done: Number of data bytes hashed so far
+ * @hash: State of each hash node that is computed progressively
+ */
+struct fit_verify_ctx {
+	const void *fit;
+	int image_noffset;
+	int count;
+	size_t done;
+	struct fit_verify_hash hash[FIT_VERIFY_MAX_HASHES];
+};
+
+/**
+ * fit_image_verify_start() - Start verifying image data incrementally
+ *
+ * This sets up progressive hashing for the hash nodes of an image, so that
+ * its data can be verified while it is being loaded, and each byte is only
+ * read once however many hash nodes there are. Feed the data in order with
+ * fit_image_verify_update() and check it with fit_image_verify_finish().
+ *
+ * @ctx:		Verification state to set up
+ * @fit:		FIT containing the image
+ * @image_noffset:	Offset of the component image node
+ */
+void fit_image_verify_start(struct fit_verify_ctx *ctx, const void *fit,
+			    int image_noffset);
+
+/**
+ * fit_image_verify_update() - Hash the next part of the image data
+ *
+ * @ctx:	Verification state
+ * @buf:	Data following what was hashed so far
+ * @len:	Number of bytes in @buf
+ */
+void fit_image_verify_update(struct fit_verify_ctx *ctx, const void *buf,
+			     size_t len);
+
+/**
+ * fit_image_verify_finish() - Check the hashes and signatures of an image
+ *
+ * This compares the hash values with those in the FIT and checks any
+ * signatures, printing the result like fit_image_verify_with_data().
+ * Signatures, and hash algorithms that cannot be computed progressively,
+ * are checked against the complete image data.
+ *
+ * @ctx:	Verification state
+ * @data:	Complete image data
+ * @size:	Size of the image data
+ * @return 1 if all hashes and required signatures are valid, 0 otherwise
+ */
+int fit_image_verify_finish(struct fit_verify_ctx *ctx, const void *data,
+			    size_t size);
+
 int fit_image_verify(const void *fit, int noffset);
 int fit_config_verify(const void *fit, int conf_noffset);
 int fit_all_image_verify(const void *fit);
@@ -21,4 +21,22 @@
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * ulz4fn_frame_size() - Find the sizes of an LZ4 frame without decompressing
+ *
+ * This walks the block headers, so several frames which follow each other
+ * can be split up and decompressed separately with ulz4fn().
+ *
+ * @src: Start of the frame
+ * @srcn: Length of data from @src
+ * @framen: Returns length of the frame, so the next one starts at
+ *	@src + @framen
+ * @contentn: Returns the decompressed size of the frame
+ * @return 0 if OK, -ENODATA if the frame header has no content size,
+ *	-EPROTONOSUPPORT if the frame is not in a format supported by ulz4fn(),
+ *	-EINVAL if it is corrupt or truncated
+ */
+int ulz4fn_frame_size(const void *src, size_t srcn, size_t *framen,
+		      u64 *contentn);
+
 #endif
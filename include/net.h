@@ -29,8 +29,10 @@
  *
  */
 
-#ifdef CONFIG_SYS_RX_ETH_BUFFER
+#if defined(CONFIG_SYS_RX_ETH_BUFFER)
 # define PKTBUFSRX	CONFIG_SYS_RX_ETH_BUFFER
+#elif defined(CONFIG_NET_RX_BUFFERS)
+# define PKTBUFSRX	CONFIG_NET_RX_BUFFERS
 #else
 # define PKTBUFSRX	4
 #endif
@@ -112,6 +114,11 @@ enum eth_recv_flags {
 	ETH_RECV_CHECK_DEVICE		= 1 << 0,
 };
 
+enum eth_pkt_flags {
+	/* The hardware has checked the packet's UDP checksum */
+	ETH_PKT_CSUM_VALID		= 1 << 0,
+};
+
 /**
  * struct eth_ops - functions of Ethernet MAC controllers
  *
@@ -122,6 +129,13 @@ enum eth_recv_flags {
  *	 indicate that the hardware receive FIFO is empty. If 0 is returned, the
  *	 network stack will not process the empty packet, but free_pkt() will be
  *	 called if supplied
+ * recv_batch: Like recv, but return up to "count" packets at once, filling
+ *	       in packetp[] and lengths[]. Flags from enum eth_pkt_flags may be
+ *	       set in pkt_flags[], which is cleared by the caller. Returns the
+ *	       number of packets, 0 if there are none or an error. The packets
+ *	       must stay valid until the stack hands each of them back with
+ *	       free_pkt(), which it does in order once the whole batch is
+ *	       processed - optional
  * free_pkt: Give the driver an opportunity to manage its packet buffer memory
  *	     when the network stack is finished processing it. This will only be
  *	     called when no error was returned from recv - optional
@@ -142,6 +156,8 @@ struct eth_ops {
 	int (*start)(struct udevice *dev);
 	int (*send)(struct udevice *dev, void *packet, int length);
 	int (*recv)(struct udevice *dev, int flags, uchar **packetp);
+	int (*recv_batch)(struct udevice *dev, int flags, uchar **packetp,
+			  int *lengths, uint *pkt_flags, int count);
 	int (*free_pkt)(struct udevice *dev, uchar *packet, int length);
 	void (*stop)(struct udevice *dev);
 	int (*mcast)(struct udevice *dev, const u8 *enetaddr, int join);
@@ -159,6 +175,43 @@ struct udevice *eth_get_dev(void); /* get the current device */
 struct udevice *eth_get_dev_by_name(const char *devname);
 unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 
+/**
+ * struct eth_rx_stats - receive statistics of an Ethernet device
+ *
+ * @polls: Number of polls which returned at least one packet
+ * @packets: Number of packets received
+ * @max_batch: Largest number of packets received in a single poll
+ * @ring_full: Number of polls which found a full receive ring, or at least as
+ *	many packets as are processed in one poll
+ * @dropped: Number of packets the driver reported as dropped
+ */
+struct eth_rx_stats {
+	ulong polls;
+	ulong packets;
+	ulong max_batch;
+	ulong ring_full;
+	ulong dropped;
+};
+
+/**
+ * eth_get_rx_stats() - Read and reset the receive statistics of a device
+ *
+ * @dev: Ethernet device
+ * @stats: Returns the statistics gathered since the last call
+ */
+void eth_get_rx_stats(struct udevice *dev, struct eth_rx_stats *stats);
+
+/**
+ * eth_rx_dropped() - Account for packets a driver had to drop
+ *
+ * Drivers call this when a packet is lost because no receive buffer was
+ * available, so that the number of buffers can be sized properly.
+ *
+ * @dev: Ethernet device
+ * @count: Number of packets dropped
+ */
+void eth_rx_dropped(struct udevice *dev, int count);
+
 /* Used only when NetConsole is enabled */
 int eth_is_active(struct udevice *dev); /* Test device for active state */
 int eth_init_state_only(void); /* Set active state */
@@ -520,6 +573,7 @@ extern uchar		*net_tx_packet;		/* THE transmit packet */
 extern uchar		*net_rx_packets[PKTBUFSRX]; /* Receive packets */
 extern uchar		*net_rx_packet;		/* Current receive packet */
 extern int		net_rx_packet_len;	/* Current rx packet length */
+extern bool		net_rx_csum_valid;	/* Current rx packet checksum checked */
 extern const u8		net_bcast_ethaddr[ARP_HLEN];	/* Ethernet broadcast address */
 extern const u8		net_null_ethaddr[ARP_HLEN];
 
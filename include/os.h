@@ -321,6 +321,19 @@ int os_spl_to_uboot(const char *fname);
  */
 void os_localtime(struct rtc_time *rt);
 
+/**
+ * os_thread_create() - Run a function in a new host thread
+ *
+ * This is used to emulate secondary CPUs. The function runs alongside
+ * U-Boot, so must not use anything which is not thread-safe, such as
+ * malloc(). The thread is never waited for, so it exits when @func returns.
+ *
+ * @func:	Function to run
+ * @arg:	Argument to pass to @func
+ * @return 0 if OK, -ve on error
+ */
+int os_thread_create(void (*func)(void *arg), void *arg);
+
 /**
  * os_abort() - Raise SIGABRT to exit sandbox (e.g. to debugger)
  */
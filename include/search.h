@@ -45,6 +45,13 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Indexes of the entries with the lowest and highest keys, 0 if none */
+	unsigned int first;
+	unsigned int last;
+	/* Bytes needed to export all entries as "name=value\0" strings */
+	size_t export_len;
+	/* Non-zero while the table must not be moved by a resize */
+	int busy;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -56,7 +63,10 @@ struct hsearch_data {
 			 enum env_op, int flag);
 };
 
-/* Create a new hash table which will contain at most "nel" elements.  */
+/*
+ * Create a new hash table which will contain "nel" elements. It is grown
+ * automatically if more entries are added.
+ */
 int hcreate_r(size_t nel, struct hsearch_data *htab);
 
 /* Destroy current internal hash table.  */
@@ -110,5 +120,6 @@ int hwalk_r(struct hsearch_data *htab,
 #define H_MATCH_METHOD	(H_MATCH_IDENT | H_MATCH_SUBSTR | H_MATCH_REGEX)
 #define H_PROGRAMMATIC	(1 << 9) /* indicate that an import is from env_set() */
 #define H_ORIGIN_FLAGS	(H_INTERACTIVE | H_PROGRAMMATIC)
+#define H_INCREMENTAL	(1 << 10) /* only apply changes when replacing env */
 
 #endif /* _SEARCH_H_ */
@@ -82,6 +82,32 @@ uint32_t crc32_wd(uint32_t crc, const unsigned char *buf, uint len,
  */
 uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len);
 
+/**
+ * crc32_no_comp_generic - Portable version of crc32_no_comp()
+ *
+ * crc32_no_comp() is weak, so that an architecture can provide a version
+ * using CRC instructions. Such a version calls this one for CPUs without
+ * them.
+ */
+uint32_t crc32_no_comp_generic(uint32_t crc, const unsigned char *buf,
+			       uint len);
+
+/**
+ * crc32_slice8 - Calculate a bit-reflected CRC32 eight bytes at a time
+ *
+ * This is the table-driven code shared by CRC-32 and CRC-32C. There is no
+ * one's compliment, as for crc32_no_comp().
+ *
+ * @crc: Input crc to chain from a previous calculation
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
+ * @tab: Eight tables, table k holding the CRC of each byte value followed by
+ *	k zero bytes
+ * @return checksum value
+ */
+uint32_t crc32_slice8(uint32_t crc, const uint8_t *buf, uint len,
+		      const uint32_t (*tab)[256]);
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
@@ -95,6 +121,25 @@ void crc32_wd_buf(const uint8_t *input, uint ilen, uint8_t *output,
 
 /* lib/crc32c.c */
 
+/**
+ * crc32c_no_comp() - Calculate the CRC32C (Castagnoli) of a block of data
+ *
+ * There is no one's compliment: callers such as btrfs start from ~0 and
+ * invert the result themselves. This is weak so that an architecture can
+ * provide a version using CRC instructions.
+ *
+ * @crc: Input crc to chain from a previous calculation
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
+ * @return checksum value
+ */
+uint32_t crc32c_no_comp(uint32_t crc, const void *buf, uint len);
+
+/**
+ * crc32c_no_comp_generic() - Portable version of crc32c_no_comp()
+ */
+uint32_t crc32c_no_comp_generic(uint32_t crc, const void *buf, uint len);
+
 /**
  * crc32c_init() - Set up a the CRC32 table
  *
@@ -60,6 +60,22 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
  */
 void sha1_finish( sha1_context *ctx, unsigned char output[20] );
 
+/**
+ * sha1_process() - Hash whole 64-byte blocks of input
+ *
+ * This is overridden by architectures with SHA-1 instructions.
+ *
+ * @ctx:	SHA-1 context
+ * @data:	Input data, any alignment
+ * @blocks:	Number of 64-byte blocks in @data
+ */
+void sha1_process(sha1_context *ctx, const unsigned char *data,
+		  unsigned int blocks);
+
+/* Portable C version of sha1_process() */
+void sha1_process_generic(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks);
+
 /**
  * \brief	   Output = SHA-1( input buffer )
  *
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+#ifndef _SHA512_H
+#define _SHA512_H
+
+#define SHA384_SUM_LEN		48
+#define SHA512_SUM_LEN		64
+#define SHA512_BLOCK_SIZE	128
+
+#define CHUNKSZ_SHA384	(16 * 1024)
+#define CHUNKSZ_SHA512	(16 * 1024)
+
+/* SHA-384 is SHA-512 with other initial values and a truncated result */
+typedef struct {
+	uint64_t state[8];
+	uint64_t count[2];
+	uint8_t buf[SHA512_BLOCK_SIZE];
+} sha512_context;
+
+void sha512_starts(sha512_context *ctx);
+void sha512_update(sha512_context *ctx, const uint8_t *input, uint32_t length);
+void sha512_finish(sha512_context *ctx, uint8_t digest[SHA512_SUM_LEN]);
+
+void sha512_csum_wd(const unsigned char *input, unsigned int ilen,
+		    unsigned char *output, unsigned int chunk_sz);
+
+void sha384_starts(sha512_context *ctx);
+void sha384_update(sha512_context *ctx, const uint8_t *input, uint32_t length);
+void sha384_finish(sha512_context *ctx, uint8_t digest[SHA384_SUM_LEN]);
+
+void sha384_csum_wd(const unsigned char *input, unsigned int ilen,
+		    unsigned char *output, unsigned int chunk_sz);
+
+#endif /* _SHA512_H */
@@ -88,6 +88,24 @@ enum {
 	PACKET_SIZE_64  = 3,
 };
 
+/**
+ * struct usb_ep_stats - transfer statistics for one endpoint
+ *
+ * These are kept for bulk transfers, when CONFIG_USB_STATS is enabled.
+ *
+ * @transfers:	Number of transfers submitted to the controller
+ * @errors:	Number of transfers which failed
+ * @descs:	Number of transfer descriptors the controller queued for them
+ *		(e.g. XHCI TRBs), or 0 if it does not count these
+ * @bytes:	Number of bytes transferred
+ */
+struct usb_ep_stats {
+	ulong transfers;
+	ulong errors;
+	ulong descs;
+	u64 bytes;
+};
+
 /**
  * struct usb_device - information about a USB device
  *
@@ -152,6 +170,10 @@ struct usb_device {
 	struct udevice *dev;		/* Pointer to associated device */
 	struct udevice *controller_dev;	/* Pointer to associated controller */
 #endif
+#ifdef CONFIG_USB_STATS
+	/* statistics for each endpoint; [0] = IN, [1] = OUT */
+	struct usb_ep_stats ep_stats[2][16];
+#endif
 };
 
 struct int_queue;
@@ -406,6 +428,11 @@ int usb_get_port_status(struct usb_device *dev, int port, void *data);
 				((usb_pipeendpoint(pipe) * 2) - \
 				 (usb_pipein(pipe) ? 0 : 1))
 
+#ifdef CONFIG_USB_STATS
+#define usb_pipe_stats(dev, pipe) \
+		(&(dev)->ep_stats[usb_pipeout(pipe)][usb_pipeendpoint(pipe)])
+#endif
+
 /**
  * struct usb_device_id - identifies USB devices for probing and hotplugging
  * @match_flags: Bit mask controlling which of the other fields are used to
@@ -45,6 +45,7 @@
 #define US_PR_CB               1		/* Control/Bulk w/o interrupt */
 #define US_PR_CBI              0		/* Control/Bulk/Interrupt */
 #define US_PR_BULK             0x50		/* bulk only */
+#define US_PR_UAS              0x62		/* USB Attached SCSI */
 
 /* USB types */
 #define USB_TYPE_STANDARD   (0x00 << 5)
@@ -362,4 +363,58 @@ struct umass_bbb_csw {
 #define US_BBB_RESET		0xff
 #define US_BBB_GET_MAX_LUN	0xfe
 
+/*
+ * USB Attached SCSI
+ */
+
+/* Pipe Usage descriptor, following each endpoint of a UAS interface */
+#define USB_DT_PIPE_USAGE	0x24
+struct uas_pipe_usage_desc {
+	__u8		bLength;
+	__u8		bDescriptorType;
+	__u8		bPipeID;
+#	define UAS_PIPE_ID_CMD		1
+#	define UAS_PIPE_ID_STATUS	2
+#	define UAS_PIPE_ID_DATA_IN	3
+#	define UAS_PIPE_ID_DATA_OUT	4
+	__u8		Reserved;
+};
+
+/* Information Unit IDs */
+#define UAS_IU_COMMAND		0x01
+#define UAS_IU_SENSE		0x03
+#define UAS_IU_RESPONSE		0x04
+#define UAS_IU_READ_READY	0x06
+#define UAS_IU_WRITE_READY	0x07
+
+/* Command IU, sent on the command pipe */
+struct uas_command_iu {
+	__u8		iu_id;
+	__u8		rsvd1;
+	__be16		tag;
+	__u8		prio_attr;
+	__u8		rsvd5;
+	__u8		len;		/* additional CDB length, in dwords << 2 */
+	__u8		rsvd7;
+	__u8		lun[8];
+	__u8		cdb[16];
+};
+#define UAS_COMMAND_IU_SIZE	32
+
+/*
+ * Sense IU, received on the status pipe. Read Ready, Write Ready and
+ * Response IUs are received into it too, as they share the first fields.
+ */
+struct uas_sense_iu {
+	__u8		iu_id;
+	__u8		rsvd1;
+	__be16		tag;
+	__be16		status_qual;
+	__u8		status;
+	__u8		rsvd7[7];
+	__be16		len;
+	__u8		sense[96];
+};
+#define UAS_SENSE_IU_SIZE	112
+
 #endif /*_USB_DEFS_H_ */
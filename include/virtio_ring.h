@@ -90,6 +90,8 @@ struct vring {
  * @num_free: number of elements we expect to be able to fit
  * @vring: actual memory layout for this queue
  * @event: host publishes avail event idx
+ * @indir_desc: indirect descriptor table for each head, or NULL if
+ *	VIRTIO_RING_F_INDIRECT_DESC is not in use
  * @free_head: head of free buffer list
  * @num_added: number we've added since last sync
  * @last_used_idx: last used index we've seen
@@ -103,6 +105,7 @@ struct virtqueue {
 	unsigned int num_free;
 	struct vring vring;
 	bool event;
+	struct vring_desc **indir_desc;
 	unsigned int free_head;
 	unsigned int num_added;
 	u16 last_used_idx;
@@ -178,6 +181,19 @@ struct virtio_sg;
 int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 		  unsigned int out_sgs, unsigned int in_sgs);
 
+/**
+ * virtqueue_has_room - check whether a buffer fits in a virtqueue
+ *
+ * @vq:		the struct virtqueue we're talking about
+ * @total_sg:	the number of scatterlists in the buffer
+ *
+ * A buffer in several parts takes a single descriptor in the ring if
+ * VIRTIO_RING_F_INDIRECT_DESC was negotiated, else one for each part.
+ *
+ * Returns true if there are enough free descriptors for virtqueue_add().
+ */
+bool virtqueue_has_room(struct virtqueue *vq, unsigned int total_sg);
+
 /**
  * virtqueue_kick - update after add_buf
  *
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Zstandard decompression for images
+ */
+
+#ifndef __ZSTD_H
+#define __ZSTD_H
+
+#include <linux/types.h>
+
+/**
+ * zstd_decompress() - Decompress Zstandard data
+ *
+ * The data may hold several frames, which are decompressed one after the
+ * other. Skippable frames are ignored.
+ *
+ * @src: Source data to decompress
+ * @srcn: Length of source data
+ * @dst: Destination for uncompressed data
+ * @dstn: On entry, the size of @dst. Returns length of uncompressed data,
+ *	which is all of @dst if it was too small, or 0 on other errors
+ * @return 0 if OK, -ENOMEM if the decompression context cannot be allocated,
+ *	-ENOSPC if the destination buffer is overrun, -EPROTONOSUPPORT if the
+ *	data is not in Zstandard format, -EINVAL if it is corrupt
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif
@@ -12,6 +12,35 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <u-boot/crc.h>
+#if CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+#include "crc32ctable.h"
+#endif
+
+/* Bit-reflected CRC32C polynomial */
+#define CRC32C_POLY	0x82f63b78
+
+uint32_t crc32c_no_comp_generic(uint32_t crc, const void *buf, uint len)
+{
+#if CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+	return crc32_slice8(crc, buf, len, crc32c_table8);
+#else
+	static uint32_t table[256];
+	static bool table_ready;
+
+	if (!table_ready) {
+		crc32c_init(table, CRC32C_POLY);
+		table_ready = true;
+	}
+
+	return crc32c_cal(crc, buf, len, table);
+#endif
+}
+
+__weak uint32_t crc32c_no_comp(uint32_t crc, const void *buf, uint len)
+{
+	return crc32c_no_comp_generic(crc, buf, len);
+}
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompressing the independent frames of an image on several CPUs
+ *
+ * The frames are shared out before any CPU starts, frame i going to worker
+ * i % nworkers, so the workers need nothing but plain loads and stores to
+ * coordinate. Worker 0 runs on this CPU.
+ */
+
+#include <common.h>
+#include <cpu.h>
+#include <decomp_parallel.h>
+#include <dm.h>
+#include <image.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <linux/zstd.h>
+
+/**
+ * struct decomp_frame - a frame of the compressed data
+ *
+ * @src:	Start of the frame
+ * @srcn:	Length of the frame in bytes
+ * @dst:	Where its decompressed data goes
+ * @dstn:	Length of its decompressed data, from the frame header
+ */
+struct decomp_frame {
+	const void *src;
+	size_t srcn;
+	void *dst;
+	size_t dstn;
+};
+
+/**
+ * struct decomp_worker - a CPU decompressing some of the frames
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @frames:	All of the frames
+ * @count:	Number of frames
+ * @first:	Index of the first frame for this worker
+ * @step:	Number of workers, so the distance to its next frame
+ * @cpu:	CPU running the worker, or NULL for this one
+ * @dctx:	zstd decompression context, set up before the worker runs
+ * @err:	Returns 0 if OK, else the error from the first bad frame
+ */
+struct decomp_worker {
+	int comp;
+	const struct decomp_frame *frames;
+	int count;
+	int first;
+	int step;
+	struct udevice *cpu;
+	ZSTD_DCtx *dctx;
+	int err;
+};
+
+static int decomp_frame(struct decomp_worker *w, const struct decomp_frame *f)
+{
+	size_t len, ret;
+	int err;
+
+	switch (w->comp) {
+	case IH_COMP_LZ4:
+		if (!CONFIG_IS_ENABLED(LZ4))
+			return -ENOSYS;
+		len = f->dstn;
+		err = ulz4fn(f->src, f->srcn, f->dst, &len);
+		if (err)
+			return err;
+		break;
+	case IH_COMP_ZSTD:
+		if (!CONFIG_IS_ENABLED(ZSTD))
+			return -ENOSYS;
+		ret = ZSTD_decompressDCtx(w->dctx, f->dst, f->dstn, f->src,
+					  f->srcn);
+		if (ZSTD_isError(ret))
+			return -EINVAL;
+		len = ret;
+		break;
+	default:
+		return -ENOSYS;
+	}
+
+	/* A frame must fill the space its header claims */
+	return len == f->dstn ? 0 : -EINVAL;
+}
+
+/* Runs on each CPU, so must not call malloc() or print anything */
+static void decomp_worker(void *arg)
+{
+	struct decomp_worker *w = arg;
+	int i, ret;
+
+	w->err = 0;
+	for (i = w->first; i < w->count; i += w->step) {
+		ret = decomp_frame(w, &w->frames[i]);
+		if (ret && !w->err)
+			w->err = ret;
+	}
+}
+
+/**
+ * decomp_next_frame() - Find the sizes of the next frame
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @src:	Start of the frame
+ * @srcn:	Length of data from @src
+ * @framen:	Returns the length of the frame
+ * @contentn:	Returns its decompressed size, 0 for a frame to skip
+ * @return 0 if OK, -ENOSYS if the decompressed size is not known, other -ve
+ *	value if the frame is corrupt
+ */
+static int decomp_next_frame(int comp, const void *src, size_t srcn,
+			     size_t *framen, u64 *contentn)
+{
+	unsigned long long size;
+	size_t ret;
+	int err;
+
+	switch (comp) {
+	case IH_COMP_LZ4:
+		if (!CONFIG_IS_ENABLED(LZ4))
+			return -ENOSYS;
+		err = ulz4fn_frame_size(src, srcn, framen, contentn);
+		return err == -ENODATA ? -ENOSYS : err;
+	case IH_COMP_ZSTD:
+		if (!CONFIG_IS_ENABLED(ZSTD))
+			return -ENOSYS;
+		ret = ZSTD_findFrameCompressedSize(src, srcn);
+		if (ZSTD_isError(ret))
+			return -EINVAL;
+		size = ZSTD_getFrameContentSize(src, srcn);
+		if (size == ZSTD_CONTENTSIZE_UNKNOWN)
+			return -ENOSYS;
+		if (size == ZSTD_CONTENTSIZE_ERROR)
+			return -EINVAL;
+		/* A skippable frame has a size of 0 */
+		*framen = ret;
+		*contentn = size;
+		return 0;
+	default:
+		return -ENOSYS;
+	}
+}
+
+/**
+ * decomp_split() - Split the compressed data into frames
+ *
+ * @frames:	Returns the frames, or pass NULL to just count them
+ * @return number of frames if OK, -ENOSPC if they do not fit in @dstn
+ *	bytes, other -ve value on error
+ */
+static int decomp_split(int comp, const void *src, size_t srcn, void *dst,
+			size_t dstn, struct decomp_frame *frames)
+{
+	size_t pos, out = 0, framen;
+	u64 contentn;
+	int count = 0;
+	int ret;
+
+	for (pos = 0; pos < srcn; pos += framen) {
+		ret = decomp_next_frame(comp, src + pos, srcn - pos, &framen,
+					&contentn);
+		if (ret)
+			return ret;
+		if (!contentn)
+			continue;
+		if (contentn > dstn - out)
+			return -ENOSPC;
+		if (frames) {
+			frames[count].src = src + pos;
+			frames[count].srcn = framen;
+			frames[count].dst = dst + out;
+			frames[count].dstn = contentn;
+		}
+		out += contentn;
+		count++;
+	}
+
+	return count;
+}
+
+/* Find the CPUs other than this one, returning how many there are */
+static int decomp_find_cpus(struct udevice **cpus, int max)
+{
+	struct udevice *dev;
+	int count = 0;
+
+	for (uclass_first_device(UCLASS_CPU, &dev);
+	     dev;
+	     uclass_next_device(&dev)) {
+		if (cpu_is_current(dev) == 1)
+			continue;
+		if (cpus) {
+			if (count == max)
+				break;
+			cpus[count] = dev;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+int decomp_parallel(int comp, const void *src, size_t srcn, void *dst,
+		    size_t *dstn)
+{
+	struct decomp_frame *frames = NULL;
+	struct decomp_worker *workers = NULL;
+	struct udevice **cpus = NULL;
+	bool zstd = CONFIG_IS_ENABLED(ZSTD) && comp == IH_COMP_ZSTD;
+	size_t wsize = 0;
+	void *workspace = NULL;
+	int count, ncpus, nworkers;
+	int i, ret;
+
+	if (src < dst + *dstn && dst < src + srcn)
+		return -ENOSYS;
+
+	count = decomp_split(comp, src, srcn, dst, *dstn, NULL);
+	if (count < 0)
+		return count;
+	ncpus = decomp_find_cpus(NULL, 0);
+	if (count < 2 || !ncpus)
+		return -ENOSYS;
+	nworkers = min(count, ncpus + 1);
+
+	frames = calloc(count, sizeof(*frames));
+	workers = calloc(nworkers, sizeof(*workers));
+	cpus = calloc(ncpus, sizeof(*cpus));
+	if (zstd) {
+		wsize = ZSTD_DCtxWorkspaceBound();
+		workspace = malloc(wsize * nworkers);
+	}
+	if (!frames || !workers || !cpus ||
+	    (zstd && !workspace)) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	decomp_split(comp, src, srcn, dst, *dstn, frames);
+	decomp_find_cpus(cpus, ncpus);
+
+	for (i = 0; i < nworkers; i++) {
+		struct decomp_worker *w = &workers[i];
+
+		w->comp = comp;
+		w->frames = frames;
+		w->count = count;
+		w->first = i;
+		w->step = nworkers;
+		if (zstd)
+			w->dctx = ZSTD_initDCtx(workspace + i * wsize, wsize);
+	}
+
+	/* A CPU which cannot run the worker leaves its frames to this one */
+	for (i = 1; i < nworkers; i++) {
+		if (!cpu_run(cpus[i - 1], decomp_worker, &workers[i]))
+			workers[i].cpu = cpus[i - 1];
+	}
+	decomp_worker(&workers[0]);
+
+	ret = workers[0].err;
+	for (i = 1; i < nworkers; i++) {
+		struct decomp_worker *w = &workers[i];
+		int err;
+
+		/*
+		 * A CPU which did not start never runs its worker, so its
+		 * frames are decompressed here instead
+		 */
+		if (w->cpu && cpu_wait(w->cpu))
+			w->cpu = NULL;
+		if (!w->cpu)
+			decomp_worker(w);
+		err = w->err;
+		if (err && !ret)
+			ret = err;
+	}
+	if (!ret)
+		*dstn = frames[count - 1].dst + frames[count - 1].dstn - dst;
+	debug("%s: %d frames on %d CPUs, err %d\n", __func__, count,
+	      nworkers, ret);
+
+out:
+	free(workspace);
+	free(cpus);
+	free(workers);
+	free(frames);
+
+	return ret;
+}
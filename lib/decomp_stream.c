@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompressing data a piece at a time, as it is loaded
+ */
+
+#include <common.h>
+#include <decomp_stream.h>
+#include <image.h>
+
+int decomp_stream_start(struct decomp_stream *ds, int comp, void *dst,
+			size_t dst_size)
+{
+	int ret;
+
+	memset(ds, '\0', sizeof(*ds));
+	ds->comp = comp;
+	ds->dst = dst;
+	ds->dst_size = dst_size;
+
+	switch (comp) {
+	case IH_COMP_NONE:
+		ret = 0;
+		break;
+#if CONFIG_IS_ENABLED(GZIP)
+	case IH_COMP_GZIP:
+		ret = gzip_stream_start(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZ4)
+	case IH_COMP_LZ4:
+		ret = lz4_stream_start(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZMA)
+	case IH_COMP_LZMA:
+		ret = lzma_stream_start(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(ZSTD)
+	case IH_COMP_ZSTD:
+		ret = zstd_stream_start(ds);
+		break;
+#endif
+	default:
+		debug("%s: cannot stream compression type %d\n", __func__,
+		      comp);
+		return -ENOSYS;
+	}
+	if (ret)
+		debug("%s: error %d\n", __func__, ret);
+
+	return ret;
+}
+
+int decomp_stream_write(struct decomp_stream *ds, const void *buf, size_t len)
+{
+	int ret;
+
+	if (ds->err)
+		return ds->err;
+	if (!len)
+		return 0;
+
+	switch (ds->comp) {
+	case IH_COMP_NONE:
+		if (len > ds->dst_size - ds->pos) {
+			ret = -ENOSPC;
+			break;
+		}
+		memcpy(ds->dst + ds->pos, buf, len);
+		ds->pos += len;
+		ret = 0;
+		break;
+#if CONFIG_IS_ENABLED(GZIP)
+	case IH_COMP_GZIP:
+		ret = gzip_stream_write(ds, buf, len);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZ4)
+	case IH_COMP_LZ4:
+		ret = lz4_stream_write(ds, buf, len);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZMA)
+	case IH_COMP_LZMA:
+		ret = lzma_stream_write(ds, buf, len);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(ZSTD)
+	case IH_COMP_ZSTD:
+		ret = zstd_stream_write(ds, buf, len);
+		break;
+#endif
+	default:
+		ret = -ENOSYS;
+		break;
+	}
+	if (ret) {
+		debug("%s: error %d after %zu bytes\n", __func__, ret, ds->pos);
+		ds->err = ret;
+	}
+
+	return ret;
+}
+
+int decomp_stream_finish(struct decomp_stream *ds, size_t *lenp)
+{
+	switch (ds->comp) {
+#if CONFIG_IS_ENABLED(GZIP)
+	case IH_COMP_GZIP:
+		gzip_stream_end(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZ4)
+	case IH_COMP_LZ4:
+		lz4_stream_end(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(LZMA)
+	case IH_COMP_LZMA:
+		lzma_stream_end(ds);
+		break;
+#endif
+#if CONFIG_IS_ENABLED(ZSTD)
+	case IH_COMP_ZSTD:
+		zstd_stream_end(ds);
+		break;
+#endif
+	}
+	ds->priv = NULL;
+
+	if (lenp)
+		*lenp = ds->pos;
+	if (ds->err)
+		return ds->err;
+	if (!ds->done && ds->comp != IH_COMP_NONE)
+		return -EINVAL;
+
+	return 0;
+}
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <decomp_stream.h>
 #include <div64.h>
 #include <gzip.h>
 #include <image.h>
@@ -307,3 +308,69 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 
 	return err;
 }
+
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+int gzip_stream_start(struct decomp_stream *ds)
+{
+	z_stream *s;
+	int r;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+	s->zalloc = gzalloc;
+	s->zfree = gzfree;
+
+	/*
+	 * zlib parses the gzip header and checks the CRC in the trailer. It
+	 * allocates its own 32KiB window once the output is first written.
+	 */
+	r = inflateInit2(s, 16 + MAX_WBITS);
+	if (r != Z_OK) {
+		free(s);
+		return -ENOMEM;
+	}
+	s->next_out = ds->dst;
+	s->avail_out = min_t(size_t, ds->dst_size, UINT_MAX);
+	ds->priv = s;
+
+	return 0;
+}
+
+int gzip_stream_write(struct decomp_stream *ds, const void *buf, size_t len)
+{
+	z_stream *s = ds->priv;
+	int r;
+
+	if (ds->done)
+		return 0;
+
+	s->next_in = (unsigned char *)buf;
+	s->avail_in = len;
+	r = inflate(s, Z_NO_FLUSH);
+	ds->pos = s->next_out - (unsigned char *)ds->dst;
+	switch (r) {
+	case Z_STREAM_END:
+		ds->done = true;
+		return 0;
+	case Z_OK:
+		/* inflate() only stops early if the output is full */
+		return s->avail_in ? -ENOSPC : 0;
+	case Z_BUF_ERROR:
+		return -ENOSPC;
+	case Z_MEM_ERROR:
+		return -ENOMEM;
+	default:
+		debug("%s: inflate() returned %d\n", __func__, r);
+		return -EINVAL;
+	}
+}
+
+void gzip_stream_end(struct decomp_stream *ds)
+{
+	z_stream *s = ds->priv;
+
+	inflateEnd(s);
+	free(s);
+}
+#endif /* DECOMP_STREAM */
@@ -14,7 +14,6 @@
 
 #include <errno.h>
 #include <malloc.h>
-#include <sort.h>
 
 #ifdef USE_HOSTCC		/* HOST build */
 # include <string.h>
@@ -37,10 +36,13 @@
 #ifndef	CONFIG_ENV_MIN_ENTRIES	/* minimum number of entries */
 #define	CONFIG_ENV_MIN_ENTRIES 64
 #endif
-#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum number of entries */
+#ifndef	CONFIG_ENV_MAX_ENTRIES	/* maximum initial number of entries */
 #define	CONFIG_ENV_MAX_ENTRIES 512
 #endif
 
+/* The table grows once it is this full (in percent), to keep probing short */
+#define HTAB_MAX_LOAD	75
+
 #define USED_FREE 0
 #define USED_DELETED -1
 
@@ -60,8 +62,16 @@
  * which describes the current status.
  */
 
+/*
+ * Besides the hash table itself, the used entries form a list in ascending key
+ * order, linked by their indexes (index 0 is never used, so ends the list).
+ * This lets hexport() produce sorted output without sorting.
+ */
 struct env_entry_node {
 	int used;
+	unsigned int prev;
+	unsigned int next;
+	int imported;		/* entry was set or confirmed by this import */
 	struct env_entry entry;
 };
 
@@ -119,6 +129,9 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 
 	htab->size = nel;
 	htab->filled = 0;
+	htab->first = 0;
+	htab->last = 0;
+	htab->export_len = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
@@ -165,6 +178,137 @@ void hdestroy_r(struct hsearch_data *htab)
 	htab->table = NULL;
 }
 
+/*
+ * Helpers for the hash functions, the list of entries in key order and the
+ * export length
+ */
+
+/* First hash function: simply take the modul but prevent zero */
+static unsigned int hhash(const char *key, unsigned int size)
+{
+	unsigned int len = strlen(key);
+	unsigned int hval = len;
+	unsigned int count = len;
+
+	/* Compute an value for the given string. Perhaps use a better method. */
+	while (count-- > 0) {
+		hval <<= 4;
+		hval += key[count];
+	}
+
+	hval %= size;
+	if (hval == 0)
+		++hval;
+
+	return hval;
+}
+
+/*
+ * Second hash function: step back by hval2 = 1 + hval % (size - 2), as
+ * suggested in [Knuth]
+ */
+static unsigned int hnext(unsigned int idx, unsigned int hval2,
+			  unsigned int size)
+{
+	/* Because SIZE is prime this guarantees to step through all indices */
+	if (idx <= hval2)
+		return size + idx - hval2;
+
+	return idx - hval2;
+}
+
+/* Bytes taken by an entry in hexport() output with a NUL separator */
+static size_t hexport_len(const struct env_entry *ep)
+{
+	return strlen(ep->key) + strlen(ep->data) + 2;	/* '=' and '\0' */
+}
+
+/* Link a new entry into the list in key order */
+static void hlist_add(struct hsearch_data *htab, unsigned int idx)
+{
+	struct env_entry_node *table = htab->table;
+	const char *key = table[idx].entry.key;
+	unsigned int prev = htab->last;
+
+	/* Imported data is normally sorted, so start looking at the end */
+	while (prev && strcmp(table[prev].entry.key, key) > 0)
+		prev = table[prev].prev;
+
+	table[idx].prev = prev;
+	table[idx].next = prev ? table[prev].next : htab->first;
+	if (table[idx].next)
+		table[table[idx].next].prev = idx;
+	else
+		htab->last = idx;
+	if (prev)
+		table[prev].next = idx;
+	else
+		htab->first = idx;
+}
+
+static void hlist_del(struct hsearch_data *htab, unsigned int idx)
+{
+	struct env_entry_node *node = &htab->table[idx];
+
+	if (node->prev)
+		htab->table[node->prev].next = node->next;
+	else
+		htab->first = node->next;
+	if (node->next)
+		htab->table[node->next].prev = node->prev;
+	else
+		htab->last = node->prev;
+}
+
+/*
+ * hresize()
+ */
+
+/*
+ * Move all entries to a new table with room for "nel" of them. The entries
+ * themselves do not change, so no callbacks are called, but any pointers to
+ * them are no longer valid.
+ */
+static int hresize(struct hsearch_data *htab, unsigned int nel)
+{
+	struct hsearch_data new = *htab;
+	unsigned int i, idx, hval, hval2;
+
+	new.table = NULL;
+	if (hcreate_r(nel, &new) == 0)
+		return 0;
+
+	debug("Resize Hash Table: %p from N=%d to N=%d\n", htab, htab->size,
+	      new.size);
+	for (i = htab->first; i; i = htab->table[i].next) {
+		struct env_entry_node *node = &htab->table[i];
+
+		/* The new table has no deleted entries or duplicate keys */
+		hval = hhash(node->entry.key, new.size);
+		hval2 = 1 + hval % (new.size - 2);
+		for (idx = hval; new.table[idx].used;
+		     idx = hnext(idx, hval2, new.size))
+			;
+
+		new.table[idx] = *node;
+		new.table[idx].used = hval;
+		new.table[idx].prev = new.last;
+		new.table[idx].next = 0;
+		if (new.last)
+			new.table[new.last].next = idx;
+		else
+			new.first = idx;
+		new.last = idx;
+	}
+	new.filled = htab->filled;
+	new.export_len = htab->export_len;
+
+	free(htab->table);
+	*htab = new;
+
+	return 1;
+}
+
 /*
  * hsearch()
  */
@@ -257,6 +401,7 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 				return 0;
 			}
 
+			htab->export_len -= strlen(htab->table[idx].entry.data);
 			free(htab->table[idx].entry.data);
 			htab->table[idx].entry.data = strdup(item.data);
 			if (!htab->table[idx].entry.data) {
@@ -264,6 +409,8 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 				*retval = NULL;
 				return 0;
 			}
+			htab->export_len += strlen(item.data);
+			htab->table[idx].imported = 1;
 		}
 		/* return found entry */
 		*retval = &htab->table[idx].entry;
@@ -273,31 +420,16 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 	return -1;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+static int _hsearch(struct env_entry item, enum env_action action,
+		    struct env_entry **retval, struct hsearch_data *htab,
+		    int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hhash(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -318,21 +450,11 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
+		/* Second hash function */
 		hval2 = 1 + hval % (htab->size - 2);
 
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = hnext(idx, hval2, htab->size);
 
 			/*
 			 * If we visited all entries leave the loop
@@ -384,6 +506,9 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		++htab->filled;
+		hlist_add(htab, idx);
+		htab->export_len += hexport_len(&htab->table[idx].entry);
+		htab->table[idx].imported = 1;
 
 		/* This is a new entry, so look up a possible callback */
 		env_callback_init(&htab->table[idx].entry);
@@ -423,6 +548,26 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	return 0;
 }
 
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	int ret;
+
+	/*
+	 * Grow the table before adding to it, but not while a callback runs
+	 * from inside another call, which still uses the old table.
+	 */
+	if (action == ENV_ENTER && !htab->busy &&
+	    htab->filled * 100 >= htab->size * HTAB_MAX_LOAD)
+		hresize(htab, htab->size * 2);
+
+	htab->busy++;
+	ret = _hsearch(item, action, retval, htab, flag);
+	htab->busy--;
+
+	return ret;
+}
+
 
 /*
  * hdelete()
@@ -439,6 +584,8 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
+	hlist_del(htab, idx);
+	htab->export_len -= hexport_len(ep);
 	free((void *)ep->key);
 	free(ep->data);
 	ep->callback = NULL;
@@ -529,14 +676,6 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
  *		bytes in the string will be '\0'-padded.
  */
 
-static int cmpkey(const void *p1, const void *p2)
-{
-	struct env_entry *e1 = *(struct env_entry **)p1;
-	struct env_entry *e2 = *(struct env_entry **)p2;
-
-	return (strcmp(e1->key, e2->key));
-}
-
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -595,14 +734,27 @@ static int match_entry(struct env_entry *ep, int flag, int argc,
 	return 0;
 }
 
+/* Check whether an entry is to be exported */
+static int hexport_entry(struct env_entry *ep, int flag, int argc,
+			 char *const argv[])
+{
+	if (argc > 0 && !match_entry(ep, flag, argc, argv))
+		return 0;
+
+	if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+		return 0;
+
+	return 1;
+}
+
 ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry *ep;
 	char *res, *p;
 	size_t totlen;
-	int i, n;
+	unsigned int i;
 
 	/* Test for correct arguments.  */
 	if ((resp == NULL) || (htab == NULL)) {
@@ -614,54 +766,35 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	      htab, htab->size, htab->filled, (ulong)size);
 	/*
 	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
+	 * compute total length. This is kept up to date for exporting all
+	 * entries with a NUL separator, as for saving the environment.
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
-
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
+	if (sep == '\0' && argc == 0 && !(flag & H_HIDE_DOT)) {
+		totlen = htab->export_len;
+	} else {
+		for (i = htab->first, totlen = 0; i; i = htab->table[i].next) {
+			const char *s;
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			ep = &htab->table[i].entry;
+			if (!hexport_entry(ep, flag, argc, argv))
 				continue;
 
-			list[n++] = ep;
-
 			totlen += strlen(ep->key);
 
 			if (sep == '\0') {
 				totlen += strlen(ep->data);
 			} else {	/* check if escapes are needed */
-				char *s = ep->data;
-
-				while (*s) {
+				for (s = ep->data; *s; ++s) {
 					++totlen;
 					/* add room for needed escape chars */
 					if ((*s == sep) || (*s == '\\'))
 						++totlen;
-					++s;
 				}
 			}
 			totlen += 2;	/* for '=' and 'sep' char */
 		}
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
@@ -689,17 +822,21 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 	}
 	/*
 	 * Pass 2:
-	 * export sorted list of result data
+	 * export the entries, which are kept sorted by key
 	 */
-	for (i = 0, p = res; i < n; ++i) {
+	for (i = htab->first, p = res; i; i = htab->table[i].next) {
 		const char *s;
 
-		s = list[i]->key;
+		ep = &htab->table[i].entry;
+		if (!hexport_entry(ep, flag, argc, argv))
+			continue;
+
+		s = ep->key;
 		while (*s)
 			*p++ = *s++;
 		*p++ = '=';
 
-		s = list[i]->data;
+		s = ep->data;
 
 		while (*s) {
 			if ((*s == sep) || (*s == '\\'))
@@ -764,6 +901,12 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  * the linear list of "name=value" pairs will be removed from the
  * current hash table.
  *
+ * When replacing the whole table, the H_INCREMENTAL flag keeps the existing
+ * table and only applies the differences: entries with an unchanged value are
+ * left alone, so their callbacks do not run again, and entries which are not
+ * in the imported data are deleted at the end. The imported data wins, as if
+ * the table had been replaced, so H_FORCE is used for those changes.
+ *
  * The separator character for the "name=value" pairs can be selected,
  * so we both support importing from externally stored environment
  * data (separated by NUL characters) and from plain text files
@@ -791,6 +934,8 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	unsigned int idx, next;
+	int incremental;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -813,7 +958,13 @@ int himport_r(struct hsearch_data *htab,
 	if (nvars)
 		memcpy(localvars, vars, sizeof(vars[0]) * nvars);
 
-	if ((flag & H_NOCLEAR) == 0 && !nvars) {
+	incremental = (flag & H_INCREMENTAL) && (flag & H_NOCLEAR) == 0 &&
+		      !nvars && htab->table;
+	if (incremental) {
+		/* Entries which are not imported again are deleted at the end */
+		for (idx = htab->first; idx; idx = htab->table[idx].next)
+			htab->table[idx].imported = 0;
+	} else if ((flag & H_NOCLEAR) == 0 && !nvars) {
 		/* Destroy old hash table if one exists */
 		debug("Destroy Hash Table: %p table = %p\n", htab,
 		       htab->table);
@@ -836,7 +987,8 @@ int himport_r(struct hsearch_data *htab,
 	 * environment size), so we clip it to a reasonable value.
 	 * On the other hand we need to add some more entries for free
 	 * space when importing very small buffers. Both boundaries can
-	 * be overwritten in the board config file if needed.
+	 * be overwritten in the board config file if needed. Either way
+	 * the table grows when it fills up.
 	 */
 
 	if (!htab->table) {
@@ -932,7 +1084,16 @@ int himport_r(struct hsearch_data *htab,
 		e.key = name;
 		e.data = value;
 
-		hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		if (incremental) {
+			idx = hsearch_r(e, ENV_FIND, &rv, htab, flag);
+			if (idx && !strcmp(rv->data, value)) {
+				htab->table[idx].imported = 1;
+				continue;
+			}
+			hsearch_r(e, ENV_ENTER, &rv, htab, flag | H_FORCE);
+		} else {
+			hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		}
 		if (rv == NULL)
 			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
 				name, value);
@@ -945,6 +1106,22 @@ int himport_r(struct hsearch_data *htab,
 	debug("INSERT: free(data = %p)\n", data);
 	free(data);
 
+	if (incremental) {
+		/* A callback must not resize the table under this loop */
+		htab->busy++;
+		for (idx = htab->first; idx; idx = next) {
+			next = htab->table[idx].next;
+			if (htab->table[idx].imported)
+				continue;
+			hdelete_r(htab->table[idx].entry.key, htab,
+				  flag | H_FORCE);
+			/* Start again if a callback deleted the next one too */
+			if (next && htab->table[next].used <= 0)
+				next = htab->first;
+		}
+		htab->busy--;
+	}
+
 	if (flag & H_NOCLEAR)
 		goto end;
 
@@ -982,15 +1159,18 @@ end:
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
 	int i;
-	int retval;
+	int retval = 0;
 
+	/* The callback must not resize the table under this loop */
+	htab->busy++;
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
-				return retval;
+				break;
 		}
 	}
+	htab->busy--;
 
-	return 0;
+	return retval;
 }
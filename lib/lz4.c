@@ -96,6 +96,10 @@ FORCE_INLINE int LZ4_decompress_generic(
     const int safeDecode = (endOnInput==endOnInputSize);
     const int checkOffset = ((safeDecode) && (dictSize < (int)(64 KB)));
 
+    /* Set up the "fast decode" loop, see below */
+    const BYTE* const shortiend = iend - (endOnInput ? 14 : 8) /*maxLL*/ - 2 /*offset*/;
+    BYTE* const shortoend = oend - (endOnInput ? 14 : 8) /*maxLL*/ - 18 /*maxML*/;
+
 
     /* Special cases */
     if ((partialDecoding) && (oexit> oend-MFLIMIT)) oexit = oend-MFLIMIT;                         /* targetOutputSize too high => decode everything */
@@ -112,7 +116,50 @@ FORCE_INLINE int LZ4_decompress_generic(
 
         /* get literal length */
         token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)
+        length = token >> ML_BITS;
+
+        /* A two-stage shortcut for the most common case (backported from LZ4 v1.8.2):
+         * 1) If the literal length is 0..14, and there is enough space,
+         * enter the shortcut and copy 16 bytes on behalf of the literals
+         * (in the fast mode, only 8 bytes can be safely copied this way).
+         * 2) Further if the match length is 4..18, copy 18 bytes in a similar
+         * manner; but we ensure that there's enough space in the output for
+         * those 18 bytes earlier, upon entering the shortcut (in other words,
+         * there is a combined check for both stages).
+         */
+        if ( LZ4_FAST_DECODE && !partialDecoding
+           && ((endOnInput) ? length != RUN_MASK : length <= 8)
+           && likely(((endOnInput) ? ip < shortiend : 1) & (op <= shortoend)) )
+        {
+            /* Copy the literals. */
+            LZ4_copy8(op, ip);
+            if (endOnInput) LZ4_copy8(op+8, ip+8);
+            op += length; ip += length;
+
+            /* The second stage: prepare for match copying, decode full info.
+             * If it doesn't work out, the info won't be wasted. */
+            length = token & ML_MASK; /* match length */
+            match = op - LZ4_readLE16(ip); ip += 2;
+
+            /* Do not deal with overlapping matches. */
+            if ( (length != ML_MASK) && ((size_t)(op-match) >= 8)
+              && (dict==withPrefix64k || match >= lowPrefix) )
+            {
+                /* Copy the match. */
+                LZ4_copy8(op + 0, match + 0);
+                LZ4_copy8(op + 8, match + 8);
+                LZ4_copy2(op +16, match +16);
+                op += length + MINMATCH;
+                /* Both stages worked, load the next token. */
+                continue;
+            }
+
+            /* The second stage didn't work out, but the info is ready.
+             * Propel it right to the point of match copying. */
+            goto _copy_match;
+        }
+
+        if (length == RUN_MASK)
         {
             unsigned s;
             do
@@ -150,10 +197,12 @@ FORCE_INLINE int LZ4_decompress_generic(
 
         /* get offset */
         match = cpy - LZ4_readLE16(ip); ip+=2;
-        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
 
         /* get matchlength */
         length = token & ML_MASK;
+
+_copy_match:
+        if ((checkOffset) && (unlikely(match < lowLimit))) goto _output_error;   /* Error : offset outside destination buffer */
         if (length == ML_MASK)
         {
             unsigned s;
@@ -5,12 +5,16 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <decomp_stream.h>
 #include <image.h>
 #include <lz4.h>
+#include <malloc.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
+#include <asm/unaligned.h>
 
 static u16 LZ4_readLE16(const void *src) { return le16_to_cpu(*(u16 *)src); }
+static void LZ4_copy2(void *dst, const void *src) { *(u16 *)dst = *(u16 *)src; }
 static void LZ4_copy4(void *dst, const void *src) { *(u32 *)dst = *(u32 *)src; }
 static void LZ4_copy8(void *dst, const void *src) { *(u64 *)dst = *(u64 *)src; }
 
@@ -22,7 +26,17 @@ typedef uint64_t U64;
 
 #define FORCE_INLINE static inline __attribute__((always_inline))
 
-/* Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
+/*
+ * The fast decode shortcut copies whole words of literals and matches without
+ * looking at their exact length, which only pays off where unaligned accesses
+ * are cheap.
+ */
+#define LZ4_FAST_DECODE CONFIG_IS_ENABLED(HAVE_EFFICIENT_UNALIGNED_ACCESS)
+
+/*
+ * Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4,
+ * apart from the fast decode shortcut backported from LZ4 v1.8.2.
+ */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
 struct lz4_frame_header {
@@ -136,3 +150,196 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+int ulz4fn_frame_size(const void *src, size_t srcn, size_t *framen,
+		      u64 *contentn)
+{
+	const struct lz4_frame_header *h = src;
+	const void *in = src;
+	struct lz4_block_header b;
+
+	if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		return -EINVAL;
+	if (le32_to_cpu(get_unaligned(&h->magic)) != LZ4F_MAGIC ||
+	    h->version != 1 || !h->independent_blocks)
+		return -EPROTONOSUPPORT;
+	if (h->reserved0 || h->reserved1 || h->reserved2)
+		return -EINVAL;
+	if (!h->has_content_size)
+		return -ENODATA;
+	*contentn = le64_to_cpu(get_unaligned((u64 *)(in + sizeof(*h))));
+	in += sizeof(*h) + sizeof(u64) + sizeof(u8);
+
+	do {
+		if (in - src + sizeof(b) > srcn)
+			return -EINVAL;
+		b.raw = le32_to_cpu(get_unaligned((u32 *)in));
+		in += sizeof(b);
+		if (b.size) {
+			in += b.size;
+			if (h->has_block_checksum)
+				in += sizeof(u32);
+		}
+	} while (b.size);
+	if (h->has_content_checksum)
+		in += sizeof(u32);
+	if (in - src > srcn)
+		return -EINVAL;
+	*framen = in - src;
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+enum lz4_stream_state {
+	LZ4S_FRAME_HEADER,	/* magic, flags and block descriptor */
+	LZ4S_FRAME_HEADER_END,	/* content size and header checksum */
+	LZ4S_BLOCK_HEADER,
+	LZ4S_BLOCK,		/* block data and its checksum */
+	LZ4S_CONTENT_CHECKSUM,
+	LZ4S_END,
+};
+
+/*
+ * Blocks are independent, so each is gathered and decompressed on its own,
+ * straight to the output buffer.
+ */
+struct lz4_stream {
+	enum lz4_stream_state state;
+	int has_block_checksum;
+	int has_content_checksum;
+	size_t block_max;
+	struct lz4_block_header b;
+	size_t want;		/* bytes needed for the next step */
+	size_t have;		/* bytes of those gathered so far */
+	u8 hdr[sizeof(u64) + sizeof(u8)];	/* fits each of the headers */
+	void *block;
+};
+
+int lz4_stream_start(struct decomp_stream *ds)
+{
+	struct lz4_stream *st;
+
+	st = calloc(1, sizeof(*st));
+	if (!st)
+		return -ENOMEM;
+	st->state = LZ4S_FRAME_HEADER;
+	st->want = sizeof(struct lz4_frame_header);
+	ds->priv = st;
+
+	return 0;
+}
+
+static int lz4_stream_step(struct decomp_stream *ds, struct lz4_stream *st)
+{
+	const struct lz4_frame_header *h = (void *)st->hdr;
+	void *out = ds->dst + ds->pos;
+	size_t space = ds->dst_size - ds->pos;
+	int ret;
+
+	switch (st->state) {
+	case LZ4S_FRAME_HEADER:
+		if (le32_to_cpu(get_unaligned(&h->magic)) != LZ4F_MAGIC ||
+		    h->version != 1)
+			return -EPROTONOSUPPORT;	/* unknown format */
+		if (h->reserved0 || h->reserved1 || h->reserved2 ||
+		    h->max_block_size < 4)
+			return -EINVAL;
+		if (!h->independent_blocks)
+			return -EPROTONOSUPPORT;
+		st->has_block_checksum = h->has_block_checksum;
+		st->has_content_checksum = h->has_content_checksum;
+		st->block_max = 1 << (8 + 2 * h->max_block_size);
+		st->block = malloc(st->block_max + sizeof(u32));
+		if (!st->block)
+			return -ENOMEM;
+		st->want = (h->has_content_size ? sizeof(u64) : 0) + sizeof(u8);
+		st->state = LZ4S_FRAME_HEADER_END;
+		break;
+	case LZ4S_FRAME_HEADER_END:
+		st->want = sizeof(struct lz4_block_header);
+		st->state = LZ4S_BLOCK_HEADER;
+		break;
+	case LZ4S_BLOCK_HEADER:
+		st->b.raw = le32_to_cpu(get_unaligned((u32 *)st->hdr));
+		if (!st->b.size) {
+			if (st->has_content_checksum) {
+				st->want = sizeof(u32);
+				st->state = LZ4S_CONTENT_CHECKSUM;
+				break;
+			}
+			ds->done = true;
+			st->state = LZ4S_END;
+			break;
+		}
+		if (st->b.size > st->block_max)
+			return -EINVAL;
+		st->want = st->b.size;
+		if (st->has_block_checksum)
+			st->want += sizeof(u32);
+		st->state = LZ4S_BLOCK;
+		break;
+	case LZ4S_BLOCK:
+		if (st->b.not_compressed) {
+			if (st->b.size > space)
+				return -ENOSPC;
+			memcpy(out, st->block, st->b.size);
+			ds->pos += st->b.size;
+		} else {
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(st->block, out, st->b.size,
+					space, endOnInputSize,
+					full, 0, noDict, out, NULL, 0);
+			if (ret < 0)
+				return -EINVAL;
+			ds->pos += ret;
+		}
+		st->want = sizeof(struct lz4_block_header);
+		st->state = LZ4S_BLOCK_HEADER;
+		break;
+	case LZ4S_CONTENT_CHECKSUM:
+		/* not checked, as by ulz4fn(), but the frame ends after it */
+		ds->done = true;
+		st->state = LZ4S_END;
+		break;
+	case LZ4S_END:
+		break;
+	}
+
+	return 0;
+}
+
+int lz4_stream_write(struct decomp_stream *ds, const void *buf, size_t len)
+{
+	struct lz4_stream *st = ds->priv;
+	size_t count;
+	u8 *dest;
+	int ret;
+
+	while (len && st->state != LZ4S_END) {
+		dest = st->state == LZ4S_BLOCK ? st->block : st->hdr;
+		count = min(st->want - st->have, len);
+		memcpy(dest + st->have, buf, count);
+		st->have += count;
+		buf += count;
+		len -= count;
+		if (st->have < st->want)
+			break;
+
+		st->have = 0;
+		ret = lz4_stream_step(ds, st);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+void lz4_stream_end(struct decomp_stream *ds)
+{
+	struct lz4_stream *st = ds->priv;
+
+	free(st->block);
+	free(st);
+}
+#endif /* DECOMP_STREAM */
@@ -30,6 +30,7 @@
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
+#include <decomp_stream.h>
 #include <linux/string.h>
 #include <malloc.h>
 
@@ -120,4 +121,108 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+/*
+ * The output buffer serves as the dictionary, so the decoder needs no other
+ * memory than its probability tables.
+ */
+struct lzma_stream {
+    CLzmaDec dec;
+    ISzAlloc alloc;
+    unsigned char header[LZMA_DATA_OFFSET];
+    unsigned int have;          /* bytes of the header seen so far */
+    SizeT limit;                /* bytes to decompress */
+};
+
+static int lzma_stream_header(struct decomp_stream *ds, struct lzma_stream *st)
+{
+    uint64_t size = 0;
+    int i;
+
+    for (i = 7; i >= 0; i--)
+        size = size << 8 | st->header[LZMA_SIZE_OFFSET + i];
+
+    /* All ones means that the size is not known */
+    if (size == (uint64_t)-1)
+        st->limit = ds->dst_size;
+    else if (size > ds->dst_size)
+        return -ENOSPC;
+    else
+        st->limit = size;
+
+    if (LzmaDec_AllocateProbs(&st->dec, st->header, LZMA_PROPS_SIZE,
+                              &st->alloc) != SZ_OK)
+        return -EINVAL;
+    st->dec.dic = ds->dst;
+    st->dec.dicBufSize = st->limit;
+    LzmaDec_Init(&st->dec);
+
+    return 0;
+}
+
+int lzma_stream_start(struct decomp_stream *ds)
+{
+    struct lzma_stream *st;
+
+    st = calloc(1, sizeof(*st));
+    if (!st)
+        return -ENOMEM;
+    LzmaDec_Construct(&st->dec);
+    st->alloc.Alloc = SzAlloc;
+    st->alloc.Free = SzFree;
+    ds->priv = st;
+
+    return 0;
+}
+
+int lzma_stream_write(struct decomp_stream *ds, const void *buf, size_t len)
+{
+    struct lzma_stream *st = ds->priv;
+    ELzmaStatus status;
+    SizeT in_len;
+    size_t count;
+    int ret;
+    SRes res;
+
+    if (ds->done)
+        return 0;
+
+    if (st->have < sizeof(st->header)) {
+        count = min(sizeof(st->header) - st->have, len);
+        memcpy(st->header + st->have, buf, count);
+        st->have += count;
+        buf += count;
+        len -= count;
+        if (st->have < sizeof(st->header))
+            return 0;
+        ret = lzma_stream_header(ds, st);
+        if (ret)
+            return ret;
+    }
+
+    WATCHDOG_RESET();
+
+    /* The end of the buffer is the end of the data, so use LZMA_FINISH_END */
+    in_len = len;
+    res = LzmaDec_DecodeToDic(&st->dec, st->limit, buf, &in_len,
+                              LZMA_FINISH_END, &status);
+    ds->pos = st->dec.dicPos;
+    if (res != SZ_OK)
+        return ds->pos == ds->dst_size ? -ENOSPC : -EINVAL;
+    if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+        status == LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK)
+        ds->done = true;
+
+    return 0;
+}
+
+void lzma_stream_end(struct decomp_stream *ds)
+{
+    struct lzma_stream *st = ds->priv;
+
+    LzmaDec_FreeProbs(&st->dec, &st->alloc);
+    free(st);
+}
+#endif /* DECOMP_STREAM */
+
 #endif
@@ -21,8 +21,29 @@
 #define HAVE_OP(x, op_end, op) ((size_t)(op_end - op) < (x))
 #define HAVE_LB(m_pos, out, op) (m_pos < out || m_pos >= op)
 
+/*
+ * Where unaligned accesses are cheap, literal runs and matches at least 8
+ * bytes back are copied 16 bytes at a time. This may write up to 15 bytes
+ * past the end of the run, so is only done when that stays inside the output
+ * buffer; later runs overwrite those bytes with the right data.
+ */
+#if CONFIG_IS_ENABLED(HAVE_EFFICIENT_UNALIGNED_ACCESS)
+#define LZO_FAST_COPY	1
+#define COPY4(dst, src)	(*(u32 *)(dst) = *(const u32 *)(src))
+#define COPY8(dst, src)	(*(u64 *)(dst) = *(const u64 *)(src))
+#else
+#define LZO_FAST_COPY	0
 #define COPY4(dst, src)	\
 		put_unaligned(get_unaligned((const u32 *)(src)), (u32 *)(dst))
+#define COPY8(dst, src)	\
+		put_unaligned(get_unaligned((const u64 *)(src)), (u64 *)(dst))
+#endif
+
+#define COPY16(dst, src)	\
+	do { \
+		COPY8(dst, src); \
+		COPY8((dst) + 8, (src) + 8); \
+	} while (0)
 
 static const unsigned char lzop_magic[] = {
 	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
@@ -183,6 +204,21 @@ int lzo1x_decompress_safe(const unsigned char *in, size_t in_len,
 		if (HAVE_IP(t + 4, ip_end, ip))
 			goto input_overrun;
 
+		if (LZO_FAST_COPY && !HAVE_OP(t + 3 + 15, op_end, op) &&
+		    !HAVE_IP(t + 3 + 15, ip_end, ip)) {
+			const unsigned char *ie = ip + t + 3;
+			unsigned char *oe = op + t + 3;
+
+			do {
+				COPY16(op, ip);
+				op += 16;
+				ip += 16;
+			} while (ip < ie);
+			ip = ie;
+			op = oe;
+			goto first_literal_run;
+		}
+
 		COPY4(op, ip);
 		op += 4;
 		ip += 4;
@@ -294,6 +330,19 @@ match:
 			if (HAVE_OP(t + 3 - 1, op_end, op))
 				goto output_overrun;
 
+			if (LZO_FAST_COPY && (op - m_pos) >= 8 &&
+			    !HAVE_OP(t + 3 - 1 + 15, op_end, op)) {
+				unsigned char *oe = op + t + 3 - 1;
+
+				do {
+					COPY16(op, m_pos);
+					op += 16;
+					m_pos += 16;
+				} while (op < oe);
+				op = oe;
+				goto match_done;
+			}
+
 			if (t >= 2 * 4 - (3 - 1) && (op - m_pos) >= 4) {
 				COPY4(op, m_pos);
 				op += 4;
@@ -327,6 +376,15 @@ match_next:
 			if (HAVE_IP(t + 1, ip_end, ip))
 				goto input_overrun;
 
+			if (LZO_FAST_COPY && !HAVE_OP(4, op_end, op) &&
+			    !HAVE_IP(4, ip_end, ip)) {
+				COPY4(op, ip);
+				op += t;
+				ip += t;
+				t = *ip++;
+				continue;
+			}
+
 			*op++ = *ip++;
 			if (t > 1) {
 				*op++ = *ip++;
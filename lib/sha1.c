@@ -65,7 +65,7 @@ void sha1_starts (sha1_context * ctx)
 	ctx->state[4] = 0xC3D2E1F0;
 }
 
-static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+static void sha1_process_one(sha1_context *ctx, const unsigned char data[64])
 {
 	unsigned long temp, W[16], A, B, C, D, E;
 
@@ -222,9 +222,29 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 /*
  * SHA-1 process buffer
  */
+void sha1_process_generic(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks)
+{
+	while (blocks--) {
+		sha1_process_one(ctx, data);
+		data += 64;
+	}
+}
+
+/*
+ * Architectures with SHA-1 instructions override this, and fall back to
+ * sha1_process_generic() if the CPU does not implement them.
+ */
+__weak void sha1_process(sha1_context *ctx, const unsigned char *data,
+			 unsigned int blocks)
+{
+	sha1_process_generic(ctx, data, blocks);
+}
+
 void sha1_update(sha1_context *ctx, const unsigned char *input,
 		 unsigned int ilen)
 {
+	unsigned int blocks;
 	int fill;
 	unsigned long left;
 
@@ -242,16 +262,17 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_process(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	blocks = ilen / 64;
+	if (blocks) {
+		sha1_process(ctx, input, blocks);
+		input += blocks * 64;
+		ilen -= blocks * 64;
 	}
 
 	if (ilen > 0) {
@@ -481,6 +481,23 @@ char *strswab(const char *s)
 }
 #endif
 
+/*
+ * memset(), memcpy() and memmove() below work a word at a time once the
+ * destination is aligned, shifting unaligned source words into place.
+ */
+#define WSIZE		sizeof(unsigned long)
+#define WMASK		(WSIZE - 1)
+
+/*
+ * Join the bytes at offset @shift / 8 of @lo onwards with the first ones of
+ * @hi, where @lo and @hi are consecutive aligned words
+ */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MERGE(lo, hi, shift)	((lo) >> (shift) | (hi) << (8 * WSIZE - (shift)))
+#else
+#define MERGE(lo, hi, shift)	((lo) << (shift) | (hi) >> (8 * WSIZE - (shift)))
+#endif
+
 #ifndef __HAVE_ARCH_MEMSET
 /**
  * memset - Fill a region of memory with the given value
@@ -492,26 +509,32 @@ char *strswab(const char *s)
  */
 void * memset(void * s,int c,size_t count)
 {
-	unsigned long *sl = (unsigned long *) s;
-	char *s8;
+	char *s8 = s;
 
 #if !CONFIG_IS_ENABLED(TINY_MEMSET)
-	unsigned long cl = 0;
+	unsigned long *sl, cl = 0;
 	int i;
 
-	/* do it one word at a time (32 bits or 64 bits) while possible */
-	if ( ((ulong)s & (sizeof(*sl) - 1)) == 0) {
-		for (i = 0; i < sizeof(*sl); i++) {
+	/* do it one word at a time (32 bits or 64 bits) once aligned */
+	if (count >= 2 * WSIZE) {
+		for (i = 0; i < WSIZE; i++) {
 			cl <<= 8;
 			cl |= c & 0xff;
 		}
-		while (count >= sizeof(*sl)) {
-			*sl++ = cl;
-			count -= sizeof(*sl);
+		for (; (ulong)s8 & WMASK; count--)
+			*s8++ = c;
+		sl = (unsigned long *)s8;
+		for (; count >= 4 * WSIZE; count -= 4 * WSIZE, sl += 4) {
+			sl[0] = cl;
+			sl[1] = cl;
+			sl[2] = cl;
+			sl[3] = cl;
 		}
+		for (; count >= WSIZE; count -= WSIZE)
+			*sl++ = cl;
+		s8 = (char *)sl;
 	}
 #endif	/* fill 8 bits at a time */
-	s8 = (char *)sl;
 	while (count--)
 		*s8++ = c;
 
@@ -531,22 +554,53 @@ void * memset(void * s,int c,size_t count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
+	unsigned long *dl, *sl, lo, hi;
+	const char *s8 = src;
+	char *d8 = dest;
+	uint shift;
 
 	if (src == dest)
 		return dest;
 
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
+	if (count >= 2 * WSIZE) {
+		for (; (ulong)d8 & WMASK; count--)
+			*d8++ = *s8++;
+		dl = (unsigned long *)d8;
+
+		if (!((ulong)s8 & WMASK)) {
+			/* both aligned (common case): copy words */
+			sl = (unsigned long *)s8;
+			for (; count >= 4 * WSIZE; count -= 4 * WSIZE) {
+				dl[0] = sl[0];
+				dl[1] = sl[1];
+				dl[2] = sl[2];
+				dl[3] = sl[3];
+				dl += 4;
+				sl += 4;
+			}
+			for (; count >= WSIZE; count -= WSIZE)
+				*dl++ = *sl++;
+		} else {
+			/*
+			 * Read aligned words and shift them into place, so
+			 * that even CPUs which cannot load unaligned words
+			 * copy a word at a time. The loads stay within the
+			 * words holding the source bytes.
+			 */
+			shift = 8 * ((ulong)s8 & WMASK);
+			sl = (unsigned long *)((ulong)s8 & ~WMASK);
+			lo = *sl++;
+			for (; count >= WSIZE; count -= WSIZE) {
+				hi = *sl++;
+				*dl++ = MERGE(lo, hi, shift);
+				lo = hi;
+			}
 		}
+		s8 += (char *)dl - d8;
+		d8 = (char *)dl;
 	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
+
+	/* copy the rest one byte at a time */
 	while (count--)
 		*d8++ = *s8++;
 
@@ -565,16 +619,42 @@ void * memcpy(void *dest, const void *src, size_t count)
  */
 void * memmove(void * dest,const void *src,size_t count)
 {
-	char *tmp, *s;
-
-	if (dest <= src) {
-		memcpy(dest, src, count);
-	} else {
-		tmp = (char *) dest + count;
-		s = (char *) src + count;
-		while (count--)
-			*--tmp = *--s;
+	unsigned long *dl, *sl, lo, hi;
+	const char *s8;
+	char *d8;
+	uint shift;
+
+	/* memcpy() only ever reads ahead of where it writes */
+	if (dest <= src || (char *)dest >= (char *)src + count)
+		return memcpy(dest, src, count);
+
+	/* copy downwards from the end, as memcpy() does upwards */
+	d8 = (char *)dest + count;
+	s8 = (const char *)src + count;
+	if (count >= 2 * WSIZE) {
+		for (; (ulong)d8 & WMASK; count--)
+			*--d8 = *--s8;
+		dl = (unsigned long *)d8;
+
+		if (!((ulong)s8 & WMASK)) {
+			sl = (unsigned long *)s8;
+			for (; count >= WSIZE; count -= WSIZE)
+				*--dl = *--sl;
+		} else {
+			shift = 8 * ((ulong)s8 & WMASK);
+			sl = (unsigned long *)((ulong)s8 & ~WMASK);
+			hi = *sl;
+			for (; count >= WSIZE; count -= WSIZE) {
+				lo = *--sl;
+				*--dl = MERGE(lo, hi, shift);
+				hi = lo;
+			}
 		}
+		s8 -= d8 - (char *)dl;
+		d8 = (char *)dl;
+	}
+	while (count--)
+		*--d8 = *--s8;
 
 	return dest;
 }
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Zstandard decompression for images
+ *
+ * The whole output is in memory, so the frames are decompressed straight
+ * into it, with no window buffer; the context only needs the entropy
+ * tables.
+ */
+
+#include <common.h>
+#include <decomp_stream.h>
+#include <malloc.h>
+#include <zstd.h>
+#include <linux/zstd.h>
+#include "zstd_internal.h"
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	ZSTD_DCtx *dctx;
+	void *workspace;
+	size_t wsize, ret;
+
+	wsize = ZSTD_DCtxWorkspaceBound();
+	workspace = malloc(wsize);
+	if (!workspace) {
+		debug("%s: cannot allocate workspace of size %zu\n", __func__,
+		      wsize);
+		return -ENOMEM;
+	}
+
+	dctx = ZSTD_initDCtx(workspace, wsize);
+	if (!dctx) {
+		free(workspace);
+		return -ENOMEM;
+	}
+
+	ret = ZSTD_decompressDCtx(dctx, dst, *dstn, src, srcn);
+	free(workspace);
+	if (!ZSTD_isError(ret)) {
+		*dstn = ret;
+		return 0;
+	}
+
+	debug("%s: error %d\n", __func__, ZSTD_getErrorCode(ret));
+	if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+		return -ENOSPC;
+
+	*dstn = 0;
+	switch (ZSTD_getErrorCode(ret)) {
+	case ZSTD_error_prefix_unknown:
+	case ZSTD_error_version_unsupported:
+	case ZSTD_error_frameParameter_unsupported:
+		return -EPROTONOSUPPORT;
+	default:
+		return -EINVAL;
+	}
+}
+
+#if CONFIG_IS_ENABLED(DECOMP_STREAM)
+/*
+ * This uses the buffer-less streaming interface: each step of a frame is
+ * gathered whole, if it is not already in one piece in the input, and
+ * blocks are decompressed straight to the output buffer, where they can refer
+ * back to the earlier blocks. So the only buffer needed is for one block,
+ * which is no larger than the window of the frame, and is only allocated
+ * once a block turns out to be split in the input.
+ */
+struct zstd_stream {
+	ZSTD_DCtx *dctx;
+	void *workspace;
+	size_t have;		/* bytes gathered for the next step */
+	bool in_hdr;		/* the frame header is not complete yet */
+	size_t hdr_len;		/* bytes of the frame header in hdr */
+	size_t max_block;	/* largest block of the current frame */
+	u8 *buf;		/* gathers blocks, NULL until needed */
+	size_t buf_size;
+	/* frame header, then gathers steps too small to need buf */
+	u8 hdr[ZSTD_FRAMEHEADERSIZE_MAX];
+};
+
+static void zstd_stream_begin(struct zstd_stream *st)
+{
+	ZSTD_decompressBegin(st->dctx);
+	st->in_hdr = true;
+	st->hdr_len = 0;
+}
+
+int zstd_stream_start(struct decomp_stream *ds)
+{
+	struct zstd_stream *st;
+	size_t wsize;
+
+	st = calloc(1, sizeof(*st));
+	if (!st)
+		return -ENOMEM;
+	wsize = ZSTD_DCtxWorkspaceBound();
+	st->workspace = malloc(wsize);
+	if (!st->workspace) {
+		free(st);
+		return -ENOMEM;
+	}
+	st->dctx = ZSTD_initDCtx(st->workspace, wsize);
+	if (!st->dctx) {
+		free(st->workspace);
+		free(st);
+		return -ENOMEM;
+	}
+	zstd_stream_begin(st);
+	ds->priv = st;
+
+	return 0;
+}
+
+static int zstd_stream_step(struct decomp_stream *ds, struct zstd_stream *st,
+			    const void *src, size_t len)
+{
+	size_t ret;
+
+	ret = ZSTD_decompressContinue(st->dctx, ds->dst + ds->pos,
+				      ds->dst_size - ds->pos, src, len);
+	if (ZSTD_isError(ret)) {
+		debug("%s: error %d\n", __func__, ZSTD_getErrorCode(ret));
+		if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+			return -ENOSPC;
+		return -EINVAL;
+	}
+	ds->pos += ret;
+	if (!ZSTD_nextSrcSizeToDecompress(st->dctx))
+		ds->done = true;
+
+	return 0;
+}
+
+/* Once the frame header is complete, note how large its blocks can be */
+static int zstd_stream_header(struct zstd_stream *st)
+{
+	ZSTD_frameParams params;
+	size_t ret;
+
+	ret = ZSTD_getFrameParams(&params, st->hdr, st->hdr_len);
+	if (ZSTD_isError(ret))
+		return -EINVAL;
+	if (ret)
+		return 0;	/* more of the header follows */
+
+	st->in_hdr = false;
+	st->max_block = min_t(size_t, params.windowSize,
+			      ZSTD_BLOCKSIZE_ABSOLUTEMAX);
+
+	return 0;
+}
+
+/* Find room to gather a step of @want bytes which is split in the input */
+static u8 *zstd_stream_gather_buf(struct zstd_stream *st, size_t want)
+{
+	if (st->in_hdr)
+		return st->hdr_len + want <= sizeof(st->hdr) ?
+			st->hdr + st->hdr_len : NULL;
+	if (want <= sizeof(st->hdr))
+		return st->hdr;
+	if (want > st->max_block)
+		return NULL;
+	if (st->buf_size < st->max_block) {
+		free(st->buf);
+		st->buf_size = 0;
+		st->buf = malloc(st->max_block);
+		if (!st->buf)
+			return NULL;
+		st->buf_size = st->max_block;
+	}
+
+	return st->buf;
+}
+
+int zstd_stream_write(struct decomp_stream *ds, const void *buf, size_t len)
+{
+	struct zstd_stream *st = ds->priv;
+	size_t want, count;
+	u8 *gather;
+	int ret;
+
+	while (len) {
+		want = ZSTD_nextSrcSizeToDecompress(st->dctx);
+		if (!want) {
+			/* another frame follows */
+			zstd_stream_begin(st);
+			ds->done = false;
+			continue;
+		}
+
+		if (ZSTD_isSkipFrame(st->dctx)) {
+			/* the content of a skippable frame is never looked at */
+			count = min(want - st->have, len);
+			st->have += count;
+			buf += count;
+			len -= count;
+			if (st->have < want)
+				break;
+			st->have = 0;
+			ret = zstd_stream_step(ds, st, st->hdr, want);
+		} else if (!st->have && len >= want && !st->in_hdr) {
+			ret = zstd_stream_step(ds, st, buf, want);
+			buf += want;
+			len -= want;
+		} else {
+			/* the frame header is always gathered, to parse it */
+			gather = zstd_stream_gather_buf(st, want);
+			if (!gather)
+				return st->in_hdr || want > st->max_block ?
+					-EINVAL : -ENOMEM;
+			count = min(want - st->have, len);
+			memcpy(gather + st->have, buf, count);
+			st->have += count;
+			buf += count;
+			len -= count;
+			if (st->have < want)
+				break;
+			st->have = 0;
+			ret = zstd_stream_step(ds, st, gather, want);
+			if (!ret && st->in_hdr) {
+				st->hdr_len += want;
+				ret = zstd_stream_header(st);
+			}
+		}
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+void zstd_stream_end(struct decomp_stream *ds)
+{
+	struct zstd_stream *st = ds->priv;
+
+	free(st->buf);
+	free(st->workspace);
+	free(st);
+}
+#endif /* DECOMP_STREAM */
@@ -20,9 +20,11 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @rx_stats: Receive statistics, see eth_get_rx_stats()
  */
 struct eth_device_priv {
 	enum eth_state_t state;
+	struct eth_rx_stats rx_stats;
 };
 
 /**
@@ -352,14 +354,79 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
-int eth_rx(void)
+/* Maximum number of packets processed in one call to eth_rx() */
+#define ETH_RX_BUDGET	32
+
+/* Receive packets one by one with the driver's recv() method */
+static int eth_rx_single(struct udevice *current, int *done)
 {
-	struct udevice *current;
+	struct eth_ops *ops = eth_get_ops(current);
 	uchar *packet;
 	int flags;
 	int ret;
+
+	flags = ETH_RECV_CHECK_DEVICE;
+	for (*done = 0; *done < ETH_RX_BUDGET; ) {
+		ret = ops->recv(current, flags, &packet);
+		flags = 0;
+		if (ret > 0) {
+			net_process_received_packet(packet, ret);
+			(*done)++;
+		}
+		if (ret >= 0 && ops->free_pkt)
+			ops->free_pkt(current, packet, ret);
+		if (ret <= 0)
+			break;
+	}
+
+	return ret;
+}
+
+/* Receive packets a batch at a time with the driver's recv_batch() method */
+static int eth_rx_batch(struct udevice *current, int *done)
+{
+	struct eth_ops *ops = eth_get_ops(current);
+	uchar *packets[ETH_RX_BUDGET];
+	int lengths[ETH_RX_BUDGET];
+	uint pkt_flags[ETH_RX_BUDGET];
+	int flags;
+	int count;
+	int ret;
 	int i;
 
+	flags = ETH_RECV_CHECK_DEVICE;
+	for (*done = 0; *done < ETH_RX_BUDGET; ) {
+		count = ETH_RX_BUDGET - *done;
+		memset(pkt_flags, '\0', count * sizeof(pkt_flags[0]));
+		ret = ops->recv_batch(current, flags, packets, lengths,
+				      pkt_flags, count);
+		flags = 0;
+		if (ret <= 0)
+			break;
+		for (i = 0; i < ret; i++) {
+			net_rx_csum_valid = pkt_flags[i] & ETH_PKT_CSUM_VALID;
+			net_process_received_packet(packets[i], lengths[i]);
+		}
+		net_rx_csum_valid = false;
+		if (ops->free_pkt) {
+			for (i = 0; i < ret; i++)
+				ops->free_pkt(current, packets[i], lengths[i]);
+		}
+		*done += ret;
+		if (ret < count)
+			return 0;
+	}
+
+	return ret;
+}
+
+int eth_rx(void)
+{
+	struct udevice *current;
+	struct eth_device_priv *priv;
+	int done;
+	int ret;
+
 	current = eth_get_dev();
 	if (!current)
 		return -ENODEV;
@@ -367,18 +434,21 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
-	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
-		ret = eth_get_ops(current)->recv(current, flags, &packet);
-		flags = 0;
-		if (ret > 0)
-			net_process_received_packet(packet, ret);
-		if (ret >= 0 && eth_get_ops(current)->free_pkt)
-			eth_get_ops(current)->free_pkt(current, packet, ret);
-		if (ret <= 0)
-			break;
+	if (eth_get_ops(current)->recv_batch)
+		ret = eth_rx_batch(current, &done);
+	else
+		ret = eth_rx_single(current, &done);
+
+	priv = dev_get_uclass_priv(current);
+	if (done) {
+		priv->rx_stats.polls++;
+		priv->rx_stats.packets += done;
+		priv->rx_stats.max_batch = max_t(ulong, done,
+						 priv->rx_stats.max_batch);
+		if (done >= min(PKTBUFSRX, ETH_RX_BUDGET))
+			priv->rx_stats.ring_full++;
 	}
+
 	if (ret == -EAGAIN)
 		ret = 0;
 	if (ret < 0) {
@@ -388,6 +458,21 @@ int eth_rx(void)
 	return ret;
 }
 
+void eth_get_rx_stats(struct udevice *dev, struct eth_rx_stats *stats)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+
+	memcpy(stats, &priv->rx_stats, sizeof(*stats));
+	memset(&priv->rx_stats, '\0', sizeof(priv->rx_stats));
+}
+
+void eth_rx_dropped(struct udevice *dev, int count)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+
+	priv->rx_stats.dropped += count;
+}
+
 int eth_initialize(void)
 {
 	int num_devices = 0;
@@ -502,6 +587,8 @@ static int eth_post_probe(struct udevice *dev)
 			ops->send += gd->reloc_off;
 		if (ops->recv)
 			ops->recv += gd->reloc_off;
+		if (ops->recv_batch)
+			ops->recv_batch += gd->reloc_off;
 		if (ops->free_pkt)
 			ops->free_pkt += gd->reloc_off;
 		if (ops->stop)
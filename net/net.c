@@ -149,6 +149,8 @@ struct in_addr	net_server_ip;
 uchar *net_rx_packet;
 /* Current rx packet length */
 int		net_rx_packet_len;
+/* Current rx packet's UDP checksum was checked by the hardware */
+bool		net_rx_csum_valid;
 /* IP packet ID */
 static unsigned	net_ip_id;
 /* Ethernet bcast address */
@@ -878,13 +880,10 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 
 #ifdef CONFIG_IP_DEFRAG
 /*
- * This function collects fragments in a single packet, according
- * to the algorithm in RFC815. It returns NULL or the pointer to
- * a complete packet, in static storage
+ * These functions collect fragments into whole packets, according
+ * to the algorithm in RFC815. Up to CONFIG_NET_DEFRAG_SLOTS datagrams
+ * can be reassembled at the same time, each in its own static buffer.
  */
-#ifndef CONFIG_NET_MAXDEFRAG
-#define CONFIG_NET_MAXDEFRAG 16384
-#endif
 #define IP_PKTSIZE (CONFIG_NET_MAXDEFRAG)
 
 #define IP_MAXUDP (IP_PKTSIZE - IP_HDR_SIZE)
@@ -901,36 +900,106 @@ struct hole {
 	u16 unused;
 };
 
+/**
+ * struct ip_reasm - a datagram being reassembled
+ *
+ * @used: true if this slot holds a datagram
+ * @first_hole: index (in 8-byte blocks) of the first missing part
+ * @total_len: payload length, 0xffff until the last fragment is seen
+ * @stamp: get_timer() value when the first fragment was received
+ */
+struct ip_reasm {
+	bool used;
+	u16 first_hole;
+	u16 total_len;
+	ulong stamp;
+};
+
+/* A hole descriptor may sit right after the largest possible payload */
+#define IP_REASM_BUFSIZE ALIGN(IP_PKTSIZE + sizeof(struct hole), PKTALIGN)
+
+static uchar ip_reasm_buf[CONFIG_NET_DEFRAG_SLOTS][IP_REASM_BUFSIZE]
+	__aligned(PKTALIGN);
+static struct ip_reasm ip_reasm[CONFIG_NET_DEFRAG_SLOTS];
+
+/*
+ * Find the slot collecting the datagram this fragment belongs to. If there
+ * is none, start a new one in a free slot, or else in the slot of the
+ * oldest datagram. Datagrams which did not complete in time are dropped.
+ */
+static int ip_reasm_find(struct ip_udp_hdr *ip)
+{
+	struct ip_udp_hdr *localip;
+	struct ip_reasm *slot;
+	ulong now = get_timer(0);
+	int victim = -1;
+	int i;
+
+	for (i = 0; i < CONFIG_NET_DEFRAG_SLOTS; i++) {
+		slot = &ip_reasm[i];
+		localip = (struct ip_udp_hdr *)ip_reasm_buf[i];
+		if (slot->used &&
+		    now - slot->stamp > CONFIG_NET_DEFRAG_TIMEOUT) {
+			debug_cond(DEBUG_NET_PKT, "defrag: id %04x timed out\n",
+				   ntohs(localip->ip_id));
+			slot->used = false;
+		}
+		if (!slot->used) {
+			if (victim < 0 || ip_reasm[victim].used)
+				victim = i;
+			continue;
+		}
+
+		if (localip->ip_id == ip->ip_id &&
+		    localip->ip_p == ip->ip_p &&
+		    !memcmp(&localip->ip_src, &ip->ip_src,
+			    2 * sizeof(struct in_addr)))
+			return i;
+
+		if (victim < 0 || (ip_reasm[victim].used &&
+				   now - slot->stamp >
+				   now - ip_reasm[victim].stamp))
+			victim = i;
+	}
+
+	/* new packet, reset structs */
+	slot = &ip_reasm[victim];
+	slot->used = true;
+	slot->stamp = now;
+	slot->total_len = 0xffff;
+	slot->first_hole = 0;
+	((struct hole *)(ip_reasm_buf[victim] + IP_HDR_SIZE))[0] =
+		(struct hole){ .last_byte = ~0 };
+	/* any IP header will work, copy the first we received */
+	memcpy(ip_reasm_buf[victim], ip, IP_HDR_SIZE);
+
+	return victim;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
 	struct hole *payload, *thisfrag, *h, *newh;
-	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
+	struct ip_udp_hdr *localip;
+	struct ip_reasm *slot;
 	uchar *indata = (uchar *)ip;
 	int offset8, start, len, done = 0;
 	u16 ip_off = ntohs(ip->ip_off);
+	int idx;
 
-	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
 	offset8 =  (ip_off & IP_OFFS);
-	thisfrag = payload + offset8;
 	start = offset8 * 8;
 	len = ntohs(ip->ip_len) - IP_HDR_SIZE;
 
 	if (start + len > IP_MAXUDP) /* fragment extends too far */
 		return NULL;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
-		payload[0].last_byte = ~0;
-		payload[0].next_hole = 0;
-		payload[0].prev_hole = 0;
-		first_hole = 0;
-		/* any IP header will work, copy the first we received */
-		memcpy(localip, ip, IP_HDR_SIZE);
-	}
+	idx = ip_reasm_find(ip);
+	slot = &ip_reasm[idx];
+	localip = (struct ip_udp_hdr *)ip_reasm_buf[idx];
+
+	/* payload starts after IP header, this fragment is in there */
+	payload = (struct hole *)(ip_reasm_buf[idx] + IP_HDR_SIZE);
+	thisfrag = payload + offset8;
 
 	/*
 	 * What follows is the reassembly algorithm. We use the payload
@@ -939,7 +1008,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + slot->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
@@ -956,7 +1025,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		slot->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -973,7 +1042,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 			done = 1;
 		} else if (!h->prev_hole) {
 			/* first hole */
-			first_hole = h->next_hole;
+			slot->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -998,7 +1067,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		if (h->prev_hole)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			slot->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -1016,8 +1085,12 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	localip->ip_len = htons(total_len);
-	*lenp = total_len + IP_HDR_SIZE;
+	/* the packet stays in the buffer until the caller is done with it */
+	slot->used = false;
+	/* the hardware cannot have checked a datagram sent in fragments */
+	net_rx_csum_valid = false;
+	localip->ip_len = htons(slot->total_len);
+	*lenp = slot->total_len + IP_HDR_SIZE;
 	return localip;
 }
 
@@ -1269,7 +1342,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   &dst_ip, &src_ip, len);
 
 #ifdef CONFIG_UDP_CHECKSUM
-		if (ip->udp_xsum != 0) {
+		if (ip->udp_xsum != 0 && !net_rx_csum_valid) {
 			ulong   xsum;
 			u8 *sumptr;
 			ushort  sumlen;
@@ -668,7 +668,8 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* only the headers are copied, the data is stored from the packet */
+	memcpy(&rpc_pkt.u.data[0], pkt, min_t(unsigned, len, sizeof(rpc_pkt)));
 
 	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
 		return -NFS_RPC_ERR;
@@ -709,8 +710,9 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
+	if ((data_ptr - (uchar *)&rpc_pkt) + rlen > len)
 			return -9999;
+	data_ptr = pkt + (data_ptr - (uchar *)&rpc_pkt);
 
 	if (store_block(data_ptr, nfs_offset, rlen))
 			return -9999;
@@ -743,7 +745,8 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 	debug("%s\n", __func__);
 
-	if (len > sizeof(struct rpc_t))
+	/* read replies carry up to NFS_READ_SIZE bytes of file data */
+	if (len > sizeof(struct rpc_t) && nfs_state != STATE_READ_REQ)
 		return;
 
 	if (dest != nfs_our_port)
@@ -38,10 +38,17 @@
 /*
  * Block size used for NFS read accesses.  A RPC reply packet (including  all
  * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
- * case, most NFS servers are optimized for a power of 2.
+ * However, if CONFIG_IP_DEFRAG is set, a bigger value can be selected with
+ * CONFIG_NFS_READ_SIZE.  In any case, most NFS servers are optimized for a
+ * power of 2.
  */
+#ifdef CONFIG_NFS_READ_SIZE
+#define NFS_READ_SIZE	CONFIG_NFS_READ_SIZE
+#else
 #define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
+#endif
+/* Room for RPC reply data other than file contents (which is not copied) */
+#define NFS_RPC_DATA_SIZE	1024
 #define NFS_MAX_ATTRS	26
 
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
@@ -56,7 +63,7 @@ enum rpc_accept_stat {
 
 struct rpc_t {
 	union {
-		uint8_t data[NFS_READ_SIZE + (6 + NFS_MAX_ATTRS) *
+		uint8_t data[NFS_RPC_DATA_SIZE + (6 + NFS_MAX_ATTRS) *
 			sizeof(uint32_t)];
 		struct {
 			uint32_t id;
@@ -74,7 +81,7 @@ struct rpc_t {
 			uint32_t verifier;
 			uint32_t v2;
 			uint32_t astatus;
-			uint32_t data[NFS_READ_SIZE / sizeof(uint32_t) +
+			uint32_t data[NFS_RPC_DATA_SIZE / sizeof(uint32_t) +
 				NFS_MAX_ATTRS];
 		} reply;
 	} u;
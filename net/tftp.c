@@ -141,6 +141,14 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/* RFC 7440 window: number of blocks the server sends per acknowledgement */
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = CONFIG_TFTP_WINDOWSIZE;
+/* blocks received since we last sent an acknowledgement */
+static unsigned short tftp_window_pos;
+/* 1 if we already asked the server to resend after a lost block */
+static int tftp_window_nacked;
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset;
@@ -200,6 +208,8 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_window_pos = 0;
+	tftp_window_nacked = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -352,6 +362,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and for a window of blocks per ACK, only when reading */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 		len = pkt - xp;
 		break;
 
@@ -496,6 +510,16 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("Blocksize ack: %s, %d\n",
 				      (char *)pkt + i + 8, tftp_block_size);
 			}
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size =
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+				if (!tftp_window_size ||
+				    tftp_window_size > tftp_window_size_option)
+					tftp_window_size = 1;
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				tftp_tsize = simple_strtoul((char *)pkt + i + 6,
@@ -520,8 +544,6 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		len -= 2;
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
-		update_block_number();
-
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
@@ -547,7 +569,35 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			break;
 		}
 
+		if (tftp_cur_block != ((tftp_prev_block + 1) &
+				       (TFTP_SEQUENCE_SIZE - 1))) {
+			/*
+			 * A block of the window was lost or reordered. Drop
+			 * blocks beyond the gap and acknowledge the last block
+			 * received in order, so that the server resends the
+			 * window from there (RFC 7440). Do this once per gap,
+			 * not for every following block of the window, and
+			 * silently drop stale blocks from an older window.
+			 */
+			ulong ahead = (tftp_cur_block - tftp_prev_block) &
+				      (TFTP_SEQUENCE_SIZE - 1);
+
+			debug("Got block %ld, expected %ld\n", tftp_cur_block,
+			      tftp_prev_block + 1);
+			tftp_cur_block = tftp_prev_block;
+			if (ahead < TFTP_SEQUENCE_SIZE / 2 &&
+			    !tftp_window_nacked) {
+				tftp_window_nacked = 1;
+				tftp_window_pos = 0;
+				tftp_send();
+			}
+			break;
+		}
+
+		update_block_number();
+
 		tftp_prev_block = tftp_cur_block;
+		tftp_window_nacked = 0;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
@@ -559,9 +609,14 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 		/*
 		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
+		 *	the remote for the next one. With a window, only the
+		 *	last block of each window is acknowledged.
 		 */
-		tftp_send();
+		if (++tftp_window_pos >= tftp_window_size ||
+		    len < tftp_block_size) {
+			tftp_window_pos = 0;
+			tftp_send();
+		}
 
 		if (len < tftp_block_size)
 			tftp_complete();
@@ -600,6 +655,8 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		/* the server restarts its window after our ACK */
+		tftp_window_pos = 0;
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
@@ -638,6 +695,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -659,8 +720,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -759,8 +820,9 @@ void tftp_start(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 #ifdef CONFIG_TFTP_TSIZE
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
@@ -791,8 +853,9 @@ void tftp_start_server(void)
 	timeout_ms = TIMEOUT;
 	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
 
-	/* Revert tftp_block_size to dflt */
+	/* Revert tftp_block_size and tftp_window_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -106,7 +106,8 @@ static char ut_help_text[] =
 	"all - execute all enabled tests\n"
 #ifdef CONFIG_SANDBOX
 	"ut bloblist - Test bloblist implementation\n"
-	"ut compression - Test compressors and bootm decompression\n"
+	"ut compression [bench <dir>] - Test compressors and bootm\n"
+	"    decompression, or measure decompression speed of files in <dir>\n"
 #endif
 #ifdef CONFIG_UT_DM
 	"ut dm [test-name]\n"
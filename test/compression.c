@@ -6,10 +6,15 @@
 #include <common.h>
 #include <bootm.h>
 #include <command.h>
+#include <decomp_parallel.h>
+#include <decomp_stream.h>
+#include <div64.h>
 #include <gzip.h>
 #include <lz4.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <os.h>
+#include <zstd.h>
 #include <asm/io.h>
 
 #include <u-boot/zlib.h>
@@ -119,6 +124,23 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -294,6 +316,40 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq(0, memcmp(plain, in, in_size));
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -438,6 +494,13 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -528,17 +591,338 @@ static int compression_test_bootm_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_lz4, 0);
 
+static int compression_test_bootm_zstd(struct unit_test_state *uts)
+{
+	return run_bootm_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_bootm_zstd, 0);
+
 static int compression_test_bootm_none(struct unit_test_state *uts)
 {
 	return run_bootm_test(uts, IH_COMP_NONE, compress_using_none);
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/* Write @in to @ds in pieces of @chunk bytes */
+static int stream_write_chunks(struct decomp_stream *ds, const void *in,
+			       ulong in_size, ulong chunk)
+{
+	ulong pos, count;
+	int ret;
+
+	for (pos = 0; pos < in_size; pos += count) {
+		count = min(chunk, in_size - pos);
+		ret = decomp_stream_write(ds, in + pos, count);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * run_stream_test() - Run tests on streaming decompression
+ *
+ * @comp_type:	Compression type to test
+ * @compress:	Our function to compress data
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_stream_test(struct unit_test_state *uts, int comp_type,
+			   mutate_func compress)
+{
+	static const ulong chunks[] = { 1, 3, 7, 64, TEST_BUFFER_SIZE };
+	ulong compress_size = TEST_BUFFER_SIZE;
+	struct decomp_stream ds;
+	ulong unc_len = strlen(plain);
+	void *compress_buff;
+	char *out;
+	size_t len;
+	int i;
+
+	printf("Testing: %s\n", genimg_get_comp_name(comp_type));
+	compress_buff = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(compress_buff);
+	out = malloc(TEST_BUFFER_SIZE);
+	ut_assertnonnull(out);
+	ut_assertok(compress(uts, (void *)plain, unc_len, compress_buff,
+			     compress_size, &compress_size));
+
+	/* Any size of piece gives the same result */
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		memset(out, 'A', TEST_BUFFER_SIZE);
+		ut_assertok(decomp_stream_start(&ds, comp_type, out, unc_len));
+		ut_assertok(stream_write_chunks(&ds, compress_buff,
+						compress_size, chunks[i]));
+		ut_assertok(decomp_stream_finish(&ds, &len));
+		ut_asserteq(unc_len, len);
+		ut_assertok(memcmp(plain, out, unc_len));
+		ut_asserteq('A', out[unc_len]);
+	}
+
+	/* The output must not overrun the buffer */
+	memset(out, 'A', TEST_BUFFER_SIZE);
+	ut_assertok(decomp_stream_start(&ds, comp_type, out, unc_len - 1));
+	stream_write_chunks(&ds, compress_buff, compress_size, 64);
+	ut_assert(decomp_stream_finish(&ds, &len));
+	ut_asserteq('A', out[unc_len - 1]);
+
+	/* Data which stops early is an error */
+	if (comp_type != IH_COMP_NONE) {
+		ut_assertok(decomp_stream_start(&ds, comp_type, out,
+						TEST_BUFFER_SIZE));
+		stream_write_chunks(&ds, compress_buff, compress_size - 1, 7);
+		ut_assert(decomp_stream_finish(&ds, NULL));
+	}
+
+	free(out);
+	free(compress_buff);
+
+	return 0;
+}
+
+static int compression_test_stream_gzip(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_GZIP, compress_using_gzip);
+}
+COMPRESSION_TEST(compression_test_stream_gzip, 0);
+
+static int compression_test_stream_lzma(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZMA, compress_using_lzma);
+}
+COMPRESSION_TEST(compression_test_stream_lzma, 0);
+
+static int compression_test_stream_lz4(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_LZ4, compress_using_lz4);
+}
+COMPRESSION_TEST(compression_test_stream_lz4, 0);
+
+static int compression_test_stream_zstd(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_stream_zstd, 0);
+
+static int compression_test_stream_none(struct unit_test_state *uts)
+{
+	return run_stream_test(uts, IH_COMP_NONE, compress_using_none);
+}
+COMPRESSION_TEST(compression_test_stream_none, 0);
+
+/**
+ * run_parallel_test() - Run tests on decompressing frames on several CPUs
+ *
+ * Several copies of a frame make data with independent frames.
+ *
+ * @comp_type:	Compression type to test
+ * @frame:	A frame holding the compressed test data, with its size
+ * @frame_size:	Size of @frame in bytes
+ * @return 0 if OK, non-zero on failure
+ */
+static int run_parallel_test(struct unit_test_state *uts, int comp_type,
+			     const void *frame, ulong frame_size)
+{
+	const int nframes = 5;
+	ulong unc_len = strlen(plain);
+	void *compress_buff;
+	char *out;
+	size_t len;
+	int i;
+
+	printf("Testing: %s\n", genimg_get_comp_name(comp_type));
+	compress_buff = malloc(frame_size * nframes);
+	ut_assertnonnull(compress_buff);
+	out = malloc(unc_len * nframes + 1);
+	ut_assertnonnull(out);
+	for (i = 0; i < nframes; i++)
+		memcpy(compress_buff + i * frame_size, frame, frame_size);
+
+	memset(out, 'A', unc_len * nframes + 1);
+	len = unc_len * nframes;
+	ut_assertok(decomp_parallel(comp_type, compress_buff,
+				    frame_size * nframes, out, &len));
+	ut_asserteq(unc_len * nframes, len);
+	for (i = 0; i < nframes; i++)
+		ut_assertok(memcmp(plain, out + i * unc_len, unc_len));
+	ut_asserteq('A', out[len]);
+
+	/* The output must fit */
+	len = unc_len * nframes - 1;
+	ut_asserteq(-ENOSPC, decomp_parallel(comp_type, compress_buff,
+					     frame_size * nframes, out, &len));
+
+	/* A single frame is left to the usual decompressor */
+	len = unc_len;
+	ut_asserteq(-ENOSYS, decomp_parallel(comp_type, compress_buff,
+					     frame_size, out, &len));
+
+	/* So is data with no content size */
+	if (comp_type == IH_COMP_LZ4) {
+		memcpy(compress_buff, lz4_compressed, lz4_compressed_size);
+		memcpy(compress_buff + lz4_compressed_size, lz4_compressed,
+		       lz4_compressed_size);
+		len = unc_len * nframes;
+		ut_asserteq(-ENOSYS,
+			    decomp_parallel(comp_type, compress_buff,
+					    lz4_compressed_size * 2, out,
+					    &len));
+		memcpy(compress_buff, frame, frame_size);
+		memcpy(compress_buff + frame_size, frame, frame_size);
+	}
+
+	/* A bad frame is found, whichever CPU decompresses it */
+	memset(compress_buff + frame_size * 3 + frame_size / 2, '\x49', 16);
+	len = unc_len * nframes;
+	ut_assert(decomp_parallel(comp_type, compress_buff,
+				  frame_size * nframes, out, &len));
+
+	free(out);
+	free(compress_buff);
+
+	return 0;
+}
+
+static int compression_test_parallel_lz4(struct unit_test_state *uts)
+{
+	ulong unc_len = strlen(plain);
+	char frame[sizeof(lz4_compressed) + sizeof(u64)];
+	u64 size = cpu_to_le64(unc_len);
+
+	/* Add the content size to the frame header: magic, flags, BD */
+	memcpy(frame, lz4_compressed, 6);
+	frame[4] |= 0x08;
+	memcpy(frame + 6, &size, sizeof(size));
+	memcpy(frame + 6 + sizeof(size), lz4_compressed + 6,
+	       lz4_compressed_size - 6);
+
+	return run_parallel_test(uts, IH_COMP_LZ4, frame,
+				 lz4_compressed_size + sizeof(size));
+}
+COMPRESSION_TEST(compression_test_parallel_lz4, 0);
+
+static int compression_test_parallel_zstd(struct unit_test_state *uts)
+{
+	return run_parallel_test(uts, IH_COMP_ZSTD, zstd_compressed,
+				 zstd_compressed_size);
+}
+COMPRESSION_TEST(compression_test_parallel_zstd, 0);
+
+/* Minimum time to spend decompressing with each format in the benchmark */
+#define BENCH_US	200000
+
+struct bench_format {
+	const char *name;
+	const char *ext;
+	mutate_func uncompress;
+};
+
+/*
+ * The benchmark reads the text and its compressed forms from a host
+ * directory, as made by the host tools in test_ut.py. A format is skipped
+ * if its file is not there.
+ */
+static const struct bench_format bench_formats[] = {
+	{ "gzip", "gz", uncompress_using_gzip },
+	{ "bzip2", "bz2", uncompress_using_bzip2 },
+	{ "lzma", "lzma", uncompress_using_lzma },
+	{ "lzo", "lzo", uncompress_using_lzo },
+	{ "lz4", "lz4", uncompress_using_lz4 },
+	{ "zstd", "zst", uncompress_using_zstd },
+};
+
+/* Return the decompression speed of @fmt on @text in MB/s */
+static int run_bench(struct unit_test_state *uts,
+		     const struct bench_format *fmt, const char *text,
+		     ulong text_size, void *compressed_buf,
+		     ulong compressed_size, void *uncompressed_buf,
+		     ulong *speed)
+{
+	ulong uncompressed_size;
+	ulong start, elapsed;
+	u64 bytes = 0;
+
+	start = timer_get_us();
+	do {
+		if (fmt->uncompress(uts, compressed_buf, compressed_size,
+				    uncompressed_buf, text_size,
+				    &uncompressed_size))
+			return -EINVAL;
+		bytes += uncompressed_size;
+		elapsed = timer_get_us() - start;
+	} while (elapsed < BENCH_US);
+
+	if (uncompressed_size != text_size ||
+	    memcmp(text, uncompressed_buf, text_size))
+		return -EINVAL;
+
+	/* a byte per microsecond is a MB/s */
+	*speed = lldiv(bytes, elapsed);
+
+	return 0;
+}
+
+static int compression_bench(const char *dir)
+{
+	struct unit_test_state uts = { .fail_count = 0 };
+	void *text, *compressed_buf, *uncompressed_buf;
+	int text_size, compressed_size;
+	char fname[256];
+	loff_t size;
+	ulong speed;
+	int i, ret = 0;
+
+	snprintf(fname, sizeof(fname), "%s/text", dir);
+	if (os_read_file(fname, &text, &text_size))
+		return CMD_RET_FAILURE;
+	uncompressed_buf = malloc(text_size);
+	if (!uncompressed_buf) {
+		printf("Cannot allocate the buffer\n");
+		os_free(text);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Decompressing %d bytes of text\n", text_size);
+	printf("%8s%10s\n", "format", "MB/s");
+	for (i = 0; i < ARRAY_SIZE(bench_formats); i++) {
+		const struct bench_format *fmt = &bench_formats[i];
+
+		snprintf(fname, sizeof(fname), "%s/text.%s", dir, fmt->ext);
+		if (os_get_filesize(fname, &size)) {
+			printf("%8s%10s\n", fmt->name, "skipped");
+			continue;
+		}
+		if (os_read_file(fname, &compressed_buf, &compressed_size)) {
+			ret = -EIO;
+			continue;
+		}
+		if (run_bench(&uts, fmt, text, text_size, compressed_buf,
+			      compressed_size, uncompressed_buf, &speed)) {
+			printf("%8s%10s\n", fmt->name, "failed");
+			ret = -EINVAL;
+		} else {
+			printf("%8s%10lu\n", fmt->name, speed);
+		}
+		os_free(compressed_buf);
+	}
+
+	free(uncompressed_buf);
+	os_free(text);
+
+	return ret ? CMD_RET_FAILURE : 0;
+}
+
 int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test,
 						 compression_test);
 	const int n_ents = ll_entry_count(struct unit_test, compression_test);
 
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		if (argc < 3)
+			return CMD_RET_USAGE;
+		return compression_bench(argv[2]);
+	}
+
 	return cmd_ut_category("compression", tests, n_ents, argc, argv);
 }
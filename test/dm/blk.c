@@ -162,3 +162,65 @@ static int dm_test_blk_get_from_parent(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_get_from_parent, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test that the block cache finds cached extents and evicts the oldest */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dev_stats;
+	struct block_cache_stats stats;
+	char buf[4 * 512], out[2 * 512];
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i / 512;
+
+	/* A single set holding four extents of up to four blocks */
+	blkcache_configure(4, 4);
+	blkcache_fill(IF_TYPE_HOST, 9, 0, 4, 512, buf);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 9, 2, 2, 512, out));
+	ut_assert(!memcmp(buf + 2 * 512, out, sizeof(out)));
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 9, 3, 2, 512, out));
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 8, 0, 1, 512, out));
+
+	/* Fill the set, touch the first extent, then evict the second */
+	blkcache_fill(IF_TYPE_HOST, 9, 4, 4, 512, buf);
+	blkcache_fill(IF_TYPE_HOST, 9, 8, 4, 512, buf);
+	blkcache_fill(IF_TYPE_HOST, 9, 12, 4, 512, buf);
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 9, 0, 1, 512, out));
+	blkcache_fill(IF_TYPE_HOST, 9, 16, 4, 512, buf);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 9, 5, 1, 512, out));
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 9, 18, 1, 512, out));
+	ut_asserteq(1, blkcache_read(IF_TYPE_HOST, 9, 3, 1, 512, out));
+
+	blkcache_stats(&stats);
+	ut_asserteq(4, stats.hits);
+	ut_asserteq(3, stats.misses);
+	ut_asserteq(1, stats.evictions);
+	ut_asserteq(4, stats.entries);
+
+	ut_assertok(blkcache_dev_stats(0, &dev_stats));
+	ut_asserteq(IF_TYPE_HOST, dev_stats.iftype);
+	ut_asserteq(9, dev_stats.devnum);
+	ut_asserteq(4, dev_stats.hits);
+	ut_asserteq(2, dev_stats.misses);
+	ut_asserteq(4, dev_stats.entries);
+	ut_assertok(blkcache_dev_stats(1, &dev_stats));
+	ut_asserteq(8, dev_stats.devnum);
+	ut_asserteq(1, dev_stats.misses);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dev_stats));
+
+	/* A write to the device drops all of its extents */
+	blkcache_invalidate(IF_TYPE_HOST, 9);
+	ut_asserteq(0, blkcache_read(IF_TYPE_HOST, 9, 0, 1, 512, out));
+	blkcache_stats(&stats);
+	ut_asserteq(0, stats.entries);
+
+	blkcache_configure(CONFIG_BLOCK_CACHE_BLOCKS,
+			   CONFIG_BLOCK_CACHE_SIZE * 1024 /
+			   (CONFIG_BLOCK_CACHE_BLOCKS * 512));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
@@ -70,6 +70,16 @@ static struct driver_info driver_info_act_dma = {
 	.name = "test_act_dma_drv",
 };
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+static struct driver_info driver_info_async = {
+	.name = "test_async_drv",
+};
+
+static struct driver_info driver_info_async_stuck = {
+	.name = "test_async_stuck_drv",
+};
+#endif
+
 void dm_leak_check_start(struct unit_test_state *uts)
 {
 	uts->start = mallinfo();
@@ -721,6 +731,77 @@ static int dm_test_remove_active_dma(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_remove_active_dma, 0);
 
+#if CONFIG_IS_ENABLED(DM_PROBE_ASYNC)
+/* Test that a device can finish probing after device_probe_start() */
+static int dm_test_probe_async(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	int post_probe;
+	struct udevice *dev;
+
+	ut_assertok(device_bind_by_name(dms->root, false, &driver_info_async,
+					&dev));
+
+	/* The uclass does not see the device until it is ready */
+	post_probe = dm_testdrv_op_count[DM_TEST_OP_POST_PROBE];
+	ut_assertok(device_probe_start(dev));
+	ut_assert(!device_active(dev));
+	ut_assert(dev->flags & DM_FLAG_PROBE_PENDING);
+	ut_asserteq(1, gd->dm_probe_pending);
+	ut_asserteq(-EAGAIN, device_probe_poll(dev));
+	ut_asserteq(-EAGAIN, device_probe_poll(dev));
+	ut_asserteq(post_probe, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+	ut_assertok(device_probe_poll(dev));
+	ut_assert(device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_asserteq(0, gd->dm_probe_pending);
+	ut_asserteq(post_probe + 1, dm_testdrv_op_count[DM_TEST_OP_POST_PROBE]);
+
+	/* Probing waits for the device to be ready */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_probe_start(dev));
+	ut_assertok(device_probe(dev));
+	ut_assert(device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_asserteq(0, gd->dm_probe_pending);
+
+	/* So does removing it */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_probe_start(dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assert(!device_active(dev));
+	ut_asserteq(0, gd->dm_probe_pending);
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async, 0);
+
+/* Test that waiting for a device which does not become ready times out */
+static int dm_test_probe_async_timeout(struct unit_test_state *uts)
+{
+	struct dm_test_state *dms = uts->priv;
+	struct udevice *dev;
+	int remove;
+
+	ut_assertok(device_bind_by_name(dms->root, false,
+					&driver_info_async_stuck, &dev));
+
+	remove = dm_testdrv_op_count[DM_TEST_OP_REMOVE];
+	ut_assertok(device_probe_start(dev));
+	ut_asserteq(-EAGAIN, device_probe_poll(dev));
+	ut_asserteq(-ETIMEDOUT, device_probe(dev));
+	ut_assert(!device_active(dev));
+	ut_assert(!(dev->flags & DM_FLAG_PROBE_PENDING));
+	ut_asserteq(0, gd->dm_probe_pending);
+	ut_asserteq(remove + 1, dm_testdrv_op_count[DM_TEST_OP_REMOVE]);
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_async_timeout, 0);
+#endif
+
 static int dm_test_uclass_before_ready(struct unit_test_state *uts)
 {
 	struct uclass *uc;
@@ -9,6 +9,7 @@
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
 #include <cpu.h>
+#include <asm/test.h>
 #include <test/ut.h>
 
 static int dm_test_cpu(struct unit_test_state *uts)
@@ -43,3 +44,53 @@ static int dm_test_cpu(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_cpu, DM_TESTF_SCAN_FDT);
+
+static void dm_test_cpu_func(void *arg)
+{
+	int *val = arg;
+
+	*val = 42;
+}
+
+static int dm_test_cpu_run(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	int val = 0;
+
+	/* The first CPU runs U-Boot so cannot run anything else */
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu-test1", &dev));
+	ut_asserteq(1, cpu_is_current(dev));
+	ut_asserteq(-EBUSY, cpu_run(dev, dm_test_cpu_func, &val));
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_CPU, "cpu-test2", &dev));
+	ut_asserteq(0, cpu_is_current(dev));
+	ut_assertok(cpu_run(dev, dm_test_cpu_func, &val));
+	ut_assertok(cpu_wait(dev));
+	ut_asserteq(42, val);
+
+	/* Once finished, the CPU can run something else */
+	val = 0;
+	ut_assertok(cpu_run(dev, dm_test_cpu_func, &val));
+	ut_assertok(cpu_wait(dev));
+	ut_asserteq(42, val);
+
+	/* Waiting for a CPU which is not running anything is fine */
+	ut_assertok(cpu_wait(dev));
+
+	/* A CPU which does not start is given up on, and not used again */
+	val = 0;
+	sandbox_cpu_set_stuck(true);
+	ut_assertok(cpu_run(dev, dm_test_cpu_func, &val));
+	ut_asserteq(-ETIMEDOUT, cpu_wait(dev));
+	ut_asserteq(-ENODEV, cpu_run(dev, dm_test_cpu_func, &val));
+	ut_assertok(cpu_wait(dev));
+
+	/* If it starts late, the function that timed out does not run */
+	sandbox_cpu_set_stuck(false);
+	mdelay(100);
+	ut_asserteq(0, val);
+
+	return 0;
+}
+
+DM_TEST(dm_test_cpu_run, DM_TESTF_SCAN_FDT);
@@ -16,6 +16,7 @@
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 #include <asm/eth.h>
+#include <asm/test.h>
 #include <test/ut.h>
 
 #define DM_TEST_ETH_NUM		4
@@ -429,3 +430,218 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_eth_async_ping_reply, DM_TESTF_SCAN_FDT);
+
+/* Check that a burst of packets is received in one poll and accounted for */
+static int dm_test_eth_rx_batch(struct unit_test_state *uts)
+{
+	struct eth_sandbox_priv *priv;
+	struct eth_rx_stats stats;
+	struct udevice *dev;
+	int i;
+
+	net_init();
+	env_set("ethact", "eth@10002000");
+	ut_assertok(eth_init());
+	dev = eth_get_dev();
+	ut_assertnonnull(dev);
+	priv = dev_get_priv(dev);
+	priv->fake_host_ipaddr = string_to_ip("1.1.2.4");
+	eth_get_rx_stats(dev, &stats);
+
+	/* Fill the ring, then overflow it by one packet */
+	for (i = 0; i < PKTBUFSRX; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(-EOVERFLOW, sandbox_eth_recv_arp_req(dev));
+
+	ut_asserteq(0, eth_rx());
+	ut_asserteq(0, priv->recv_packets);
+	eth_get_rx_stats(dev, &stats);
+	ut_asserteq(PKTBUFSRX, stats.packets);
+	ut_asserteq(1, stats.polls);
+	ut_asserteq(PKTBUFSRX, stats.max_batch);
+	ut_asserteq(1, stats.ring_full);
+	ut_asserteq(1, stats.dropped);
+
+	/* The statistics are reset once read */
+	eth_get_rx_stats(dev, &stats);
+	ut_asserteq(0, stats.packets);
+	ut_asserteq(0, stats.dropped);
+
+	/* A part-filled ring wraps around correctly */
+	for (i = 0; i < 3; i++)
+		ut_assertok(sandbox_eth_recv_arp_req(dev));
+	ut_asserteq(0, eth_rx());
+	eth_get_rx_stats(dev, &stats);
+	ut_asserteq(3, stats.packets);
+	ut_asserteq(0, stats.ring_full);
+
+	eth_halt();
+
+	return 0;
+}
+DM_TEST(dm_test_eth_rx_batch, DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_IP_DEFRAG
+#define DEFRAG_TEST_LEN		2992	/* UDP payload of each datagram */
+#define DEFRAG_TEST_FRAG	1000	/* fragment size, a multiple of 8 */
+#define DEFRAG_TEST_FRAGS	3
+
+static int defrag_rx_count;
+static uchar defrag_rx_seed;
+static bool defrag_rx_ok;
+
+static void defrag_udp_handler(uchar *pkt, unsigned dport,
+			       struct in_addr sip, unsigned sport,
+			       unsigned len)
+{
+	int i;
+
+	defrag_rx_count++;
+	defrag_rx_seed = pkt[0];
+	defrag_rx_ok = len == DEFRAG_TEST_LEN;
+	for (i = 0; i < len; i++)
+		if (pkt[i] != (uchar)(defrag_rx_seed + i))
+			defrag_rx_ok = false;
+}
+
+/* Inject fragment @frag of a UDP datagram whose payload starts with @seed */
+static void defrag_send_frag(int id, uchar seed, int frag)
+{
+	uchar dgram[IP_UDP_HDR_SIZE + DEFRAG_TEST_LEN + 1];
+	uchar pkt[ETHER_HDR_SIZE + IP_HDR_SIZE + DEFRAG_TEST_FRAG];
+	struct ethernet_hdr *et = (struct ethernet_hdr *)pkt;
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)(pkt + ETHER_HDR_SIZE);
+	int offset = frag * DEFRAG_TEST_FRAG;
+	int len;
+	int i;
+
+	for (i = 0; i < DEFRAG_TEST_LEN; i++)
+		dgram[IP_UDP_HDR_SIZE + i] = seed + i;
+	net_set_udp_header(dgram, net_ip, 1234, 69, DEFRAG_TEST_LEN);
+	len = min_t(int, DEFRAG_TEST_FRAG,
+		    UDP_HDR_SIZE + DEFRAG_TEST_LEN - offset);
+
+	memcpy(et->et_dest, net_ethaddr, ARP_HLEN);
+	memset(et->et_src, 0x55, ARP_HLEN);
+	et->et_protlen = htons(PROT_IP);
+	memcpy(ip, dgram, IP_HDR_SIZE);
+	memcpy((uchar *)ip + IP_HDR_SIZE, dgram + IP_HDR_SIZE + offset, len);
+	ip->ip_len = htons(IP_HDR_SIZE + len);
+	ip->ip_id = htons(id);
+	ip->ip_off = htons(offset / 8 |
+			   (frag < DEFRAG_TEST_FRAGS - 1 ? IP_FLAGS_MFRAG : 0));
+	ip->ip_sum = 0;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + IP_HDR_SIZE + len);
+}
+
+/* Check reassembly of interleaved datagrams, slot eviction and timeout */
+static int dm_test_net_defrag(struct unit_test_state *uts)
+{
+	int i;
+
+	net_init();
+	net_ip = string_to_ip("1.1.2.2");
+	net_set_udp_handler(defrag_udp_handler);
+	defrag_rx_count = 0;
+
+	/* Two datagrams with interleaved, out-of-order fragments */
+	defrag_send_frag(1, 0x11, 0);
+	defrag_send_frag(2, 0x22, 2);
+	defrag_send_frag(2, 0x22, 0);
+	defrag_send_frag(1, 0x11, 2);
+	ut_asserteq(0, defrag_rx_count);
+	defrag_send_frag(2, 0x22, 1);
+	ut_asserteq(1, defrag_rx_count);
+	ut_asserteq(0x22, defrag_rx_seed);
+	ut_assert(defrag_rx_ok);
+	defrag_send_frag(1, 0x11, 1);
+	ut_asserteq(2, defrag_rx_count);
+	ut_asserteq(0x11, defrag_rx_seed);
+	ut_assert(defrag_rx_ok);
+
+	/* A duplicate of the last fragment does not deliver it again */
+	defrag_send_frag(1, 0x11, 1);
+	ut_asserteq(2, defrag_rx_count);
+
+	/* One datagram too many: the oldest one is dropped */
+	for (i = 0; i <= CONFIG_NET_DEFRAG_SLOTS; i++) {
+		defrag_send_frag(10 + i, 0x30 + i, 0);
+		timer_test_add_offset(1);
+	}
+	for (i = CONFIG_NET_DEFRAG_SLOTS; i >= 0; i--) {
+		defrag_send_frag(10 + i, 0x30 + i, 1);
+		defrag_send_frag(10 + i, 0x30 + i, 2);
+	}
+	ut_asserteq(2 + CONFIG_NET_DEFRAG_SLOTS, defrag_rx_count);
+	ut_assert(defrag_rx_ok);
+
+	/* A datagram that takes too long is dropped */
+	defrag_send_frag(20, 0x40, 0);
+	defrag_send_frag(20, 0x40, 1);
+	timer_test_add_offset(CONFIG_NET_DEFRAG_TIMEOUT + 1);
+	defrag_send_frag(20, 0x40, 2);
+	ut_asserteq(2 + CONFIG_NET_DEFRAG_SLOTS, defrag_rx_count);
+
+	net_set_udp_handler(NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_net_defrag, 0);
+#endif
+
+#ifdef CONFIG_UDP_CHECKSUM
+#define CSUM_TEST_LEN		64
+
+static int csum_rx_count;
+
+static void csum_udp_handler(uchar *pkt, unsigned dport,
+			     struct in_addr sip, unsigned sport,
+			     unsigned len)
+{
+	csum_rx_count++;
+}
+
+/* Inject a UDP datagram whose checksum is wrong */
+static void csum_send_bad(void)
+{
+	uchar pkt[ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + CSUM_TEST_LEN];
+	struct ethernet_hdr *et = (struct ethernet_hdr *)pkt;
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)(pkt + ETHER_HDR_SIZE);
+	int i;
+
+	memcpy(et->et_dest, net_ethaddr, ARP_HLEN);
+	memset(et->et_src, 0x55, ARP_HLEN);
+	et->et_protlen = htons(PROT_IP);
+	for (i = 0; i < CSUM_TEST_LEN; i++)
+		pkt[ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + i] = i;
+	net_set_udp_header((uchar *)ip, net_ip, 1234, 69, CSUM_TEST_LEN);
+	ip->udp_xsum = htons(0x1234);
+
+	net_process_received_packet(pkt, sizeof(pkt));
+}
+
+/* Check that the UDP checksum is not checked again if the hardware did it */
+static int dm_test_net_rx_csum(struct unit_test_state *uts)
+{
+	net_init();
+	net_ip = string_to_ip("1.1.2.2");
+	net_set_udp_handler(csum_udp_handler);
+	csum_rx_count = 0;
+
+	net_rx_csum_valid = false;
+	csum_send_bad();
+	ut_asserteq(0, csum_rx_count);
+
+	net_rx_csum_valid = true;
+	csum_send_bad();
+	ut_asserteq(1, csum_rx_count);
+
+	net_rx_csum_valid = false;
+	net_set_udp_handler(NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_net_rx_csum, 0);
+#endif
@@ -2,6 +2,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <dm/of_access.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
 #include <test/ut.h>
@@ -58,3 +59,60 @@ static int dm_test_ofnode_fmap(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_ofnode_fmap, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that property and phandle lookups agree with a search of the tree */
+static int dm_test_ofnode_live_index(struct unit_test_state *uts)
+{
+	struct device_node *np, *other;
+	struct property *pp, *found;
+	ofnode node;
+	int len;
+
+	if (!of_live_active()) {
+		printf("Live tree not active; ignore test\n");
+		return 0;
+	}
+
+	for (np = of_find_all_nodes(NULL); np; np = of_find_all_nodes(np)) {
+		for (pp = np->properties; pp; pp = pp->next) {
+			for (found = np->properties; strcmp(found->name,
+							    pp->name);
+			     found = found->next)
+				;
+			ut_asserteq_ptr(found, of_find_property(np, pp->name,
+								&len));
+			ut_asserteq(found->length, len);
+		}
+		ut_assertnull(of_find_property(np, "not-a-property", &len));
+		ut_asserteq(-FDT_ERR_NOTFOUND, len);
+
+		if (!np->phandle)
+			continue;
+		for (other = of_find_all_nodes(NULL);
+		     other->phandle != np->phandle;
+		     other = of_find_all_nodes(other))
+			;
+		ut_asserteq_ptr(other, of_find_node_by_phandle(np->phandle));
+	}
+	ut_assertnull(of_find_node_by_phandle(0xfffffff0));
+
+	/* A new property must be found, even if its name is new too */
+	node = ofnode_path("/a-test");
+	ut_assert(ofnode_valid(node));
+	ut_assertnull(ofnode_get_property(node, "u-boot,index-test", NULL));
+	ut_assertok(ofnode_write_prop(node, "u-boot,index-test", 4, "abc"));
+	ut_asserteq_str("abc", ofnode_read_string(node, "u-boot,index-test"));
+	ut_assertok(ofnode_write_prop(node, "u-boot,index-test", 4, "xyz"));
+	ut_asserteq_str("xyz", ofnode_read_string(node, "u-boot,index-test"));
+
+	/* Leave the tree as it was for later tests */
+	ut_assertok(of_remove_prop((struct device_node *)ofnode_to_np(node),
+				   "u-boot,index-test"));
+	ut_assertnull(ofnode_get_property(node, "u-boot,index-test", NULL));
+	ut_asserteq(-ENOENT, of_remove_prop((struct device_node *)
+					    ofnode_to_np(node),
+					    "u-boot,index-test"));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_live_index, DM_TESTF_SCAN_FDT);
@@ -10,6 +10,7 @@
 #include <dm.h>
 #include <errno.h>
 #include <malloc.h>
+#include <time.h>
 #include <dm/test.h>
 #include <test/ut.h>
 #include <asm/io.h>
@@ -157,6 +158,58 @@ U_BOOT_DRIVER(test_pre_reloc_drv) = {
 	.flags	= DM_FLAG_PRE_RELOC,
 };
 
+/* Number of times probe_finish() reports that the device is not ready */
+static int test_async_polls;
+
+static int test_async_probe(struct udevice *dev)
+{
+	test_async_polls = 2;
+
+	return test_manual_probe(dev);
+}
+
+static int test_async_probe_finish(struct udevice *dev)
+{
+	if (test_async_polls) {
+		test_async_polls--;
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+U_BOOT_DRIVER(test_async_drv) = {
+	.name	= "test_async_drv",
+	.id	= UCLASS_TEST,
+	.ops	= &test_manual_ops,
+	.bind	= test_manual_bind,
+	.probe	= test_async_probe,
+	.probe_finish	= test_async_probe_finish,
+	.remove	= test_manual_remove,
+	.unbind	= test_manual_unbind,
+	.flags	= DM_FLAG_PROBE_ASYNC,
+};
+
+/* A device which never becomes ready, each poll taking a while */
+static int test_async_stuck_finish(struct udevice *dev)
+{
+	timer_test_add_offset(100);
+
+	return -EAGAIN;
+}
+
+U_BOOT_DRIVER(test_async_stuck_drv) = {
+	.name	= "test_async_stuck_drv",
+	.id	= UCLASS_TEST,
+	.ops	= &test_manual_ops,
+	.bind	= test_manual_bind,
+	.probe	= test_manual_probe,
+	.probe_finish	= test_async_stuck_finish,
+	.remove	= test_manual_remove,
+	.unbind	= test_manual_unbind,
+	.flags	= DM_FLAG_PROBE_ASYNC,
+};
+
 U_BOOT_DRIVER(test_act_dma_drv) = {
 	.name	= "test_act_dma_drv",
 	.id	= UCLASS_TEST,
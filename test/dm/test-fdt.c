@@ -264,6 +264,110 @@ static int dm_test_fdt_pre_reloc(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdt_pre_reloc, 0);
 
+/* Test looking up drivers by compatible string */
+static int dm_test_fdt_lookup_compat(struct unit_test_state *uts)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id, *match, *found;
+	struct driver *entry, *drv;
+
+	drv = lists_driver_lookup_compat("google,another-fdt-test", &found);
+	ut_assertnonnull(drv);
+	ut_asserteq_str("testfdt_drv", drv->name);
+	ut_asserteq(DM_TEST_TYPE_SECOND, found->data);
+	ut_assertnull(lists_driver_lookup_compat("denx,no-such-driver",
+						 &found));
+
+	/* Each string must give the first driver which has it */
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			drv = lists_driver_lookup_compat(id->compatible,
+							 &found);
+			ut_assertnonnull(drv);
+			ut_assert(drv <= entry);
+			ut_asserteq_str(id->compatible, found->compatible);
+			for (match = drv->of_match; match != found; match++)
+				ut_assert(strcmp(match->compatible,
+						 id->compatible));
+			if (drv == entry)
+				ut_asserteq_ptr(id, found);
+		}
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_lookup_compat, 0);
+
+/* Test finding devices as they are probed, removed and unbound */
+static int dm_test_fdt_uclass_find(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	ofnode node;
+	int seq;
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_TEST_FDT, 3, &dev));
+	ut_asserteq_str("b-test", dev->name);
+	seq = dev->seq;
+	ut_assertok(uclass_find_device_by_seq(UCLASS_TEST_FDT, seq, false,
+					      &found));
+	ut_asserteq_ptr(dev, found);
+	node = dev_ofnode(dev);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_asserteq(-ENODEV, uclass_find_device_by_seq(UCLASS_TEST_FDT, seq,
+						       false, &found));
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  node, &found));
+
+	/* Binding it again makes it visible again */
+	ut_assertok(lists_bind_fdt(dm_root(), node, &dev, false));
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_uclass_find, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test finding a device after its node is changed */
+static int dm_test_fdt_uclass_set_node(struct unit_test_state *uts)
+{
+	struct udevice *dev, *found;
+	ofnode node, other;
+
+	ut_assertok(uclass_get_device_by_seq(UCLASS_TEST_FDT, 3, &dev));
+	node = dev_ofnode(dev);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	other = ofnode_path("/junk");
+	ut_assert(ofnode_valid(other));
+	dev_set_ofnode(dev, other);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, other,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							  node, &found));
+
+	dev_set_ofnode(dev, node);
+	ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+						 &found));
+	ut_asserteq_ptr(dev, found);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_uclass_set_node, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
 /* Test that sequence numbers are allocated properly */
 static int dm_test_fdt_uclass_seq(struct unit_test_state *uts)
 {
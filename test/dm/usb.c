@@ -6,6 +6,7 @@
 #include <common.h>
 #include <console.h>
 #include <dm.h>
+#include <hexdump.h>
 #include <usb.h>
 #include <asm/io.h>
 #include <asm/state.h>
@@ -61,6 +62,149 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
 
+#ifdef CONFIG_USB_STATS
+/*
+ * Test that a large read is sent to the flash stick as one bulk transfer per
+ * SCSI command, and that the transfers are counted on the right endpoints
+ */
+static int dm_test_usb_flash_stats(struct unit_test_state *uts)
+{
+	struct usb_ep_stats in, out, *stats;
+	struct blk_desc *dev_desc;
+	struct usb_device *udev;
+	struct udevice *dev;
+	char *buf;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(blk_get_device_by_str("usb", "0", &dev_desc));
+	udev = dev_get_parent_priv(dev);
+
+	/* The emulated flash stick uses endpoint 1 for OUT and 2 for IN */
+	in = *usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 2));
+	out = *usb_pipe_stats(udev, usb_sndbulkpipe(udev, 1));
+
+	/* 500 blocks need three READ(10) commands of up to 240 blocks */
+	buf = malloc(500 * 512);
+	ut_assertnonnull(buf);
+	ut_asserteq(500, blk_dread(dev_desc, 0, 500, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	free(buf);
+
+	/* Each command has a CBW, then the data and the CSW */
+	stats = usb_pipe_stats(udev, usb_sndbulkpipe(udev, 1));
+	ut_asserteq(out.transfers + 3, stats->transfers);
+	ut_asserteq(out.bytes + 3 * UMASS_BBB_CBW_SIZE, stats->bytes);
+	ut_asserteq(out.errors, stats->errors);
+
+	stats = usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 2));
+	ut_asserteq(in.transfers + 6, stats->transfers);
+	ut_asserteq(in.bytes + 500 * 512 + 3 * UMASS_BBB_CSW_SIZE,
+		    stats->bytes);
+	ut_asserteq(in.errors, stats->errors);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_stats, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
+/* The second flash stick's file appears again at this block */
+#define FLASH_LBA_BASE	0x100000000ULL
+#define FLASH1_BLOCKS	2048
+
+/*
+ * Test a flash stick with more than 2^32 blocks, which needs READ CAPACITY(16),
+ * READ(16) and WRITE(16)
+ */
+static int dm_test_usb_flash_large(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	char cmp[512], orig[512], buf[512];
+	u64 base = FLASH_LBA_BASE;
+	struct udevice *dev;
+
+	if (sizeof(lbaint_t) < sizeof(u64)) {
+		printf("No 64-bit block numbers; ignore test\n");
+		return 0;
+	}
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 1, &dev));
+	ut_assertok(blk_get_device_by_str("usb", "1", &dev_desc));
+	ut_assert(dev_desc->lba == base + FLASH1_BLOCKS);
+
+	/* Block 0 is read with READ(10), its copy with READ(16) */
+	memset(cmp, '\0', sizeof(cmp));
+	ut_asserteq(1, blk_dread(dev_desc, base, 1, cmp));
+	ut_assertok(strcmp(cmp, "this is a large disk"));
+	memset(cmp, '\0', sizeof(cmp));
+	ut_asserteq(1, blk_dread(dev_desc, 0, 1, cmp));
+	ut_assertok(strcmp(cmp, "this is a large disk"));
+
+	/* Write with WRITE(16), then put the block back with WRITE(10) */
+	ut_asserteq(1, blk_dread(dev_desc, 1, 1, orig));
+	memset(buf, 0xa5, sizeof(buf));
+	ut_asserteq(1, blk_dwrite(dev_desc, base + 1, 1, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 1, 1, cmp));
+	ut_asserteq_mem(buf, cmp, sizeof(buf));
+	ut_asserteq(1, blk_dwrite(dev_desc, 1, 1, orig));
+	ut_asserteq(1, blk_dread(dev_desc, base + 1, 1, cmp));
+	ut_asserteq_mem(orig, cmp, sizeof(orig));
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_large, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#if defined(CONFIG_USB_UAS) && defined(CONFIG_USB_STATS)
+/*
+ * Test that the second flash stick is driven with UAS: each command goes on
+ * the command pipe and the status pipe gives a Read Ready IU, then the status
+ */
+static int dm_test_usb_flash_uas(struct unit_test_state *uts)
+{
+	struct usb_ep_stats cmd, status, data, *stats;
+	struct blk_desc *dev_desc;
+	struct usb_device *udev;
+	struct udevice *dev;
+	char buf[1024];
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 1, &dev));
+	ut_assertok(blk_get_device_by_str("usb", "1", &dev_desc));
+	udev = dev_get_parent_priv(dev);
+
+	/* Endpoints 3 and 4 are the command and status pipes */
+	cmd = *usb_pipe_stats(udev, usb_sndbulkpipe(udev, 3));
+	status = *usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 4));
+	data = *usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 5));
+	ut_assert(cmd.transfers);
+
+	memset(buf, '\0', sizeof(buf));
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	ut_assertok(strcmp(buf, "this is a large disk"));
+
+	stats = usb_pipe_stats(udev, usb_sndbulkpipe(udev, 3));
+	ut_asserteq(cmd.transfers + 1, stats->transfers);
+	ut_asserteq(cmd.bytes + UAS_COMMAND_IU_SIZE, stats->bytes);
+	stats = usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 4));
+	ut_asserteq(status.transfers + 2, stats->transfers);
+	ut_asserteq(status.errors, stats->errors);
+
+	/* The data comes on endpoint 5, not the Bulk-Only endpoint 2 */
+	stats = usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 5));
+	ut_asserteq(data.bytes + sizeof(buf), stats->bytes);
+	ut_asserteq(0, usb_pipe_stats(udev, usb_rcvbulkpipe(udev, 2))->bytes);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_uas, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+#endif
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
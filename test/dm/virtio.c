@@ -4,7 +4,10 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
+#include <env.h>
+#include <net.h>
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
@@ -12,7 +15,11 @@
 #include <dm/uclass-internal.h>
 #include <dm/root.h>
 #include <dm/test.h>
+#include <asm/test.h>
 #include <test/ut.h>
+#include "../../drivers/virtio/virtio_net.h"
+
+DECLARE_GLOBAL_DATA_PTR;
 
 /* Basic test of the virtio uclass */
 static int dm_test_virtio_base(struct unit_test_state *uts)
@@ -120,3 +127,121 @@ static int dm_test_virtio_remove(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_virtio_remove, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that a large transfer is split into requests which are batched */
+static int dm_test_virtio_blk_rw(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	struct blk_desc *desc;
+	u8 wbuf[40 * 512], rbuf[40 * 512];
+	int i, kicks;
+
+	ut_assertok(uclass_get_device(UCLASS_VIRTIO, 2, &bus));
+	ut_assertok(device_find_first_child(bus, &dev));
+	ut_assertok(device_probe(dev));
+	desc = dev_get_uclass_platdata(dev);
+	ut_asserteq(64, desc->lba);
+
+	for (i = 0; i < sizeof(wbuf); i++)
+		wbuf[i] = i * 7 + i / 512;
+
+	/*
+	 * Each request has at most four segments of 1KB, so 20KB takes five
+	 * requests. These all fit in the queue using indirect descriptors,
+	 * so the device should be kicked once.
+	 */
+	kicks = sandbox_virtio_blk_get_notify_count(bus);
+	ut_asserteq(40, blk_dwrite(desc, 10, 40, wbuf));
+	ut_asserteq(kicks + 1, sandbox_virtio_blk_get_notify_count(bus));
+
+	memset(rbuf, '\0', sizeof(rbuf));
+	ut_asserteq(40, blk_dread(desc, 10, 40, rbuf));
+	ut_asserteq_mem(wbuf, rbuf, sizeof(rbuf));
+
+	/* An odd start and length read back the same data */
+	memset(rbuf, '\0', sizeof(rbuf));
+	ut_asserteq(13, blk_dread(desc, 13, 13, rbuf));
+	ut_asserteq_mem(wbuf + 3 * 512, rbuf, 13 * 512);
+
+	/* The request past the end of the disk fails, but not the first */
+	ut_asserteq(8, blk_dread(desc, 56, 16, rbuf));
+
+	return 0;
+}
+DM_TEST(dm_test_virtio_blk_rw, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test receiving batches of packets, some in several buffers */
+static int dm_test_virtio_net_rx(struct unit_test_state *uts)
+{
+	static const struct driver_info info = {
+		.name	= "virtio-sandbox-net",
+	};
+	struct udevice *bus, *dev;
+	struct eth_ops *ops;
+	uchar *packets[8];
+	int lengths[8];
+	uint pkt_flags[8];
+	u8 pkt[1518];
+	char name[16];
+	int i;
+
+	ut_assertok(device_bind_by_name(gd->dm_root, false, &info, &bus));
+	ut_assertok(device_probe(bus));
+	ut_assertok(device_find_first_child(bus, &dev));
+	ut_assertok(device_probe(dev));
+	ut_assert(virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF));
+	ops = eth_get_ops(dev);
+	ut_assertok(ops->start(dev));
+
+	for (i = 0; i < sizeof(pkt); i++)
+		pkt[i] = i;
+	ut_assertok(sandbox_virtio_net_rx(bus, pkt, 60,
+					  VIRTIO_NET_HDR_F_DATA_VALID));
+	ut_assertok(sandbox_virtio_net_rx(bus, pkt + 1, 100, 0));
+
+	/* A frame with a VLAN tag does not fit in one buffer */
+	ut_assertok(sandbox_virtio_net_rx(bus, pkt, sizeof(pkt), 0));
+	ut_assertok(sandbox_virtio_net_rx(bus, pkt + 2, 80, 0));
+
+	/* The batch ends with the merged packet */
+	memset(pkt_flags, '\0', sizeof(pkt_flags));
+	ut_asserteq(3, ops->recv_batch(dev, ETH_RECV_CHECK_DEVICE, packets,
+				       lengths, pkt_flags, 8));
+	ut_asserteq(60, lengths[0]);
+	ut_asserteq_mem(pkt, packets[0], 60);
+	ut_asserteq(ETH_PKT_CSUM_VALID, pkt_flags[0]);
+	ut_asserteq(100, lengths[1]);
+	ut_asserteq_mem(pkt + 1, packets[1], 100);
+	ut_asserteq(0, pkt_flags[1]);
+	ut_asserteq(sizeof(pkt), lengths[2]);
+	ut_asserteq_mem(pkt, packets[2], sizeof(pkt));
+	for (i = 0; i < 3; i++)
+		ut_assertok(ops->free_pkt(dev, packets[i], lengths[i]));
+
+	memset(pkt_flags, '\0', sizeof(pkt_flags));
+	ut_asserteq(1, ops->recv_batch(dev, 0, packets, lengths, pkt_flags,
+				       8));
+	ut_asserteq(80, lengths[0]);
+	ut_asserteq_mem(pkt + 2, packets[0], 80);
+	ut_assertok(ops->free_pkt(dev, packets[0], lengths[0]));
+	ut_asserteq(0, ops->recv_batch(dev, 0, packets, lengths, pkt_flags,
+				       8));
+
+	/* All eight buffers are back in the queue */
+	for (i = 0; i < 8; i++)
+		ut_assertok(sandbox_virtio_net_rx(bus, pkt, 60, 0));
+	ut_asserteq(-ENOSPC, sandbox_virtio_net_rx(bus, pkt, 60, 0));
+	ut_asserteq(8, ops->recv_batch(dev, 0, packets, lengths, pkt_flags,
+				       8));
+	for (i = 0; i < 8; i++)
+		ut_assertok(ops->free_pkt(dev, packets[i], lengths[i]));
+
+	/* Leave the environment as it was */
+	sprintf(name, dev->seq ? "eth%daddr" : "ethaddr", dev->seq);
+	env_set(name, NULL);
+	ut_assertok(device_remove(bus, DM_REMOVE_NORMAL));
+	ut_assertok(device_unbind(bus));
+
+	return 0;
+}
+DM_TEST(dm_test_virtio_net_rx, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
@@ -123,3 +123,104 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hashtable well past its initial size, so that it grows */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 8));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 8));
+	ut_asserteq(SIZE * 8, htab.filled);
+	ut_assert(htab.size > SIZE * 8);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Export entries added out of order, after changing and deleting some */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	static const char expect[] = "0=0\0001=one\0003=3\0";
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	char *res = NULL;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, 4));
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = "1";
+	item.data = "one";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(1, hdelete_r("2", &htab, 0));
+
+	ut_asserteq(sizeof(expect),
+		    hexport_r(&htab, '\0', 0, &res, 0, 0, NULL));
+	ut_asserteq_mem(expect, res, sizeof(expect));
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
+
+/* Import only the changes, leaving unchanged entries alone */
+static int env_test_htab_import_incremental(struct unit_test_state *uts)
+{
+	static const char first[] = "a=1\0b=2\0c=3\0";
+	static const char second[] = "b=2\0c=4\0d=5\0";
+	struct hsearch_data htab;
+	struct env_entry item;
+	struct env_entry *ritem;
+	char *data;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, first, sizeof(first), '\0', 0, 0, 0,
+				 NULL));
+	item.callback = NULL;
+	item.flags = 0;
+	item.data = NULL;
+	item.key = "b";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	data = ritem->data;
+
+	ut_asserteq(1, himport_r(&htab, second, sizeof(second), '\0',
+				 H_INCREMENTAL, 0, 0, NULL));
+	ut_asserteq(3, htab.filled);
+
+	item.key = "a";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnull(ritem);
+
+	/* The unchanged value was not copied again */
+	item.key = "b";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_ptr(data, ritem->data);
+
+	item.key = "c";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("4", ritem->data);
+
+	item.key = "d";
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("5", ritem->data);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_import_incremental, 0);
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the environment stored as a log of changes
+ */
+
+#include <common.h>
+#include <command.h>
+#include <env.h>
+#include <env_internal.h>
+#include <test/env.h>
+#include <test/ut.h>
+
+/* Both areas, which behave like flash: writing can only clear bits */
+static u8 env_test_mem[2 * CONFIG_ENV_SIZE];
+static int env_test_erases;
+static ulong env_test_last_write;
+
+static int env_test_read(ulong offset, size_t len, void *buf)
+{
+	if (offset + len > sizeof(env_test_mem))
+		return -EINVAL;
+	memcpy(buf, env_test_mem + offset, len);
+
+	return 0;
+}
+
+static int env_test_write(ulong offset, size_t len, const void *buf)
+{
+	const u8 *src = buf;
+	size_t i;
+
+	if (offset + len > sizeof(env_test_mem))
+		return -EINVAL;
+	for (i = 0; i < len; i++)
+		env_test_mem[offset + i] &= src[i];
+	env_test_last_write = offset;
+
+	return 0;
+}
+
+static int env_test_erase(ulong offset, size_t len)
+{
+	if (offset + len > sizeof(env_test_mem))
+		return -EINVAL;
+	memset(env_test_mem + offset, 0xff, len);
+	env_test_erases++;
+
+	return 0;
+}
+
+static const struct env_log_storage env_test_stor = {
+	.offset	= { 0, CONFIG_ENV_SIZE },
+	.read	= env_test_read,
+	.write	= env_test_write,
+	.erase	= env_test_erase,
+};
+
+/*
+ * Start with the current environment in the usual format, which is converted
+ * by the first save
+ */
+static int env_test_log_setup(struct unit_test_state *uts)
+{
+	memset(env_test_mem, 0xff, sizeof(env_test_mem));
+	ut_assertok(env_export((env_t *)env_test_mem));
+	ut_assertok(env_log_load(&env_test_stor));
+
+	env_test_erases = 0;
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_asserteq(1, env_test_erases);
+
+	return 0;
+}
+
+/* Test that saves append to the log and that loading replays it */
+static int env_test_log_append(struct unit_test_state *uts)
+{
+	ut_assertok(env_test_log_setup(uts));
+
+	ut_assertok(env_set("envlog_a", "1"));
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_assertok(env_set("envlog_a", "2"));
+	ut_assertok(env_set("envlog_b", "3"));
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_assertok(env_set("envlog_a", NULL));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	/* Nothing changed, so nothing is written */
+	env_test_last_write = 0;
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_asserteq(0, env_test_last_write);
+	ut_asserteq(1, env_test_erases);
+
+	ut_assertok(env_set("envlog_a", "4"));
+	ut_assertok(env_set("envlog_b", NULL));
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_assertnull(env_get("envlog_a"));
+	ut_asserteq_str("3", env_get("envlog_b"));
+
+	ut_assertok(env_set("envlog_b", NULL));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	return 0;
+}
+ENV_TEST(env_test_log_append, 0);
+
+/* Test that a record torn by power failure is ignored */
+static int env_test_log_torn(struct unit_test_state *uts)
+{
+	ut_assertok(env_test_log_setup(uts));
+
+	ut_assertok(env_set("envlog_a", "1"));
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_assertok(env_set("envlog_a", "2"));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	/* Clear the first byte of the data, after the length and CRC */
+	env_test_mem[env_test_last_write + 8] = 0;
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_asserteq_str("1", env_get("envlog_a"));
+
+	/* The log cannot be appended to now, so is written out again */
+	ut_assertok(env_set("envlog_a", "3"));
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_asserteq(2, env_test_erases);
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_asserteq_str("3", env_get("envlog_a"));
+
+	ut_assertok(env_set("envlog_a", NULL));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	return 0;
+}
+ENV_TEST(env_test_log_torn, 0);
+
+/* Test that a full log is compacted into the other area */
+static int env_test_log_compact(struct unit_test_state *uts)
+{
+	char value[CONFIG_ENV_SIZE / 8];
+	int i;
+
+	ut_assertok(env_test_log_setup(uts));
+
+	memset(value, 'x', sizeof(value) - 1);
+	value[sizeof(value) - 1] = '\0';
+	for (i = 0; i < 16 && env_test_erases == 1; i++) {
+		value[0] = 'a' + i;
+		ut_assertok(env_set("envlog_a", value));
+		ut_assertok(env_log_save(&env_test_stor));
+	}
+	ut_asserteq(2, env_test_erases);
+
+	/* The older area is still valid, but is not used */
+	ut_assertok(env_set("envlog_a", NULL));
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_asserteq_str(value, env_get("envlog_a"));
+
+	ut_assertok(env_set("envlog_a", NULL));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	return 0;
+}
+ENV_TEST(env_test_log_compact, 0);
+
+/* Test that changes forced past the variable flags are replayed on load */
+static int env_test_log_force(struct unit_test_state *uts)
+{
+	ut_assertok(env_test_log_setup(uts));
+
+	ut_assertok(env_set(".flags", "envlog_a:so"));
+	ut_assertok(env_set("envlog_a", "1"));
+	ut_assertok(env_log_save(&env_test_stor));
+	ut_assertok(run_command("env set -f envlog_a 2", 0));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_asserteq_str("2", env_get("envlog_a"));
+
+	ut_assertok(run_command("env delete -f envlog_a", 0));
+	ut_assertok(env_set(".flags", NULL));
+	ut_assertok(env_log_save(&env_test_stor));
+
+	return 0;
+}
+ENV_TEST(env_test_log_force, 0);
+
+/* Test that deleting many variables in one save is logged */
+static int env_test_log_delete_many(struct unit_test_state *uts)
+{
+	char name[64], value[64];
+	int i;
+
+	ut_assertok(env_test_log_setup(uts));
+
+	/* The deleted names together are much longer than any one variable */
+	memset(value, 'v', sizeof(value) - 1);
+	value[sizeof(value) - 1] = '\0';
+	for (i = 0; i < 32; i++) {
+		snprintf(name, sizeof(name),
+			 "envlog_a_rather_long_variable_name_number_%02d", i);
+		ut_assertok(env_set(name, value));
+	}
+	ut_assertok(env_log_save(&env_test_stor));
+
+	for (i = 0; i < 32; i++) {
+		snprintf(name, sizeof(name),
+			 "envlog_a_rather_long_variable_name_number_%02d", i);
+		ut_assertok(env_set(name, NULL));
+	}
+	ut_assertok(env_log_save(&env_test_stor));
+
+	ut_assertok(env_log_load(&env_test_stor));
+	ut_assertnull(env_get("envlog_a_rather_long_variable_name_number_00"));
+	ut_assertnull(env_get("envlog_a_rather_long_variable_name_number_31"));
+
+	return 0;
+}
+ENV_TEST(env_test_log_delete_many, 0);
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for CRC-32 and CRC-32C
+ *
+ * The table-driven and any architecture-specific versions are checked
+ * against a bit-at-a-time reference, for every length up to a few words
+ * and every alignment, so that all of the head, word and tail paths are
+ * used.
+ */
+
+#include <common.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC_TEST_LEN	1000
+
+static uint32_t crc_test_ref(uint32_t poly, uint32_t crc, const u8 *buf,
+			     uint len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+	}
+
+	return crc;
+}
+
+static void crc_test_pattern(u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < CRC_TEST_LEN; i++)
+		buf[i] = i * 7 + (i >> 8);
+}
+
+static int lib_test_crc32(struct unit_test_state *uts)
+{
+	u8 buf[CRC_TEST_LEN + 8];
+	uint32_t expect;
+	int len, off;
+
+	ut_asserteq(0xcbf43926, crc32(0, (u8 *)"123456789", 9));
+
+	for (off = 0; off < 8; off++) {
+		crc_test_pattern(buf + off);
+		for (len = 0; len <= 80; len++) {
+			expect = crc_test_ref(0xedb88320, 0x12345678,
+					      buf + off, len);
+			ut_asserteq(expect, crc32_no_comp(0x12345678,
+							  buf + off, len));
+			ut_asserteq(expect,
+				    crc32_no_comp_generic(0x12345678,
+							  buf + off, len));
+		}
+
+		expect = crc_test_ref(0xedb88320, ~0, buf + off, CRC_TEST_LEN);
+		ut_asserteq(~expect, crc32(0, buf + off, CRC_TEST_LEN));
+		/* chained from a previous part */
+		ut_asserteq(~expect, crc32(crc32(0, buf + off, 333),
+					   buf + off + 333,
+					   CRC_TEST_LEN - 333));
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32, 0);
+
+#ifdef CONFIG_CRC32C
+static int lib_test_crc32c(struct unit_test_state *uts)
+{
+	u8 buf[CRC_TEST_LEN + 8];
+	uint32_t table[256];
+	uint32_t expect;
+	int len, off;
+
+	ut_asserteq(0xe3069283,
+		    ~crc32c_no_comp(~0, (u8 *)"123456789", 9));
+
+	crc32c_init(table, 0x82f63b78);
+	for (off = 0; off < 8; off++) {
+		crc_test_pattern(buf + off);
+		for (len = 0; len <= 80; len++) {
+			expect = crc_test_ref(0x82f63b78, ~0, buf + off, len);
+			ut_asserteq(expect, crc32c_no_comp(~0, buf + off,
+							   len));
+			ut_asserteq(expect,
+				    crc32c_no_comp_generic(~0, buf + off,
+							   len));
+			ut_asserteq(expect, crc32c_cal(~0, (char *)buf + off,
+						       len, table));
+		}
+
+		expect = crc_test_ref(0x82f63b78, ~0, buf + off, CRC_TEST_LEN);
+		ut_asserteq(expect, crc32c_no_comp(~0, buf + off,
+						   CRC_TEST_LEN));
+	}
+
+	return 0;
+}
+
+LIB_TEST(lib_test_crc32c, 0);
+#endif
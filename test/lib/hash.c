@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the hash algorithms
+ *
+ * Each digest is computed in one go and progressively, in pieces which
+ * straddle the block boundaries, so that both the single-block and the
+ * multi-block paths of the block functions are used.
+ */
+
+#include <common.h>
+#include <hash.h>
+#include <hexdump.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define HASH_TEST_LEN	1000
+
+struct hash_test {
+	const char *algo;
+	const char *abc;	/* digest of "abc" */
+	const char *pattern;	/* digest of hash_test_pattern() */
+};
+
+static const struct hash_test hash_tests[] = {
+	{
+		"sha1",
+		"a9993e364706816aba3e25717850c26c9cd0d89d",
+		"36b3862969aef72235b9f6aadcf795eefeacd183",
+	},
+	{
+		"sha256",
+		"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+		"c85a431e0fe575b2609289d3a4042414715f400612575a125d2ce5573d608732",
+	},
+#ifdef CONFIG_SHA384
+	{
+		"sha384",
+		"cb00753f45a35e8bb5a03d699ac65007272c32ab0eded163"
+		"1a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+		"358033b5fc73409a38b4035ffbbaf3096b7fed43cd5eefe4"
+		"3d779698af2e7e311664ae13f71671d900a7ac835b3553ac",
+	},
+#endif
+#ifdef CONFIG_SHA512
+	{
+		"sha512",
+		"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+		"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+		"d45b2b8a61bd7f9cc388c96f215f3da57c6137d9a0797dfbaf7a54bb3434d80c"
+		"cc29f70962dd572f5c0c1eb400a71aaac73b52503aa6bd3215f1c65598f0cc7e",
+	},
+#endif
+};
+
+static void hash_test_pattern(u8 *buf)
+{
+	int i;
+
+	for (i = 0; i < HASH_TEST_LEN; i++)
+		buf[i] = i * 7 + (i >> 8);
+}
+
+static int hash_test_one(struct unit_test_state *uts,
+			 const struct hash_test *test)
+{
+	static const int pieces[] = { 1, 63, 64, 65, 128, 200 };
+	u8 expect[HASH_MAX_DIGEST_SIZE], digest[HASH_MAX_DIGEST_SIZE];
+	u8 buf[HASH_TEST_LEN + 1];
+	struct hash_algo *algo;
+	int i, pos, len;
+	void *ctx;
+
+	ut_assertok(hash_lookup_algo(test->algo, &algo));
+
+	algo->hash_func_ws((u8 *)"abc", 3, digest, algo->chunk_size);
+	ut_assertok(hex2bin(expect, test->abc, algo->digest_size));
+	ut_assertok(memcmp(expect, digest, algo->digest_size));
+
+	/* with the data one byte off alignment */
+	hash_test_pattern(buf + 1);
+	ut_assertok(hex2bin(expect, test->pattern, algo->digest_size));
+	algo->hash_func_ws(buf + 1, HASH_TEST_LEN, digest, algo->chunk_size);
+	ut_assertok(memcmp(expect, digest, algo->digest_size));
+
+	ut_assertok(algo->hash_init(algo, &ctx));
+	for (i = 0, pos = 0; pos < HASH_TEST_LEN; i++, pos += len) {
+		len = min(pieces[i % ARRAY_SIZE(pieces)], HASH_TEST_LEN - pos);
+		ut_assertok(algo->hash_update(algo, ctx, buf + 1 + pos, len,
+					      pos + len == HASH_TEST_LEN));
+	}
+	memset(digest, '\0', sizeof(digest));
+	ut_assertok(algo->hash_finish(algo, ctx, digest, sizeof(digest)));
+	ut_assertok(memcmp(expect, digest, algo->digest_size));
+
+	return 0;
+}
+
+static int lib_test_hash(struct unit_test_state *uts)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(hash_tests); i++)
+		ut_assertok(hash_test_one(uts, &hash_tests[i]));
+
+	return 0;
+}
+
+LIB_TEST(lib_test_hash, 0);
@@ -19,8 +19,8 @@
 #define MASK 0xA5
 /* Number of different alignment values */
 #define SWEEP 16
-/* Allow for copying up to 32 bytes */
-#define BUFLEN (SWEEP + 33)
+/* Allow for copying up to 160 bytes, past the unrolled loops */
+#define BUFLEN (SWEEP + 161)
 
 /**
  * init_buffer() - initialize buffer
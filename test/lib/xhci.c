@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the XHCI transfer ring helpers
+ *
+ * TDs are queued by hand on a multi-segment ring, the way xhci_bulk_tx()
+ * fills it, so that xhci_td_actual_len() has to follow the link TRBs.
+ */
+
+#include <common.h>
+#include <usb.h>
+#include <usb/xhci.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Queue a TD of @count normal TRBs of @len bytes from @trb, return the last */
+static union xhci_trb *xhci_test_queue(union xhci_trb *trb, int count, int len)
+{
+	union xhci_trb *last = NULL;
+
+	while (count) {
+		if (TRB_TYPE_LINK_LE32(trb->link.control)) {
+			trb = (union xhci_trb *)(uintptr_t)
+				le64_to_cpu(trb->link.segment_ptr);
+			continue;
+		}
+		/* the TD size bits must not be counted as length */
+		trb->generic.field[2] = cpu_to_le32(TRB_LEN(len) | (count << 17) |
+						    TRB_INTR_TARGET(0));
+		trb->generic.field[3] = cpu_to_le32(TRB_TYPE(TRB_NORMAL) |
+						    (count > 1 ? TRB_CHAIN : 0));
+		last = trb++;
+		count--;
+	}
+
+	return last;
+}
+
+/* Fill in a short packet event for @trb which left @residue bytes */
+static void xhci_test_event(union xhci_trb *event, union xhci_trb *trb,
+			    int residue)
+{
+	memset(event, '\0', sizeof(*event));
+	event->trans_event.buffer = cpu_to_le64((uintptr_t)trb);
+	event->trans_event.transfer_len = cpu_to_le32(COMP_SHORT_TX << 24 |
+						      residue);
+}
+
+static int lib_test_xhci_td_len(struct unit_test_state *uts)
+{
+	union xhci_trb *first, *start, *last, event;
+	struct xhci_segment *seg;
+	struct xhci_ring *ring;
+	int i;
+
+	ring = xhci_ring_alloc(BULK_RING_SEGS, true);
+	ut_assertnonnull(ring);
+	first = ring->first_seg->trbs;
+
+	/* a single TRB */
+	last = xhci_test_queue(first, 1, 4096);
+	xhci_test_event(&event, last, 100);
+	ut_asserteq(4096 - 100, xhci_td_actual_len(first, &event));
+
+	/* the short packet lands in the third TRB of the TD */
+	last = xhci_test_queue(first, 3, 65536);
+	ut_asserteq_ptr(&first[2], last);
+	xhci_test_event(&event, last, 1000);
+	ut_asserteq(3 * 65536 - 1000, xhci_td_actual_len(first, &event));
+
+	/* a TD crossing the link TRB into the next segment */
+	start = &first[TRBS_PER_SEGMENT - 4];
+	last = xhci_test_queue(start, 5, 65536);
+	ut_asserteq_ptr(&ring->first_seg->next->trbs[1], last);
+	xhci_test_event(&event, last, 512);
+	ut_asserteq(5 * 65536 - 512, xhci_td_actual_len(start, &event));
+
+	/* a TD wrapping from the last segment back to the first */
+	seg = ring->first_seg;
+	for (i = 1; i < BULK_RING_SEGS; i++)
+		seg = seg->next;
+	ut_asserteq_ptr(ring->first_seg, seg->next);
+	start = &seg->trbs[TRBS_PER_SEGMENT - 3];
+	last = xhci_test_queue(start, 4, 1024);
+	ut_asserteq_ptr(&first[1], last);
+	xhci_test_event(&event, last, 24);
+	ut_asserteq(4 * 1024 - 24, xhci_td_actual_len(start, &event));
+
+	xhci_ring_free(ring);
+
+	return 0;
+}
+LIB_TEST(lib_test_xhci_td_len, 0);
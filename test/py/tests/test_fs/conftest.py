@@ -2,6 +2,7 @@
 # Copyright (c) 2018, Linaro Limited
 # Author: Takahiro Akashi <takahiro.akashi@linaro.org>
 
+import hashlib
 import os
 import os.path
 import pytest
@@ -14,6 +15,7 @@ supported_fs_ext = ['fat16', 'fat32']
 supported_fs_mkdir = ['fat16', 'fat32']
 supported_fs_unlink = ['fat16', 'fat32']
 supported_fs_symlink = ['ext4']
+supported_fs_extent = ['ext4']
 
 #
 # Filesystem test specific setup
@@ -50,6 +52,7 @@ def pytest_configure(config):
     global supported_fs_mkdir
     global supported_fs_unlink
     global supported_fs_symlink
+    global supported_fs_extent
 
     def intersect(listA, listB):
         return  [x for x in listA if x in listB]
@@ -62,6 +65,7 @@ def pytest_configure(config):
         supported_fs_mkdir =  intersect(supported_fs, supported_fs_mkdir)
         supported_fs_unlink =  intersect(supported_fs, supported_fs_unlink)
         supported_fs_symlink =  intersect(supported_fs, supported_fs_symlink)
+        supported_fs_extent =  intersect(supported_fs, supported_fs_extent)
 
 def pytest_generate_tests(metafunc):
     """Parametrize fixtures, fs_obj_xxx
@@ -90,6 +94,9 @@ def pytest_generate_tests(metafunc):
     if 'fs_obj_symlink' in metafunc.fixturenames:
         metafunc.parametrize('fs_obj_symlink', supported_fs_symlink,
             indirect=True, scope='module')
+    if 'fs_obj_extent' in metafunc.fixturenames:
+        metafunc.parametrize('fs_obj_extent', supported_fs_extent,
+            indirect=True, scope='module')
 
 #
 # Helper functions
@@ -600,3 +607,94 @@ def fs_obj_symlink(request, u_boot_config):
         call('rmdir %s' % mount_dir, shell=True)
         if fs_img:
             call('rm -f %s' % fs_img, shell=True)
+
+#
+# Fixture for extent fs test
+#
+# NOTE: yield_fixture was deprecated since pytest-3.0
+@pytest.yield_fixture()
+def fs_obj_extent(request, u_boot_config):
+    """Set up a file system to be used in extent fs test.
+
+    The fragmented file has one extent per EXTENT_CHUNK of data with a
+    hole after each, more than fit in one extent leaf block. The
+    preallocated file has an unwritten extent over blocks that held
+    data before.
+
+    Args:
+        request: Pytest request object.
+        u_boot_config: U-boot configuration.
+
+    Return:
+        A fixture for extent fs test, i.e. a triplet of file system type,
+        volume file name and a list of MD5 hashes.
+    """
+    fs_type = request.param
+    fs_img = ''
+
+    fs_ubtype = fstype_to_ubname(fs_type)
+    check_ubconfig(u_boot_config, fs_ubtype)
+
+    mount_dir = u_boot_config.persistent_data_dir + '/mnt'
+
+    frag_file = mount_dir + '/' + FRAG_FILE
+    prealloc_file = mount_dir + '/' + PREALLOC_FILE
+    stale_file = mount_dir + '/stale.file'
+
+    try:
+
+        # 128MiB volume
+        fs_img = mk_fs(u_boot_config, fs_type, 0x8000000, '128MB')
+
+        # Mount the image so we can populate it.
+        check_call('mkdir -p %s' % mount_dir, shell=True)
+        mount_fs(fs_type, fs_img, mount_dir)
+
+        # Write every other chunk of the fragmented file, leaving holes
+        data = bytearray(EXTENT_COUNT * EXTENT_CHUNK * 2)
+        with open(frag_file, 'wb') as f:
+            for i in range(EXTENT_COUNT):
+                chunk = os.urandom(EXTENT_CHUNK)
+                offset = i * EXTENT_CHUNK * 2
+                data[offset:offset + EXTENT_CHUNK] = chunk
+                f.seek(offset)
+                f.write(chunk)
+            # Make the file end with a hole
+            f.truncate(len(data))
+
+        # Fill some blocks with data and free them again, so that the
+        # unwritten extent is likely to land on blocks with stale data
+        check_call('dd if=/dev/urandom of=%s bs=1M count=4'
+            % stale_file, shell=True)
+        check_call('sync; rm %s; sync' % stale_file, shell=True)
+
+        # A file with data, then an unwritten extent, then data again
+        check_call('dd if=/dev/urandom of=%s bs=1M count=1'
+            % prealloc_file, shell=True)
+        check_call('fallocate -o 1M -l 2M %s' % prealloc_file, shell=True)
+        check_call('dd if=/dev/urandom of=%s bs=1M count=1 seek=3'
+            ' conv=notrunc' % prealloc_file, shell=True)
+
+        # The whole fragmented file, then a range that crosses several
+        # leaf blocks and starts and ends inside a chunk
+        md5val = [hashlib.md5(data).hexdigest()]
+        md5val.append(hashlib.md5(
+            data[EXTENT_OFFSET:EXTENT_OFFSET + EXTENT_LENGTH]).hexdigest())
+
+        # The preallocated file, whose middle must read as zeroes
+        out = check_output(
+            'dd if=%s bs=1M count=4 2> /dev/null | md5sum'
+            % prealloc_file, shell=True).decode()
+        md5val.append(out.split()[0])
+
+        umount_fs(mount_dir)
+    except CalledProcessError:
+        pytest.skip('Setup failed for filesystem: ' + fs_type)
+        return
+    else:
+        yield [fs_ubtype, fs_img, md5val]
+    finally:
+        umount_fs(mount_dir)
+        call('rmdir %s' % mount_dir, shell=True)
+        if fs_img:
+            call('rm -f %s' % fs_img, shell=True)
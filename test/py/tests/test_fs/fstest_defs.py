@@ -12,5 +12,18 @@ MEDIUM_FILE='10MB.file'
 # $BIG_FILE is the name of the 2.5GB file in the file system image
 BIG_FILE='2.5GB.file'
 
+# $FRAG_FILE is the name of a file with many extents separated by holes
+FRAG_FILE='frag.file'
+EXTENT_CHUNK=4096
+EXTENT_COUNT=1000
+# A range of $FRAG_FILE which starts and ends inside a chunk
+EXTENT_OFFSET=0x1ff800
+EXTENT_LENGTH=0x180000
+
+# $PREALLOC_FILE is the name of a 4MB file with an unwritten extent
+PREALLOC_FILE='prealloc.file'
+
 ADDR=0x01000008
+# $ADDR2 is a second buffer for comparing data with the one at $ADDR
+ADDR2=0x01800008
 LENGTH=0x00100000
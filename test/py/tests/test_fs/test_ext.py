@@ -317,3 +317,29 @@ class TestFsExt(object):
             assert('FILE0123456789_79' in output)
 
             assert_fs_integrity(fs_type, fs_img)
+
+    def test_fs_ext12(self, u_boot_console, fs_obj_ext):
+        """
+        Test Case 12 - write and read back a file whose cluster chain
+        spans several FAT sectors
+        """
+        fs_type,fs_img,md5val = fs_obj_ext
+        with u_boot_console.log.section('Test Case 12 - write a large file'):
+            # Test Case 12a - Check if command successfully returned
+            # Give each 256KB piece its own pattern
+            u_boot_console.run_command('host bind 0 %s' % fs_img)
+            for i in range(0, 16):
+                u_boot_console.run_command('mw.b %x %x 0x40000'
+                    % (ADDR + i * 0x40000, i + 1))
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /dir1/bigfile 0x400000'
+                    % (fs_type, ADDR))
+            assert('4194304 bytes written' in output)
+
+            # Test Case 12b - Check the file content
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /dir1/bigfile' % (fs_type, ADDR2),
+                'cmp.b %x %x 0x400000' % (ADDR, ADDR2),
+                'setenv filesize'])
+            assert('Total of 4194304 byte(s) were the same' in ''.join(output))
+            assert_fs_integrity(fs_type, fs_img)
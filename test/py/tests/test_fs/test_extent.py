@@ -0,0 +1,70 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System:Extent Test
+
+"""
+This test verifies reading files whose data is mapped by many extents,
+holes and unwritten extents.
+"""
+
+import pytest
+from fstest_defs import *
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.slow
+class TestFsExtent(object):
+    def test_fs_extent1(self, u_boot_console, fs_obj_extent):
+        """
+        Test Case 1 - read a whole file with more extents than a leaf holds
+        """
+        fs_type,fs_img,md5val = fs_obj_extent
+        with u_boot_console.log.section('Test Case 1 - read fragmented file'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'mw.b %x ff %x' % (ADDR, EXTENT_CHUNK * 2),
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, FRAG_FILE),
+                'printenv filesize'])
+            assert('filesize=%x' % (EXTENT_COUNT * EXTENT_CHUNK * 2)
+                in ''.join(output))
+
+            output = u_boot_console.run_command_list([
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[0] in ''.join(output))
+
+    def test_fs_extent2(self, u_boot_console, fs_obj_extent):
+        """
+        Test Case 2 - read a range crossing leaf blocks, starting and
+        ending inside an extent
+        """
+        fs_type,fs_img,md5val = fs_obj_extent
+        with u_boot_console.log.section('Test Case 2 - read across leaves'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                '%sload host 0:0 %x /%s %x %x' % (fs_type, ADDR, FRAG_FILE,
+                    EXTENT_LENGTH, EXTENT_OFFSET),
+                'printenv filesize'])
+            assert('filesize=%x' % EXTENT_LENGTH in ''.join(output))
+
+            output = u_boot_console.run_command_list([
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[1] in ''.join(output))
+
+    def test_fs_extent3(self, u_boot_console, fs_obj_extent):
+        """
+        Test Case 3 - an unwritten extent reads as zeroes
+        """
+        fs_type,fs_img,md5val = fs_obj_extent
+        with u_boot_console.log.section('Test Case 3 - read unwritten extent'):
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'mw.b %x ff 400000' % ADDR,
+                '%sload host 0:0 %x /%s' % (fs_type, ADDR, PREALLOC_FILE),
+                'printenv filesize'])
+            assert('filesize=400000' in ''.join(output))
+
+            output = u_boot_console.run_command_list([
+                'md5sum %x $filesize' % ADDR,
+                'setenv filesize'])
+            assert(md5val[2] in ''.join(output))
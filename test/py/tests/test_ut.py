@@ -1,8 +1,11 @@
 # SPDX-License-Identifier: GPL-2.0
 # Copyright (c) 2016, NVIDIA CORPORATION. All rights reserved.
 
+import glob
 import os.path
+import shutil
 import pytest
+import u_boot_utils as util
 
 @pytest.mark.buildconfigspec('ut_dm')
 def test_ut_dm_init(u_boot_console):
@@ -15,6 +18,13 @@ def test_ut_dm_init(u_boot_console):
         with open(fn, 'wb') as fh:
             fh.write(data)
 
+    fn = u_boot_console.config.source_dir + '/testflash1.bin'
+    if not os.path.exists(fn):
+        data = b'this is a large disk'
+        data += b'\x00' * ((1024 * 1024) - len(data))
+        with open(fn, 'wb') as fh:
+            fh.write(data)
+
     fn = u_boot_console.config.source_dir + '/spi.bin'
     if not os.path.exists(fn):
         data = b'\x00' * (2 * 1024 * 1024)
@@ -26,3 +36,50 @@ def test_ut(u_boot_console, ut_subtest):
 
     output = u_boot_console.run_command('ut ' + ut_subtest)
     assert output.endswith('Failures: 0')
+
+# Size of the text decompressed by 'ut compression bench'
+BENCH_SIZE = 512 * 1024
+
+# File extension and host command for each format in the benchmark
+BENCH_TOOLS = (
+    ('gz', 'gzip -9 -n'),
+    ('bz2', 'bzip2 -9'),
+    ('lzma', 'xz --format=lzma -9'),
+    ('lzo', 'lzop -9'),
+    ('lz4', 'lz4 -9'),
+    ('zst', 'zstd -19'),
+)
+
+@pytest.mark.boardspec('sandbox')
+def test_ut_compression_bench(u_boot_console):
+    """Measure decompression speed on text compressed by the host tools.
+
+    The text is the start of the READMEs in doc/. Formats whose tool is not
+    installed are skipped.
+    """
+    cons = u_boot_console
+    path = cons.config.persistent_data_dir + '/compression_bench'
+    text = path + '/text'
+    if not os.path.exists(text):
+        if not os.path.exists(path):
+            os.mkdir(path)
+        data = b''
+        for fname in sorted(glob.glob(cons.config.source_dir +
+                                      '/doc/README.*')):
+            if len(data) >= BENCH_SIZE:
+                break
+            with open(fname, 'rb') as fh:
+                data += fh.read()
+        with open(text, 'wb') as fh:
+            fh.write(data[:BENCH_SIZE])
+
+    for ext, cmd in BENCH_TOOLS:
+        out = '%s.%s' % (text, ext)
+        if os.path.exists(out) or not shutil.which(cmd.split()[0]):
+            continue
+        util.run_and_log(cons, ['sh', '-c', '%s -c <%s >%s' %
+                                (cmd, text, out)])
+
+    output = cons.run_command('ut compression bench ' + path)
+    assert 'failed' not in output
+    assert 'Cannot' not in output